@@ -0,0 +1,357 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_bench.c
+* @brief Latency benchmark for cy_smartcoex_config() on the host simulation port.
+*
+* Reports per-stage latency (validate, VSC send, Wi-Fi ioctl) and the
+* sustained config-update rate. With -g, exits non-zero when the p99 of the
+* end-to-end latency exceeds the given budget so it can gate a release.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_hostsim.h"
+#include "cy_smartcoex_stats.h"
+#include "cy_smartcoex_log.h"
+#include "cy_smartcoex_trace.h"
+#include "cy_result_mw.h"
+
+#define BENCH_DEFAULT_ITERATIONS    100000
+
+typedef enum
+{
+    BENCH_STAGE_VALIDATE = 0,
+    BENCH_STAGE_VSC,
+    BENCH_STAGE_WIFI,
+    BENCH_STAGE_TOTAL,
+    BENCH_STAGE_MAX
+} bench_stage_t;
+
+static const char *bench_stage_name[BENCH_STAGE_MAX] = { "validate", "vsc_send", "wifi_ioctl", "total" };
+
+typedef struct
+{
+    uint64_t *samples;
+    uint32_t count;
+} bench_series_t;
+
+static void bench_vsc_complete(wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params)
+{
+    (void)p_command_complete_params;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t bench_percentile(const bench_series_t *series, uint32_t pct)
+{
+    uint32_t idx;
+
+    if(series->count == 0)
+    {
+        return 0;
+    }
+    idx = (uint32_t)(((uint64_t)(series->count - 1U) * pct) / 100U);
+    return series->samples[idx];
+}
+
+#ifdef ENABLE_SMARTCOEX_STATS
+/* Prints the library's own view of the same run, as a dashboard would see it */
+static void bench_print_library_stats(void)
+{
+    static const char *stage_name[CY_SMARTCOEX_STATS_STAGE_MAX] = { "validate", "vsc_send", "vsc_complete", "wifi_ioctl", "config", "applied" };
+    cy_smartcoex_stats_t stats;
+    int stage;
+
+    if(cy_smartcoex_stats_get(&stats) != CY_RSLT_SUCCESS)
+    {
+        return;
+    }
+
+    printf("library stats (us)    samples        p50        p99        max\n");
+    for(stage = 0; stage < CY_SMARTCOEX_STATS_STAGE_MAX; stage++)
+    {
+        printf("  %-16s %10u %10u %10u %10u\n", stage_name[stage], (unsigned int)stats.stage[stage].count,
+               (unsigned int)cy_smartcoex_stats_percentile(&stats.stage[stage], 50),
+               (unsigned int)cy_smartcoex_stats_percentile(&stats.stage[stage], 99),
+               (unsigned int)stats.stage[stage].max_us);
+    }
+    printf("  results: success=%u busy=%u error=%u badarg=%u\n",
+           (unsigned int)stats.result[CY_SMARTCOEX_STATS_RESULT_SUCCESS], (unsigned int)stats.result[CY_SMARTCOEX_STATS_RESULT_BUSY],
+           (unsigned int)stats.result[CY_SMARTCOEX_STATS_RESULT_ERROR], (unsigned int)stats.result[CY_SMARTCOEX_STATS_RESULT_BADARG]);
+}
+#endif
+
+/* Writes the binary log records still held by the ring, for cy_smartcoex_logdecode */
+static void bench_write_log(const char *path)
+{
+#ifdef ENABLE_SMARTCOEX_BINARY_LOGS
+    cy_smartcoex_binlog_record_t records[32];
+    uint32_t cursor = 0;
+    uint32_t count;
+    FILE *f = fopen(path, "wb");
+
+    if(f == NULL)
+    {
+        perror(path);
+        return;
+    }
+    while((count = cy_smartcoex_binlog_read(&cursor, records, 32, NULL)) != 0)
+    {
+        fwrite(records, sizeof(records[0]), count, f);
+    }
+    fclose(f);
+#else
+    fprintf(stderr, "%s not written: build with LOGS=binary\n", path);
+#endif
+}
+
+/* Writes the trace records written since cursor to f, for cy_smartcoex_trace_replay */
+static void bench_write_trace(FILE *f, uint32_t *cursor)
+{
+#ifdef ENABLE_SMARTCOEX_TRACE
+    cy_smartcoex_trace_record_t records[32];
+    uint8_t buf[CY_SMARTCOEX_TRACE_RECORD_SIZE];
+    uint32_t count;
+    uint32_t i;
+
+    while((count = cy_smartcoex_trace_read(cursor, records, 32, NULL)) != 0)
+    {
+        for(i = 0; i < count; i++)
+        {
+            cy_smartcoex_trace_encode(&records[i], buf);
+            fwrite(buf, 1, sizeof(buf), f);
+        }
+    }
+#else
+    (void)f;
+    (void)cursor;
+#endif
+}
+
+static void bench_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -n <count>  number of config updates (default %d)\n"
+           "  -v <us>     simulated VSC send latency\n"
+           "  -c <us>     simulated VSC completion latency\n"
+           "  -a          deliver VSC completions asynchronously\n"
+           "  -m <us>     simulated WHD interface lookup latency\n"
+           "  -w <us>     simulated WHD coex ioctl latency\n"
+           "  -p <count>  consecutive updates sharing one scan priority (default 1)\n"
+           "  -s <count>  consecutive updates sharing one scan interval/window (default 1)\n"
+           "  -g <us>     fail if total p99 exceeds this budget\n"
+           "  -L <file>   write the binary log records to file (LOGS=binary builds)\n"
+           "  -T <file>   write the coex trace to file (TRACE=1 builds)\n", prog, BENCH_DEFAULT_ITERATIONS);
+}
+
+int main(int argc, char **argv)
+{
+    cy_smartcoex_hostsim_config_t sim_config;
+    cy_smartcoex_hostsim_stats_t before, after;
+    cy_smartcoex_wifi_config_t wifi_config;
+    cy_smartcoex_bt_config_t bt_config;
+    bench_series_t series[BENCH_STAGE_MAX];
+    uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+    uint32_t priority_run = 1;
+    uint32_t scan_run = 1;
+    uint64_t gate_us = 0;
+    const char *log_path = NULL;
+    FILE *trace = NULL;
+    uint8_t trace_header[CY_SMARTCOEX_TRACE_HEADER_SIZE];
+    uint32_t trace_cursor = 0;
+    uint32_t trace_scale = 1000000U;
+    uint64_t start_ns, t0, t1;
+    uint32_t failures = 0;
+    uint32_t i;
+    int opt;
+    int stage;
+
+    memset(&sim_config, 0, sizeof(sim_config));
+    while((opt = getopt(argc, argv, "n:v:c:am:w:p:s:g:L:T:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': iterations = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'v': sim_config.vsc_latency_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': sim_config.vsc_complete_latency_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'a': sim_config.vsc_async_complete = true; break;
+            case 'm': sim_config.wcm_latency_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'w': sim_config.wifi_latency_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'p': priority_run = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': scan_run = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'g': gate_us = strtoull(optarg, NULL, 0); break;
+            case 'L': log_path = optarg; break;
+            case 'T':
+#ifdef ENABLE_SMARTCOEX_TRACE
+                trace = fopen(optarg, "wb");
+                if(trace == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+#else
+                fprintf(stderr, "%s not written: build with TRACE=1\n", optarg);
+#endif
+                break;
+            default:
+                bench_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if(iterations == 0 || priority_run == 0 || scan_run == 0)
+    {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    for(stage = 0; stage < BENCH_STAGE_MAX; stage++)
+    {
+        series[stage].count   = 0;
+        series[stage].samples = malloc(sizeof(uint64_t) * iterations);
+        if(series[stage].samples == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    if(cy_smartcoex_hostsim_init(&sim_config) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "cy_smartcoex_hostsim_init failed\n");
+        return 1;
+    }
+
+    memset(&bt_config, 0, sizeof(bt_config));
+    wifi_config.interface = CY_SMARTCOEX_INTERFACE_TYPE_STA;
+    bt_config.btcoex_cb   = bench_vsc_complete;
+
+    if(trace != NULL)
+    {
+#ifdef ENABLE_SMARTCOEX_TRACE
+        (void)cy_smartcoex_trace_read(&trace_cursor, NULL, 0, &trace_scale);
+#endif
+        cy_smartcoex_trace_encode_header(trace_scale, trace_header);
+        fwrite(trace_header, 1, sizeof(trace_header), trace);
+    }
+
+    start_ns = cy_smartcoex_hostsim_now_ns();
+    for(i = 0; i < iterations; i++)
+    {
+        /* Walk all priorities and a spread of scan parameters, as a BLE layer retuning its scan would */
+        bt_config.scan_priority = (cy_smartcoex_lescan_priority_t)((i / priority_run) % 3U);
+        bt_config.scan_int      = (uint16_t)(16U + (((i / scan_run) % 64U) * 4U));
+        bt_config.scan_win      = (uint16_t)(bt_config.scan_int / 2U);
+
+        cy_smartcoex_hostsim_get_stats(&before);
+        t0 = cy_smartcoex_hostsim_now_ns();
+        if(cy_smartcoex_config(&wifi_config, &bt_config) != CY_RSLT_SUCCESS)
+        {
+            failures++;
+        }
+        t1 = cy_smartcoex_hostsim_now_ns();
+        cy_smartcoex_hostsim_get_stats(&after);
+
+        series[BENCH_STAGE_TOTAL].samples[series[BENCH_STAGE_TOTAL].count++] = t1 - t0;
+        if(after.vsc_calls != before.vsc_calls)
+        {
+            series[BENCH_STAGE_VALIDATE].samples[series[BENCH_STAGE_VALIDATE].count++] = after.vsc_enter_ns - t0;
+            series[BENCH_STAGE_VSC].samples[series[BENCH_STAGE_VSC].count++] = after.vsc_exit_ns - after.vsc_enter_ns;
+        }
+        if(after.wifi_calls != before.wifi_calls)
+        {
+            series[BENCH_STAGE_WIFI].samples[series[BENCH_STAGE_WIFI].count++] = after.wifi_exit_ns - after.wifi_enter_ns;
+        }
+        if(trace != NULL && (i % 256U) == 255U)
+        {
+            bench_write_trace(trace, &trace_cursor);
+        }
+    }
+    t1 = cy_smartcoex_hostsim_now_ns();
+
+    cy_smartcoex_hostsim_wait_idle();
+    cy_smartcoex_hostsim_deinit();
+    if(trace != NULL)
+    {
+        bench_write_trace(trace, &trace_cursor);
+        fclose(trace);
+    }
+
+    printf("cy_smartcoex_config: %u updates, %u failed, %.0f updates/s\n",
+           (unsigned int)iterations, (unsigned int)failures,
+           (double)iterations * 1e9 / (double)(t1 - start_ns));
+    printf("%-12s %10s %10s %10s %10s %10s\n", "stage(ns)", "samples", "min", "p50", "p99", "max");
+    for(stage = 0; stage < BENCH_STAGE_MAX; stage++)
+    {
+        qsort(series[stage].samples, series[stage].count, sizeof(uint64_t), bench_compare);
+        printf("%-12s %10u %10llu %10llu %10llu %10llu\n", bench_stage_name[stage], (unsigned int)series[stage].count,
+               (unsigned long long)bench_percentile(&series[stage], 0),
+               (unsigned long long)bench_percentile(&series[stage], 50),
+               (unsigned long long)bench_percentile(&series[stage], 99),
+               (unsigned long long)bench_percentile(&series[stage], 100));
+    }
+
+#ifdef ENABLE_SMARTCOEX_STATS
+    bench_print_library_stats();
+#endif
+
+    if(log_path != NULL)
+    {
+        bench_write_log(log_path);
+    }
+
+    if(gate_us != 0 && bench_percentile(&series[BENCH_STAGE_TOTAL], 99) > gate_us * 1000ULL)
+    {
+        printf("FAIL: total p99 exceeds %llu us budget\n", (unsigned long long)gate_us);
+        return 1;
+    }
+
+    for(stage = 0; stage < BENCH_STAGE_MAX; stage++)
+    {
+        free(series[stage].samples);
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_log.h
+* @brief Host stand-in for the connectivity-utilities cy-log interface.
+*/
+
+#ifndef INCLUDED_HOSTSIM_CY_LOG_H_
+#define INCLUDED_HOSTSIM_CY_LOG_H_
+
+#include "cy_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    CYLF_DEF = 0,
+    CYLF_TEST,
+    CYLF_EXAMPLE,
+    CYLF_LINK,
+    CYLF_TRANSPORT,
+    CYLF_MIDDLEWARE,
+    CYLF_AUDIO,
+    CYLF_MAX
+} CY_LOG_FACILITY_T;
+
+typedef enum
+{
+    CY_LOG_OFF = 0,
+    CY_LOG_ERR,
+    CY_LOG_WARNING,
+    CY_LOG_NOTICE,
+    CY_LOG_INFO,
+    CY_LOG_DEBUG,
+    CY_LOG_DEBUG1,
+    CY_LOG_DEBUG2,
+    CY_LOG_DEBUG3,
+    CY_LOG_DEBUG4,
+    CY_LOG_MAX
+} CY_LOG_LEVEL_T;
+
+cy_rslt_t cy_log_msg(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDED_HOSTSIM_CY_LOG_H_ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cyabs_rtos.h
+* @brief Host stand-in for the subset of the RTOS abstraction used by the
+* Smart Coex library, implemented on POSIX threads.
+*/
+
+#ifndef INCLUDED_HOSTSIM_CYABS_RTOS_H_
+#define INCLUDED_HOSTSIM_CYABS_RTOS_H_
+
+#include <pthread.h>
+
+#include "cy_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_RTOS_NEVER_TIMEOUT              ((cy_time_t)0xffffffffUL)
+
+#define CY_RSLT_MODULE_ABSTRACTION_OS      (0x0100U)
+#define CY_RTOS_TIMEOUT                    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 0)
+#define CY_RTOS_NO_MEMORY                  CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 1)
+#define CY_RTOS_GENERAL_ERROR              CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 2)
+#define CY_RTOS_BAD_PARAM                  CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 5)
+
+typedef uint32_t cy_time_t;
+typedef void *cy_thread_arg_t;
+typedef void (*cy_thread_entry_fn_t)(cy_thread_arg_t arg);
+
+typedef enum
+{
+    CY_RTOS_PRIORITY_MIN         = 0,
+    CY_RTOS_PRIORITY_LOW         = 1,
+    CY_RTOS_PRIORITY_BELOWNORMAL = 2,
+    CY_RTOS_PRIORITY_NORMAL      = 3,
+    CY_RTOS_PRIORITY_ABOVENORMAL = 4,
+    CY_RTOS_PRIORITY_HIGH        = 5,
+    CY_RTOS_PRIORITY_REALTIME    = 6,
+    CY_RTOS_PRIORITY_MAX         = 7
+} cy_thread_priority_t;
+
+typedef struct
+{
+    pthread_t            thread;
+    cy_thread_entry_fn_t entry;
+    cy_thread_arg_t      arg;
+} *cy_thread_t;
+
+typedef pthread_mutex_t cy_mutex_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint32_t        count;
+    uint32_t        maxcount;
+} cy_semaphore_t;
+
+typedef enum
+{
+    CY_TIMER_TYPE_PERIODIC,
+    CY_TIMER_TYPE_ONCE
+} cy_timer_trigger_type_t;
+
+typedef void *cy_timer_callback_arg_t;
+typedef void (*cy_timer_callback_t)(cy_timer_callback_arg_t arg);
+
+typedef struct cy_hostsim_timer *cy_timer_t;
+
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread, cy_thread_entry_fn_t entry_function, const char *name, void *stack,
+                                uint32_t stack_size, cy_thread_priority_t priority, cy_thread_arg_t arg);
+cy_rslt_t cy_rtos_exit_thread(void);
+cy_rslt_t cy_rtos_join_thread(cy_thread_t *thread);
+
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex);
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex, cy_time_t timeout_ms);
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex);
+cy_rslt_t cy_rtos_deinit_mutex(cy_mutex_t *mutex);
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore, uint32_t maxcount, uint32_t initcount);
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore, cy_time_t timeout_ms, bool in_isr);
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore, bool in_isr);
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore);
+
+cy_rslt_t cy_rtos_init_timer(cy_timer_t *timer, cy_timer_trigger_type_t type, cy_timer_callback_t fun, cy_timer_callback_arg_t arg);
+cy_rslt_t cy_rtos_start_timer(cy_timer_t *timer, cy_time_t num_ms);
+cy_rslt_t cy_rtos_stop_timer(cy_timer_t *timer);
+cy_rslt_t cy_rtos_deinit_timer(cy_timer_t *timer);
+
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval);
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDED_HOSTSIM_CYABS_RTOS_H_ */
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file whd_types.h
+* @brief Host stand-in for the subset of the WHD types used by the Smart
+* Coex library.
+*/
+
+#ifndef INCLUDED_HOSTSIM_WHD_TYPES_H_
+#define INCLUDED_HOSTSIM_WHD_TYPES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t whd_result_t;
+
+#define WHD_SUCCESS                        ((whd_result_t)0)
+#define WHD_TIMEOUT                        ((whd_result_t)0x0401000EU)
+#define WHD_BADARG                         ((whd_result_t)0x04010005U)
+#define WHD_INTERFACE_NOT_UP               ((whd_result_t)0x04010408U)
+
+typedef struct whd_interface *whd_interface_t;
+
+/** LE scan coex parameters */
+typedef struct whd_btc_lescan_params
+{
+    uint16_t priority;
+    uint16_t duty_cycle;
+    uint16_t max_win;
+    uint16_t int_grant;
+    uint16_t scan_int;
+    uint16_t scan_win;
+} whd_btc_lescan_params_t;
+
+/** Wi-Fi counters (subset) */
+typedef struct
+{
+    uint16_t version;
+    uint16_t length;
+    uint32_t txframe;
+    uint32_t txbyte;
+    uint32_t txretrans;
+    uint32_t txerror;
+    uint32_t rxframe;
+    uint32_t rxbyte;
+} whd_counters_t;
+
+/** Coex configuration */
+typedef struct whd_coex_config
+{
+    whd_btc_lescan_params_t le_scan_params;
+} whd_coex_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDED_HOSTSIM_WHD_TYPES_H_ */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file wiced_bt_dev.h
+* @brief Host stand-in for the subset of the BTSTACK device management API
+* used by the Smart Coex library.
+*/
+
+#ifndef INCLUDED_HOSTSIM_WICED_BT_DEV_H_
+#define INCLUDED_HOSTSIM_WICED_BT_DEV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint16_t wiced_result_t;
+
+#define WICED_BT_SUCCESS                   ((wiced_result_t)0x0000)
+#define WICED_BT_ERROR                     ((wiced_result_t)0x8001)
+#define WICED_BT_PENDING                   ((wiced_result_t)0x8104)
+#define WICED_BT_BUSY                      ((wiced_result_t)0x8105)
+#define WICED_BT_NO_RESOURCES              ((wiced_result_t)0x8106)
+#define WICED_BT_UNSUPPORTED               ((wiced_result_t)0x8107)
+#define WICED_BT_ILLEGAL_VALUE             ((wiced_result_t)0x8108)
+
+/** Vendor specific command complete parameters */
+typedef struct
+{
+    uint16_t    opcode;         /**< Vendor specific command opcode */
+    uint8_t     param_len;      /**< Return parameter length */
+    uint8_t     *p_param_buf;   /**< Return parameters; first byte is the HCI status */
+} wiced_bt_dev_vendor_specific_command_complete_params_t;
+
+/** Vendor specific command complete callback */
+typedef void (wiced_bt_dev_vendor_specific_command_complete_cback_t) (wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params);
+
+wiced_result_t wiced_bt_dev_vendor_specific_command(uint16_t opcode, uint8_t param_len, uint8_t *p_param_buf,
+                                                    wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDED_HOSTSIM_WICED_BT_DEV_H_ */
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_linuxctl.c
+* @brief Applies a Smart Coex configuration through the Linux port.
+*
+* Against real radios, sends the coex VSC to hciN and sets btc_lescan_params
+* on the WLAN interface, then prints what the radios report back. With -l,
+* runs a self-test against the loopback stand-ins instead: a sequence of
+* commits, an HCI failure the async worker must roll the WLAN side back for,
+* and a WLAN failure that must keep the VSC from being sent.
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_linux.h"
+
+/* How long to wait for a VSC completion */
+#define LINUXCTL_COMPLETE_TIMEOUT_S     (2)
+
+/* HCI opcode of the LE scan coex VSC */
+#define LINUXCTL_HCI_OPCODE_BTCX_LESCAN (0xFDB1U)
+
+static pthread_mutex_t linuxctl_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  linuxctl_cond  = PTHREAD_COND_INITIALIZER;
+static uint32_t        linuxctl_completions;
+static uint8_t         linuxctl_status;
+
+static void linuxctl_bt_cb(wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params)
+{
+    pthread_mutex_lock(&linuxctl_mutex);
+    linuxctl_status = (p_command_complete_params->param_len > 0) ? p_command_complete_params->p_param_buf[0] : 0xFF;
+    linuxctl_completions++;
+    pthread_cond_signal(&linuxctl_cond);
+    pthread_mutex_unlock(&linuxctl_mutex);
+}
+
+/* Waits until @p count completions have arrived in total; returns the HCI status of the last one, -1 on timeout */
+static int linuxctl_wait(uint32_t count)
+{
+    struct timespec deadline;
+    int status = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += LINUXCTL_COMPLETE_TIMEOUT_S;
+
+    pthread_mutex_lock(&linuxctl_mutex);
+    while(linuxctl_completions < count && status == 0)
+    {
+        status = pthread_cond_timedwait(&linuxctl_cond, &linuxctl_mutex, &deadline);
+    }
+    status = (linuxctl_completions < count) ? -1 : linuxctl_status;
+    pthread_mutex_unlock(&linuxctl_mutex);
+
+    return status;
+}
+
+/* Waits until the WLAN stand-in runs the given scan interval and window */
+static bool linuxctl_wait_lescan(uint16_t scan_int, uint16_t scan_win)
+{
+    cy_smartcoex_linux_loopback_state_t state;
+    uint32_t waited_ms;
+
+    for(waited_ms = 0; waited_ms < LINUXCTL_COMPLETE_TIMEOUT_S * 1000U; waited_ms++)
+    {
+        cy_smartcoex_linux_loopback_get_state(&state);
+        if(state.lescan.scan_int == scan_int && state.lescan.scan_win == scan_win)
+        {
+            return true;
+        }
+        usleep(1000);
+    }
+
+    return false;
+}
+
+static int linuxctl_check(bool ok, const char *what)
+{
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    return ok ? 0 : 1;
+}
+
+static int linuxctl_selftest(void)
+{
+    cy_smartcoex_wifi_config_t wifi_config = { CY_SMARTCOEX_INTERFACE_TYPE_STA };
+    cy_smartcoex_bt_config_t bt_config = { .scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_LOW, .scan_int = 96, .scan_win = 48,
+                                           .btcoex_cb = linuxctl_bt_cb };
+    cy_smartcoex_linux_loopback_state_t state;
+    cy_smartcoex_readback_t readback;
+    uint32_t commands;
+    cy_rslt_t result;
+    int failed = 0;
+
+    /* A plain commit reaches both stand-ins */
+    result = cy_smartcoex_config(&wifi_config, &bt_config);
+    failed += linuxctl_check(result == CY_RSLT_SUCCESS && linuxctl_wait(1) == 0, "commit LOW 96/48 completes");
+    cy_smartcoex_linux_loopback_get_state(&state);
+    failed += linuxctl_check(state.hci_commands == 1 && state.last_opcode == LINUXCTL_HCI_OPCODE_BTCX_LESCAN,
+                             "coex VSC sent on the vendor OGF");
+    failed += linuxctl_check(state.wl_sets == 1 && state.lescan.scan_int == 96 && state.lescan.scan_win == 48,
+                             "btc_lescan_params set on the WLAN interface");
+
+    /* The live config reads back through WLC_GET_VAR */
+    result = cy_smartcoex_readback(&wifi_config, 0, &readback);
+    failed += linuxctl_check(readback.wifi_config_valid && readback.wifi_config_match, "btc_lescan_params reads back");
+
+    /* A failed VSC rolls the WLAN side back to the last committed config, off the HCI reader thread */
+    failed += linuxctl_check(cy_smartcoex_async_init(NULL, NULL) == CY_RSLT_SUCCESS, "async worker started");
+    cy_smartcoex_linux_loopback_inject_hci_status(0x0C, 1);
+    bt_config.scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_HIGH;
+    bt_config.scan_int      = 160;
+    bt_config.scan_win      = 80;
+    /* The stand-in may answer before the commit returns, which then reports the failure itself */
+    (void)cy_smartcoex_config(&wifi_config, &bt_config);
+    failed += linuxctl_check(linuxctl_wait(2) == 0x0C, "HCI status 0x0C reported");
+    failed += linuxctl_check(linuxctl_wait_lescan(96, 48), "WLAN side rolled back");
+    (void)cy_smartcoex_async_deinit();
+
+    /* The same config goes through once the controller accepts it */
+    result = cy_smartcoex_config(&wifi_config, &bt_config);
+    failed += linuxctl_check(result == CY_RSLT_SUCCESS && linuxctl_wait(3) == 0, "commit HIGH 160/80 completes");
+    cy_smartcoex_linux_loopback_get_state(&state);
+    failed += linuxctl_check(state.lescan.scan_int == 160 && state.lescan.scan_win == 80, "WLAN side applied");
+
+    /* A WLAN failure fails the commit before the VSC is sent */
+    commands = state.hci_commands;
+    cy_smartcoex_linux_loopback_inject_wl_error(-5, 1);
+    bt_config.scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM;
+    bt_config.scan_int      = 200;
+    bt_config.scan_win      = 100;
+    result = cy_smartcoex_config(&wifi_config, &bt_config);
+    cy_smartcoex_linux_loopback_get_state(&state);
+    failed += linuxctl_check(result != CY_RSLT_SUCCESS && state.hci_commands == commands && state.lescan.scan_int == 160,
+                             "WLAN error fails the commit, no VSC sent");
+
+    printf("%s: %d check(s) failed\n", (failed == 0) ? "PASS" : "FAIL", failed);
+
+    return (failed == 0) ? 0 : 1;
+}
+
+static int linuxctl_apply(cy_smartcoex_bt_config_t *bt_config)
+{
+    cy_smartcoex_wifi_config_t wifi_config = { CY_SMARTCOEX_INTERFACE_TYPE_STA };
+    cy_smartcoex_readback_t readback;
+    cy_rslt_t result;
+    int status;
+
+    result = cy_smartcoex_config(&wifi_config, bt_config);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "commit failed: 0x%08lx\n", (unsigned long)result);
+        return 1;
+    }
+    status = linuxctl_wait(1);
+    if(status != 0)
+    {
+        fprintf(stderr, (status < 0) ? "no VSC completion\n" : "VSC failed with HCI status 0x%02X\n", (unsigned int)status);
+        return 1;
+    }
+
+    if(cy_smartcoex_readback(&wifi_config, 0, &readback) == CY_RSLT_SUCCESS && readback.wifi_config_valid)
+    {
+        printf("btc_lescan_params: priority=%u duty=%u max_win=%u grant=%u int=%u win=%u%s\n",
+               readback.wifi_config.le_scan_params.priority, readback.wifi_config.le_scan_params.duty_cycle,
+               readback.wifi_config.le_scan_params.max_win, readback.wifi_config.le_scan_params.int_grant,
+               readback.wifi_config.le_scan_params.scan_int, readback.wifi_config.le_scan_params.scan_win,
+               readback.wifi_config_match ? "" : " (differs from the commit)");
+    }
+
+    return 0;
+}
+
+static void linuxctl_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -l          self-test against the loopback stand-ins\n"
+           "  -d <n>      BT controller hciN (default 0)\n"
+           "  -s <ifname> STA interface (default wlan0)\n"
+           "  -a <ifname> soft AP interface (default none)\n"
+           "  -p <prio>   scan priority: 0 low, 1 medium, 2 high (default 0)\n"
+           "  -i <slots>  scan interval (default 96)\n"
+           "  -w <slots>  scan window (default 48)\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    cy_smartcoex_linux_config_t config = { .hci_dev = 0, .sta_ifname = "wlan0" };
+    cy_smartcoex_bt_config_t bt_config = { .scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_LOW, .scan_int = 96, .scan_win = 48,
+                                           .btcoex_cb = linuxctl_bt_cb };
+    int opt;
+    int rc;
+
+    while((opt = getopt(argc, argv, "ld:s:a:p:i:w:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'l': config.loopback = true; break;
+            case 'd': config.hci_dev = (uint16_t)atoi(optarg); break;
+            case 's': config.sta_ifname = optarg; break;
+            case 'a': config.ap_ifname = optarg; break;
+            case 'p': bt_config.scan_priority = (cy_smartcoex_lescan_priority_t)atoi(optarg); break;
+            case 'i': bt_config.scan_int = (uint16_t)atoi(optarg); break;
+            case 'w': bt_config.scan_win = (uint16_t)atoi(optarg); break;
+            default:
+                linuxctl_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    /* The stand-ins serve any name; lo has the sysfs statistics the Wi-Fi counters are read from */
+    if(config.loopback)
+    {
+        config.sta_ifname = "lo";
+    }
+
+    if(cy_smartcoex_linux_init(&config) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "port init failed\n");
+        return 1;
+    }
+
+    rc = config.loopback ? linuxctl_selftest() : linuxctl_apply(&bt_config);
+
+    cy_smartcoex_linux_deinit();
+
+    return rc;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include <string.h>
+
+#include "cy_smartcoex_sim.h"
+#include "cy_result_mw.h"
+
+/* Scan parameter range, as validated by the library */
+#define SIM_SCAN_RANGE_LOW      4
+#define SIM_SCAN_RANGE_HIGH     16384
+
+static uint32_t sim_rand(uint32_t *state)
+{
+    /* xorshift32 */
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+/* Sets bits [start, end) */
+static void sim_set_range(uint64_t *mask, uint32_t start, uint32_t end)
+{
+    uint32_t sw, ew, w;
+    uint64_t smask, emask;
+
+    if(start >= end)
+    {
+        return;
+    }
+
+    sw    = start >> 6;
+    ew    = (end - 1U) >> 6;
+    smask = ~0ULL << (start & 63U);
+    emask = ~0ULL >> (63U - ((end - 1U) & 63U));
+
+    if(sw == ew)
+    {
+        mask[sw] |= smask & emask;
+        return;
+    }
+
+    mask[sw] |= smask;
+    for(w = sw + 1U; w < ew; w++)
+    {
+        mask[w] = ~0ULL;
+    }
+    mask[ew] |= emask;
+}
+
+static bool sim_test(const uint64_t *mask, uint32_t bit)
+{
+    return ((mask[bit >> 6] >> (bit & 63U)) & 1ULL) != 0ULL;
+}
+
+static void sim_build_wifi(cy_smartcoex_sim_t *sim, const cy_smartcoex_sim_wifi_model_t *wifi)
+{
+    uint32_t state = (wifi->seed != 0U) ? wifi->seed : 0x9E3779B9U;
+    uint32_t burst = (wifi->burst_slots != 0U) ? wifi->burst_slots : 1U;
+    uint32_t gap;
+    uint32_t t = 0;
+    uint32_t len;
+
+    memset(sim->wifi, 0, sim->words * sizeof(uint64_t));
+
+    if(wifi->load_percent >= 100U)
+    {
+        sim_set_range(sim->wifi, 0, sim->horizon_slots);
+        return;
+    }
+    if(wifi->load_percent == 0U)
+    {
+        return;
+    }
+
+    gap = (burst * (100U - wifi->load_percent)) / wifi->load_percent;
+    if(gap == 0U)
+    {
+        gap = 1U;
+    }
+
+    /* Start at a random point of the busy/idle cycle */
+    t = sim_rand(&state) % (burst + gap);
+    while(t < sim->horizon_slots)
+    {
+        len = 1U + (sim_rand(&state) % (2U * burst - 1U));
+        sim_set_range(sim->wifi, t, (t + len < sim->horizon_slots) ? t + len : sim->horizon_slots);
+        t += len;
+        t += 1U + (sim_rand(&state) % (2U * gap - 1U));
+    }
+}
+
+static void sim_build_scan(cy_smartcoex_sim_t *sim, const cy_smartcoex_profile_t *profile,
+                           uint32_t scan_int, uint32_t scan_win, cy_smartcoex_sim_result_t *result)
+{
+    uint32_t eff_int = scan_int;
+    uint32_t eff_win = scan_win;
+    uint32_t high_slots;
+    uint32_t window = 0;
+    uint32_t grant = (profile->small_interval_grant != 0U) ? profile->small_interval_grant : 1U;
+    bool small_interval = (scan_int < profile->max_scan_window);
+    uint32_t t;
+    uint32_t end;
+
+    if(eff_win > profile->max_scan_window)
+    {
+        eff_int = (uint32_t)(((uint64_t)scan_int * profile->max_scan_window) / scan_win);
+        eff_win = profile->max_scan_window;
+        if(eff_int < eff_win)
+        {
+            eff_int = eff_win;
+        }
+    }
+    result->eff_scan_int = (uint16_t)eff_int;
+    result->eff_scan_win = (uint16_t)eff_win;
+
+    high_slots = ((eff_win * profile->duty_cycle) + 50U) / 100U;
+
+    memset(sim->scan, 0, sim->words * sizeof(uint64_t));
+    memset(sim->high, 0, sim->words * sizeof(uint64_t));
+
+    for(t = 0; t < sim->horizon_slots; t += eff_int, window++)
+    {
+        end = (t + eff_win < sim->horizon_slots) ? t + eff_win : sim->horizon_slots;
+        sim_set_range(sim->scan, t, end);
+
+        if(small_interval)
+        {
+            if((window % grant) == (grant - 1U))
+            {
+                sim_set_range(sim->high, t, end);
+            }
+        }
+        else
+        {
+            sim_set_range(sim->high, t, (t + high_slots < end) ? t + high_slots : end);
+        }
+    }
+}
+
+static void sim_discovery(cy_smartcoex_sim_t *sim, const cy_smartcoex_sim_adv_model_t *adv, cy_smartcoex_sim_result_t *result)
+{
+    uint32_t state = (adv->seed != 0U) ? adv->seed : 0x2545F491U;
+    uint32_t found = 0;
+    uint64_t sum = 0;
+    uint32_t p, t, i, j, v;
+
+    for(p = 0; p < adv->phases; p++)
+    {
+        for(t = (p * adv->interval_slots) / adv->phases; t < sim->horizon_slots;
+            t += adv->interval_slots + (sim_rand(&state) % (adv->delay_max_slots + 1U)))
+        {
+            if(sim_test(sim->rx, t))
+            {
+                sim->latency[found++] = t;
+                sum += t;
+                break;
+            }
+        }
+    }
+
+    result->discovery_probability     = (float)found / (float)adv->phases;
+    result->discovery_latency_mean_ms = 0.0f;
+    result->discovery_latency_p95_ms  = 0.0f;
+    if(found == 0U)
+    {
+        return;
+    }
+
+    /* Insertion sort; found is bounded by CY_SMARTCOEX_SIM_MAX_PHASES */
+    for(i = 1; i < found; i++)
+    {
+        v = sim->latency[i];
+        for(j = i; j > 0U && sim->latency[j - 1U] > v; j--)
+        {
+            sim->latency[j] = sim->latency[j - 1U];
+        }
+        sim->latency[j] = v;
+    }
+
+    result->discovery_latency_mean_ms = ((float)sum / (float)found) * ((float)CY_SMARTCOEX_SIM_SLOT_US / 1000.0f);
+    result->discovery_latency_p95_ms  = (float)sim->latency[((found - 1U) * 95U) / 100U] * ((float)CY_SMARTCOEX_SIM_SLOT_US / 1000.0f);
+}
+
+cy_rslt_t cy_smartcoex_sim_init(cy_smartcoex_sim_t *sim, uint32_t horizon_slots)
+{
+    if(sim == NULL || horizon_slots < 64U || horizon_slots > CY_SMARTCOEX_SIM_MAX_SLOTS)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    sim->horizon_slots = horizon_slots;
+    sim->words         = (horizon_slots + 63U) / 64U;
+    sim->wifi_cached   = false;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_sim_run(cy_smartcoex_sim_t *sim, const cy_smartcoex_bt_config_t *bt_config,
+                               const cy_smartcoex_profile_t *profile, const cy_smartcoex_sim_wifi_model_t *wifi,
+                               const cy_smartcoex_sim_adv_model_t *adv, cy_smartcoex_sim_result_t *result)
+{
+    cy_smartcoex_profile_t resolved;
+    uint64_t tail;
+    uint64_t contended;
+    uint32_t wifi_demand, wifi_granted, scheduled, received;
+    uint32_t w;
+
+    if(sim == NULL || bt_config == NULL || wifi == NULL || adv == NULL || result == NULL || sim->words == 0U)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(bt_config->scan_int < SIM_SCAN_RANGE_LOW || bt_config->scan_int > SIM_SCAN_RANGE_HIGH ||
+       bt_config->scan_win < SIM_SCAN_RANGE_LOW || bt_config->scan_win > bt_config->scan_int ||
+       wifi->load_percent > 100U || adv->interval_slots == 0U ||
+       adv->phases == 0U || adv->phases > CY_SMARTCOEX_SIM_MAX_PHASES)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(profile == NULL)
+    {
+        if(cy_smartcoex_get_profile(bt_config->scan_priority, &resolved) != CY_RSLT_SUCCESS)
+        {
+            return CY_RSLT_MW_BADARG;
+        }
+        profile = &resolved;
+    }
+    if(profile->max_scan_window < SIM_SCAN_RANGE_LOW || profile->duty_cycle > 100U)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    /* Sweeps typically hold the traffic model fixed; only regenerate when it changes */
+    if(!sim->wifi_cached || memcmp(&sim->wifi_model, wifi, sizeof(*wifi)) != 0)
+    {
+        sim_build_wifi(sim, wifi);
+        sim->wifi_model  = *wifi;
+        sim->wifi_cached = true;
+    }
+
+    sim_build_scan(sim, profile, bt_config->scan_int, bt_config->scan_win, result);
+
+    wifi_demand  = 0;
+    wifi_granted = 0;
+    scheduled    = 0;
+    received     = 0;
+    tail = ((sim->horizon_slots & 63U) != 0U) ? (~0ULL >> (64U - (sim->horizon_slots & 63U))) : ~0ULL;
+    for(w = 0; w < sim->words; w++)
+    {
+        if(w == sim->words - 1U)
+        {
+            sim->scan[w] &= tail;
+            sim->high[w] &= tail;
+            sim->wifi[w] &= tail;
+        }
+        contended  = sim->scan[w] & sim->high[w];
+        sim->rx[w] = sim->scan[w] & (sim->high[w] | ~sim->wifi[w]);
+
+        wifi_demand  += (uint32_t)__builtin_popcountll(sim->wifi[w]);
+        wifi_granted += (uint32_t)__builtin_popcountll(sim->wifi[w] & ~contended);
+        scheduled    += (uint32_t)__builtin_popcountll(sim->scan[w]);
+        received     += (uint32_t)__builtin_popcountll(sim->rx[w]);
+    }
+
+    result->wifi_airtime_share = (float)wifi_granted / (float)sim->horizon_slots;
+    result->wifi_demand_served = (wifi_demand != 0U) ? (float)wifi_granted / (float)wifi_demand : 1.0f;
+    result->ble_scan_coverage  = (float)received / (float)sim->horizon_slots;
+    result->ble_scan_denied    = (scheduled != 0U) ? (float)(scheduled - received) / (float)scheduled : 0.0f;
+
+    sim_discovery(sim, adv, result);
+
+    return CY_RSLT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_sim.h
+* @brief Slot-accurate host model of LE scan vs. Wi-Fi airtime under Smart Coex.
+*
+* The model follows the le_scan_param semantics of the library:
+*  - A scan window above the profile's max scan window is readjusted to
+*    max_scan_window, and the scan interval is scaled by the same ratio so the
+*    scan duty is preserved.
+*  - When the scan interval is smaller than max_scan_window, every
+*    small_interval_grant'th window is given high priority in full.
+*  - Otherwise, the first duty_cycle percent of every window is given high
+*    priority.
+*
+* Each slot (0.625 ms) is arbitrated as follows: a high-priority scan slot
+* always goes to BT; a low-priority scan slot goes to Wi-Fi if Wi-Fi has
+* traffic, otherwise to BT; all other slots go to Wi-Fi. Slots are processed
+* 64 at a time as bitmasks, so a single configuration over a 10 s horizon
+* evaluates in a few microseconds.
+*
+* Advertiser discovery is sampled over evenly spaced advertiser phases. An
+* advertising event covers all three primary channels within one slot, and is
+* received if BT is actually scanning in that slot.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_SIM_H_
+#define INCLUDED_CY_SMARTCOEX_SIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/** Longest simulated horizon, in slots (about 41 s) */
+#define CY_SMARTCOEX_SIM_MAX_SLOTS          (65536U)
+
+/** Maximum number of sampled advertiser phases */
+#define CY_SMARTCOEX_SIM_MAX_PHASES         (256U)
+
+/** Slot duration in microseconds */
+#define CY_SMARTCOEX_SIM_SLOT_US            (625U)
+
+/**
+ * Wi-Fi traffic model. Traffic alternates between busy bursts and idle gaps
+ * whose lengths are drawn from a seeded generator, so the same model always
+ * produces the same slot pattern.
+ */
+typedef struct
+{
+    uint8_t  load_percent;         /**< Share of slots in which Wi-Fi wants the medium, 0-100. */
+    uint16_t burst_slots;          /**< Mean length of a busy burst, in slots. */
+    uint32_t seed;                 /**< Generator seed. */
+} cy_smartcoex_sim_wifi_model_t;
+
+/**
+ * Advertiser model.
+ */
+typedef struct
+{
+    uint16_t interval_slots;       /**< Advertising interval, in slots. */
+    uint16_t delay_max_slots;      /**< Maximum random advDelay added to each event, in slots (16 = 10 ms). */
+    uint16_t phases;               /**< Number of advertiser phases sampled, 1-CY_SMARTCOEX_SIM_MAX_PHASES. */
+    uint32_t seed;                 /**< Generator seed for advDelay. */
+} cy_smartcoex_sim_adv_model_t;
+
+/**
+ * Simulation result.
+ */
+typedef struct
+{
+    uint16_t eff_scan_int;               /**< Scan interval after readjustment, in slots. */
+    uint16_t eff_scan_win;               /**< Scan window after readjustment, in slots. */
+    float    wifi_airtime_share;         /**< Share of all slots granted to Wi-Fi. */
+    float    wifi_demand_served;         /**< Share of Wi-Fi-demanded slots granted to Wi-Fi. */
+    float    ble_scan_coverage;          /**< Share of all slots in which BT actually scans. */
+    float    ble_scan_denied;            /**< Share of scheduled scan slots lost to Wi-Fi. */
+    float    discovery_probability;      /**< Share of advertiser phases discovered within the horizon. */
+    float    discovery_latency_mean_ms;  /**< Mean discovery latency of the discovered phases. */
+    float    discovery_latency_p95_ms;   /**< 95th percentile discovery latency of the discovered phases. */
+} cy_smartcoex_sim_result_t;
+
+/**
+ * Simulation workspace. Large; allocate statically or on the heap. A
+ * workspace is not thread safe; use one per thread.
+ */
+typedef struct
+{
+    uint32_t horizon_slots;
+    uint32_t words;
+    bool     wifi_cached;
+    cy_smartcoex_sim_wifi_model_t wifi_model;
+    uint64_t scan[CY_SMARTCOEX_SIM_MAX_SLOTS / 64U];
+    uint64_t high[CY_SMARTCOEX_SIM_MAX_SLOTS / 64U];
+    uint64_t wifi[CY_SMARTCOEX_SIM_MAX_SLOTS / 64U];
+    uint64_t rx[CY_SMARTCOEX_SIM_MAX_SLOTS / 64U];
+    uint32_t latency[CY_SMARTCOEX_SIM_MAX_PHASES];
+} cy_smartcoex_sim_t;
+
+/**
+ * Initializes a workspace.
+ *
+ * @param[in]  sim            : Workspace.
+ * @param[in]  horizon_slots  : Simulated duration in slots, 64-CY_SMARTCOEX_SIM_MAX_SLOTS.
+ *
+ * @return status             : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid arguments.
+ */
+cy_rslt_t cy_smartcoex_sim_init(cy_smartcoex_sim_t *sim, uint32_t horizon_slots);
+
+/**
+ * Simulates one configuration.
+ *
+ * @param[in]  sim        : Workspace.
+ * @param[in]  bt_config  : Scan interval and window to simulate. btcoex_cb is ignored.
+ * @param[in]  profile    : Profile to simulate, or NULL to use the default context's profile for bt_config->scan_priority.
+ * @param[in]  wifi       : Wi-Fi traffic model.
+ * @param[in]  adv        : Advertiser model.
+ * @param[out] result     : Receives the result.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid arguments.
+ */
+cy_rslt_t cy_smartcoex_sim_run(cy_smartcoex_sim_t *sim, const cy_smartcoex_bt_config_t *bt_config,
+                               const cy_smartcoex_profile_t *profile, const cy_smartcoex_sim_wifi_model_t *wifi,
+                               const cy_smartcoex_sim_adv_model_t *adv, cy_smartcoex_sim_result_t *result);
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* ifndef INCLUDED_CY_SMARTCOEX_SIM_H_ */
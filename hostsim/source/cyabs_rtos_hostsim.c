@@ -0,0 +1,370 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cyabs_rtos_hostsim.c
+* @brief POSIX threads implementation of the RTOS abstraction subset used by
+* the host build.
+*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cyabs_rtos.h"
+
+struct cy_hostsim_timer
+{
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    pthread_t               thread;
+    cy_timer_trigger_type_t type;
+    cy_timer_callback_t     fun;
+    cy_timer_callback_arg_t arg;
+    uint64_t                due_ms;
+    cy_time_t               period_ms;
+    bool                    armed;
+    bool                    exit;
+};
+
+static uint64_t hostsim_rtos_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000ULL) + ((uint64_t)ts.tv_nsec / 1000000ULL);
+}
+
+static void hostsim_rtos_deadline(struct timespec *ts, cy_time_t timeout_ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec  += (time_t)(timeout_ms / 1000U);
+    ts->tv_nsec += (long)(timeout_ms % 1000U) * 1000000L;
+    if(ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *hostsim_rtos_thread_entry(void *arg)
+{
+    cy_thread_t thread = (cy_thread_t)arg;
+
+    thread->entry(thread->arg);
+    return NULL;
+}
+
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread, cy_thread_entry_fn_t entry_function, const char *name, void *stack,
+                                uint32_t stack_size, cy_thread_priority_t priority, cy_thread_arg_t arg)
+{
+    (void)name;
+    (void)stack;
+    (void)stack_size;
+    (void)priority;
+
+    if(thread == NULL || entry_function == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+
+    *thread = malloc(sizeof(**thread));
+    if(*thread == NULL)
+    {
+        return CY_RTOS_NO_MEMORY;
+    }
+    (*thread)->entry = entry_function;
+    (*thread)->arg   = arg;
+
+    if(pthread_create(&(*thread)->thread, NULL, hostsim_rtos_thread_entry, *thread) != 0)
+    {
+        free(*thread);
+        *thread = NULL;
+        return CY_RTOS_GENERAL_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_exit_thread(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_join_thread(cy_thread_t *thread)
+{
+    if(thread == NULL || *thread == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+
+    pthread_join((*thread)->thread, NULL);
+    free(*thread);
+    *thread = NULL;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex, cy_time_t timeout_ms)
+{
+    struct timespec ts;
+
+    if(timeout_ms == CY_RTOS_NEVER_TIMEOUT)
+    {
+        pthread_mutex_lock(mutex);
+        return CY_RSLT_SUCCESS;
+    }
+
+    hostsim_rtos_deadline(&ts, timeout_ms);
+    return (pthread_mutex_timedlock(mutex, &ts) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_TIMEOUT;
+}
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_mutex(cy_mutex_t *mutex)
+{
+    pthread_mutex_destroy(mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore, uint32_t maxcount, uint32_t initcount)
+{
+    pthread_mutex_init(&semaphore->mutex, NULL);
+    pthread_cond_init(&semaphore->cond, NULL);
+    semaphore->count    = initcount;
+    semaphore->maxcount = maxcount;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore, cy_time_t timeout_ms, bool in_isr)
+{
+    struct timespec ts;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    (void)in_isr;
+
+    hostsim_rtos_deadline(&ts, (timeout_ms == CY_RTOS_NEVER_TIMEOUT) ? 0U : timeout_ms);
+
+    pthread_mutex_lock(&semaphore->mutex);
+    while(semaphore->count == 0)
+    {
+        if(timeout_ms == CY_RTOS_NEVER_TIMEOUT)
+        {
+            pthread_cond_wait(&semaphore->cond, &semaphore->mutex);
+        }
+        else if(pthread_cond_timedwait(&semaphore->cond, &semaphore->mutex, &ts) == ETIMEDOUT)
+        {
+            result = CY_RTOS_TIMEOUT;
+            break;
+        }
+    }
+    if(result == CY_RSLT_SUCCESS)
+    {
+        semaphore->count--;
+    }
+    pthread_mutex_unlock(&semaphore->mutex);
+
+    return result;
+}
+
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore, bool in_isr)
+{
+    (void)in_isr;
+
+    pthread_mutex_lock(&semaphore->mutex);
+    if(semaphore->count < semaphore->maxcount)
+    {
+        semaphore->count++;
+    }
+    pthread_cond_signal(&semaphore->cond);
+    pthread_mutex_unlock(&semaphore->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore)
+{
+    pthread_cond_destroy(&semaphore->cond);
+    pthread_mutex_destroy(&semaphore->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+static void *hostsim_rtos_timer_thread(void *arg)
+{
+    struct cy_hostsim_timer *timer = (struct cy_hostsim_timer *)arg;
+    struct timespec ts;
+    uint64_t now;
+
+    pthread_mutex_lock(&timer->mutex);
+    while(!timer->exit)
+    {
+        if(!timer->armed)
+        {
+            pthread_cond_wait(&timer->cond, &timer->mutex);
+            continue;
+        }
+
+        now = hostsim_rtos_now_ms();
+        if(now < timer->due_ms)
+        {
+            hostsim_rtos_deadline(&ts, (cy_time_t)(timer->due_ms - now));
+            pthread_cond_timedwait(&timer->cond, &timer->mutex, &ts);
+            continue;
+        }
+
+        if(timer->type == CY_TIMER_TYPE_PERIODIC)
+        {
+            timer->due_ms += timer->period_ms;
+        }
+        else
+        {
+            timer->armed = false;
+        }
+
+        pthread_mutex_unlock(&timer->mutex);
+        timer->fun(timer->arg);
+        pthread_mutex_lock(&timer->mutex);
+    }
+    pthread_mutex_unlock(&timer->mutex);
+
+    return NULL;
+}
+
+cy_rslt_t cy_rtos_init_timer(cy_timer_t *timer, cy_timer_trigger_type_t type, cy_timer_callback_t fun, cy_timer_callback_arg_t arg)
+{
+    struct cy_hostsim_timer *t;
+
+    if(timer == NULL || fun == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+
+    t = calloc(1, sizeof(*t));
+    if(t == NULL)
+    {
+        return CY_RTOS_NO_MEMORY;
+    }
+    pthread_mutex_init(&t->mutex, NULL);
+    pthread_cond_init(&t->cond, NULL);
+    t->type = type;
+    t->fun  = fun;
+    t->arg  = arg;
+
+    if(pthread_create(&t->thread, NULL, hostsim_rtos_timer_thread, t) != 0)
+    {
+        free(t);
+        return CY_RTOS_GENERAL_ERROR;
+    }
+    *timer = t;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_start_timer(cy_timer_t *timer, cy_time_t num_ms)
+{
+    struct cy_hostsim_timer *t = *timer;
+
+    pthread_mutex_lock(&t->mutex);
+    t->period_ms = (num_ms == 0U) ? 1U : num_ms;
+    t->due_ms    = hostsim_rtos_now_ms() + num_ms;
+    t->armed     = true;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_stop_timer(cy_timer_t *timer)
+{
+    struct cy_hostsim_timer *t = *timer;
+
+    pthread_mutex_lock(&t->mutex);
+    t->armed = false;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_timer(cy_timer_t *timer)
+{
+    struct cy_hostsim_timer *t = *timer;
+
+    pthread_mutex_lock(&t->mutex);
+    t->exit = true;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+
+    pthread_join(t->thread, NULL);
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->mutex);
+    free(t);
+    *timer = NULL;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval)
+{
+    *tval = (cy_time_t)hostsim_rtos_now_ms();
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = (time_t)(num_ms / 1000U);
+    ts.tv_nsec = (long)(num_ms % 1000U) * 1000000L;
+    nanosleep(&ts, NULL);
+
+    return CY_RSLT_SUCCESS;
+}
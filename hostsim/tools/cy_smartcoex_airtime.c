@@ -0,0 +1,159 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_airtime.c
+* @brief Command-line front end of the airtime simulator.
+*
+* Simulates one configuration, or with -s sweeps scan interval/window over
+* the valid range and reports the evaluation rate.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cy_smartcoex_sim.h"
+
+static cy_smartcoex_sim_t sim;
+
+static void airtime_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -P <0-2>    built-in scan priority (default 1)\n"
+           "  -d <pct>    custom profile duty cycle (overrides -P)\n"
+           "  -m <slots>  custom profile max scan window (default 48)\n"
+           "  -g <n>      custom profile small interval grant (default 2)\n"
+           "  -i <slots>  scan interval (default 96)\n"
+           "  -w <slots>  scan window (default 48)\n"
+           "  -l <pct>    Wi-Fi load (default 60)\n"
+           "  -b <slots>  mean Wi-Fi burst length (default 8)\n"
+           "  -a <slots>  advertising interval (default 160)\n"
+           "  -H <slots>  horizon (default 16000)\n"
+           "  -s          sweep scan interval/window and report evaluations per second\n", prog);
+}
+
+static void airtime_print(const cy_smartcoex_bt_config_t *bt_config, const cy_smartcoex_sim_result_t *r)
+{
+    printf("scan_int=%u scan_win=%u -> eff_int=%u eff_win=%u\n", bt_config->scan_int, bt_config->scan_win,
+           r->eff_scan_int, r->eff_scan_win);
+    printf("  wifi airtime share   %6.3f\n", r->wifi_airtime_share);
+    printf("  wifi demand served   %6.3f\n", r->wifi_demand_served);
+    printf("  ble scan coverage    %6.3f\n", r->ble_scan_coverage);
+    printf("  ble scan denied      %6.3f\n", r->ble_scan_denied);
+    printf("  discovery prob       %6.3f\n", r->discovery_probability);
+    printf("  discovery mean (ms)  %8.1f\n", r->discovery_latency_mean_ms);
+    printf("  discovery p95  (ms)  %8.1f\n", r->discovery_latency_p95_ms);
+}
+
+int main(int argc, char **argv)
+{
+    cy_smartcoex_profile_t profile;
+    cy_smartcoex_profile_t *custom = NULL;
+    cy_smartcoex_bt_config_t bt_config = { .scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM, .scan_int = 96, .scan_win = 48 };
+    cy_smartcoex_sim_wifi_model_t wifi = { 60, 8, 1 };
+    cy_smartcoex_sim_adv_model_t adv = { 160, 16, 64, 1 };
+    cy_smartcoex_sim_result_t result;
+    uint32_t horizon = 16000;
+    uint32_t runs = 0;
+    uint16_t si, sw;
+    struct timespec t0, t1;
+    double elapsed;
+    bool sweep = false;
+    int opt;
+
+    profile.priority             = CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM;
+    profile.max_scan_window      = 48;
+    profile.small_interval_grant = 2;
+    profile.duty_cycle           = 50;
+
+    while((opt = getopt(argc, argv, "P:d:m:g:i:w:l:b:a:H:sh")) != -1)
+    {
+        switch(opt)
+        {
+            case 'P': bt_config.scan_priority = (cy_smartcoex_lescan_priority_t)atoi(optarg); break;
+            case 'd': profile.duty_cycle = (uint8_t)atoi(optarg); custom = &profile; break;
+            case 'm': profile.max_scan_window = (uint16_t)atoi(optarg); break;
+            case 'g': profile.small_interval_grant = (uint8_t)atoi(optarg); break;
+            case 'i': bt_config.scan_int = (uint16_t)atoi(optarg); break;
+            case 'w': bt_config.scan_win = (uint16_t)atoi(optarg); break;
+            case 'l': wifi.load_percent = (uint8_t)atoi(optarg); break;
+            case 'b': wifi.burst_slots = (uint16_t)atoi(optarg); break;
+            case 'a': adv.interval_slots = (uint16_t)atoi(optarg); break;
+            case 'H': horizon = (uint32_t)atoi(optarg); break;
+            case 's': sweep = true; break;
+            default:
+                airtime_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if(cy_smartcoex_sim_init(&sim, horizon) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "Invalid horizon\n");
+        return 2;
+    }
+
+    if(!sweep)
+    {
+        if(cy_smartcoex_sim_run(&sim, &bt_config, custom, &wifi, &adv, &result) != CY_RSLT_SUCCESS)
+        {
+            fprintf(stderr, "Invalid configuration\n");
+            return 2;
+        }
+        airtime_print(&bt_config, &result);
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(si = 16; si <= 1024; si += 16)
+    {
+        for(sw = 4; sw <= si; sw += 4)
+        {
+            bt_config.scan_int = si;
+            bt_config.scan_win = sw;
+            if(cy_smartcoex_sim_run(&sim, &bt_config, custom, &wifi, &adv, &result) == CY_RSLT_SUCCESS)
+            {
+                runs++;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    elapsed = (double)(t1.tv_sec - t0.tv_sec) + ((double)(t1.tv_nsec - t0.tv_nsec) / 1e9);
+
+    printf("%u configurations over %u slots in %.3f s: %.0f configurations/s\n",
+           (unsigned int)runs, (unsigned int)horizon, elapsed, (double)runs / elapsed);
+
+    return 0;
+}
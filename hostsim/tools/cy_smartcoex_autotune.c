@@ -0,0 +1,349 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_autotune.c
+* @brief Offline coex parameter search against a Wi-Fi/BLE service target.
+*
+* Searches profile parameters (duty cycle, max scan window, small interval
+* grant) together with scan interval/window using the airtime simulator, in
+* parallel across all host cores. Configurations that meet the target Wi-Fi
+* rate and BLE discovery p95 are ranked by Wi-Fi airtime, and the best
+* profiles are emitted as a table ready for cy_smartcoex_register_profile().
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cy_smartcoex_sim.h"
+
+#define AUTOTUNE_MAX_THREADS        64
+#define AUTOTUNE_DEFAULT_TOP        4
+
+/* Search grid */
+static const uint8_t  autotune_duty[]    = { 0, 10, 20, 25, 30, 40, 50, 60, 70, 80, 90, 100 };
+static const uint16_t autotune_max_win[] = { 16, 24, 32, 48, 64, 96, 128 };
+static const uint8_t  autotune_grant[]   = { 1, 2, 3, 4, 6, 8 };
+
+#define AUTOTUNE_COUNT(a)           (sizeof(a) / sizeof((a)[0]))
+#define AUTOTUNE_PROFILES           (AUTOTUNE_COUNT(autotune_duty) * AUTOTUNE_COUNT(autotune_max_win) * AUTOTUNE_COUNT(autotune_grant))
+
+#define AUTOTUNE_SCAN_INT_MIN       16
+#define AUTOTUNE_SCAN_INT_MAX       2048
+#define AUTOTUNE_SCAN_WIN_STEPS     8
+
+typedef struct
+{
+    float    wifi_mbps_min;
+    float    p95_ms_max;
+    float    discovery_min;
+    float    phy_mbps;
+    uint32_t horizon_slots;
+    cy_smartcoex_sim_wifi_model_t wifi;
+    cy_smartcoex_sim_adv_model_t  adv;
+} autotune_target_t;
+
+typedef struct
+{
+    bool                      valid;
+    cy_smartcoex_profile_t    profile;
+    uint16_t                  scan_int;
+    uint16_t                  scan_win;
+    cy_smartcoex_sim_result_t result;
+} autotune_candidate_t;
+
+typedef struct
+{
+    const autotune_target_t *target;
+    autotune_candidate_t    *best;       /* One entry per profile of the grid */
+    uint32_t                evaluated;
+} autotune_worker_t;
+
+static pthread_mutex_t autotune_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t        autotune_next;
+
+static bool autotune_better(const autotune_candidate_t *a, const autotune_candidate_t *b)
+{
+    if(!b->valid)
+    {
+        return a->valid;
+    }
+    if(a->result.wifi_airtime_share != b->result.wifi_airtime_share)
+    {
+        return a->result.wifi_airtime_share > b->result.wifi_airtime_share;
+    }
+    return a->result.discovery_latency_p95_ms < b->result.discovery_latency_p95_ms;
+}
+
+static void autotune_profile_at(uint32_t index, cy_smartcoex_profile_t *profile)
+{
+    uint32_t g = index % AUTOTUNE_COUNT(autotune_grant);
+    uint32_t m = (index / AUTOTUNE_COUNT(autotune_grant)) % AUTOTUNE_COUNT(autotune_max_win);
+    uint32_t d = index / (AUTOTUNE_COUNT(autotune_grant) * AUTOTUNE_COUNT(autotune_max_win));
+
+    profile->duty_cycle           = autotune_duty[d];
+    profile->max_scan_window      = autotune_max_win[m];
+    profile->small_interval_grant = autotune_grant[g];
+    profile->priority             = (profile->duty_cycle <= 33U) ? CY_SMARTCOEX_LESCAN_PRIORITY_LOW :
+                                    (profile->duty_cycle <= 66U) ? CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM :
+                                                                   CY_SMARTCOEX_LESCAN_PRIORITY_HIGH;
+}
+
+static void *autotune_worker(void *arg)
+{
+    autotune_worker_t *worker = (autotune_worker_t *)arg;
+    const autotune_target_t *target = worker->target;
+    cy_smartcoex_sim_t *sim;
+    cy_smartcoex_bt_config_t bt_config;
+    autotune_candidate_t candidate;
+    uint32_t index;
+    uint32_t scan_int;
+    uint32_t step;
+
+    sim = malloc(sizeof(*sim));
+    if(sim == NULL || cy_smartcoex_sim_init(sim, target->horizon_slots) != CY_RSLT_SUCCESS)
+    {
+        free(sim);
+        return NULL;
+    }
+
+    memset(&bt_config, 0, sizeof(bt_config));
+    for(;;)
+    {
+        pthread_mutex_lock(&autotune_mutex);
+        index = autotune_next++;
+        pthread_mutex_unlock(&autotune_mutex);
+        if(index >= AUTOTUNE_PROFILES)
+        {
+            break;
+        }
+
+        autotune_profile_at(index, &candidate.profile);
+        for(scan_int = AUTOTUNE_SCAN_INT_MIN; scan_int <= AUTOTUNE_SCAN_INT_MAX; scan_int += scan_int / 8U)
+        {
+            for(step = 1; step <= AUTOTUNE_SCAN_WIN_STEPS; step++)
+            {
+                bt_config.scan_int = (uint16_t)scan_int;
+                bt_config.scan_win = (uint16_t)((scan_int * step) / AUTOTUNE_SCAN_WIN_STEPS);
+                if(bt_config.scan_win < 4U)
+                {
+                    continue;
+                }
+
+                if(cy_smartcoex_sim_run(sim, &bt_config, &candidate.profile, &target->wifi, &target->adv,
+                                        &candidate.result) != CY_RSLT_SUCCESS)
+                {
+                    continue;
+                }
+                worker->evaluated++;
+
+                candidate.valid = (candidate.result.wifi_airtime_share * target->phy_mbps >= target->wifi_mbps_min) &&
+                                  (candidate.result.discovery_probability >= target->discovery_min) &&
+                                  (candidate.result.discovery_latency_p95_ms <= target->p95_ms_max);
+                if(!candidate.valid)
+                {
+                    continue;
+                }
+
+                candidate.scan_int = bt_config.scan_int;
+                candidate.scan_win = bt_config.scan_win;
+                if(autotune_better(&candidate, &worker->best[index]))
+                {
+                    worker->best[index] = candidate;
+                }
+            }
+        }
+    }
+
+    free(sim);
+    return NULL;
+}
+
+static int autotune_compare(const void *a, const void *b)
+{
+    const autotune_candidate_t *x = (const autotune_candidate_t *)a;
+    const autotune_candidate_t *y = (const autotune_candidate_t *)b;
+
+    if(autotune_better(x, y))
+    {
+        return -1;
+    }
+    return autotune_better(y, x) ? 1 : 0;
+}
+
+static void autotune_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -t <mbps>   minimum Wi-Fi airtime equivalent (default 20)\n"
+           "  -p <ms>     maximum BLE discovery p95 (default 500)\n"
+           "  -q <frac>   minimum discovery probability (default 0.99)\n"
+           "  -r <mbps>   Wi-Fi rate at full airtime (default 50)\n"
+           "  -l <pct>    Wi-Fi load (default 60)\n"
+           "  -b <slots>  mean Wi-Fi burst length (default 8)\n"
+           "  -a <slots>  advertising interval (default 160)\n"
+           "  -H <slots>  horizon (default 8000)\n"
+           "  -k <n>      number of profiles to emit (default %d)\n"
+           "  -j <n>      worker threads (default: all cores)\n", prog, AUTOTUNE_DEFAULT_TOP);
+}
+
+int main(int argc, char **argv)
+{
+    autotune_target_t target;
+    autotune_worker_t workers[AUTOTUNE_MAX_THREADS];
+    pthread_t threads[AUTOTUNE_MAX_THREADS];
+    autotune_candidate_t *best;
+    uint32_t threads_count = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t top = AUTOTUNE_DEFAULT_TOP;
+    uint32_t evaluated = 0;
+    uint32_t emitted = 0;
+    uint32_t last = 0;
+    uint32_t i, t;
+    int opt;
+
+    target.wifi_mbps_min = 20.0f;
+    target.p95_ms_max    = 500.0f;
+    target.discovery_min = 0.99f;
+    target.phy_mbps      = 50.0f;
+    target.horizon_slots = 8000;
+    target.wifi.load_percent   = 60;
+    target.wifi.burst_slots    = 8;
+    target.wifi.seed           = 1;
+    target.adv.interval_slots  = 160;
+    target.adv.delay_max_slots = 16;
+    target.adv.phases          = 64;
+    target.adv.seed            = 1;
+
+    while((opt = getopt(argc, argv, "t:p:q:r:l:b:a:H:k:j:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 't': target.wifi_mbps_min = strtof(optarg, NULL); break;
+            case 'p': target.p95_ms_max = strtof(optarg, NULL); break;
+            case 'q': target.discovery_min = strtof(optarg, NULL); break;
+            case 'r': target.phy_mbps = strtof(optarg, NULL); break;
+            case 'l': target.wifi.load_percent = (uint8_t)atoi(optarg); break;
+            case 'b': target.wifi.burst_slots = (uint16_t)atoi(optarg); break;
+            case 'a': target.adv.interval_slots = (uint16_t)atoi(optarg); break;
+            case 'H': target.horizon_slots = (uint32_t)atoi(optarg); break;
+            case 'k': top = (uint32_t)atoi(optarg); break;
+            case 'j': threads_count = (uint32_t)atoi(optarg); break;
+            default:
+                autotune_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if(threads_count == 0U)
+    {
+        threads_count = 1U;
+    }
+    if(threads_count > AUTOTUNE_MAX_THREADS)
+    {
+        threads_count = AUTOTUNE_MAX_THREADS;
+    }
+
+    /* Every profile index is owned by exactly one worker, so workers share one result array without locking */
+    best = calloc(AUTOTUNE_PROFILES, sizeof(*best));
+    if(best == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for(t = 0; t < threads_count; t++)
+    {
+        workers[t].target    = &target;
+        workers[t].best      = best;
+        workers[t].evaluated = 0;
+        pthread_create(&threads[t], NULL, autotune_worker, &workers[t]);
+    }
+    for(t = 0; t < threads_count; t++)
+    {
+        pthread_join(threads[t], NULL);
+        evaluated += workers[t].evaluated;
+    }
+
+    qsort(best, AUTOTUNE_PROFILES, sizeof(*best), autotune_compare);
+
+    printf("/*\n"
+           " * Generated by cy_smartcoex_autotune: %u configurations on %u threads.\n"
+           " * Target: Wi-Fi >= %.1f Mbps (at %.1f Mbps full airtime), discovery p95 <= %.0f ms, probability >= %.2f.\n"
+           " * Model: Wi-Fi load %u%%, burst %u slots; advertising interval %u slots.\n"
+           " */\n", (unsigned int)evaluated, (unsigned int)threads_count,
+           target.wifi_mbps_min, target.phy_mbps, target.p95_ms_max, target.discovery_min,
+           (unsigned int)target.wifi.load_percent, (unsigned int)target.wifi.burst_slots,
+           (unsigned int)target.adv.interval_slots);
+
+    for(i = 0; i < AUTOTUNE_PROFILES && emitted < top; i++)
+    {
+        if(!best[i].valid)
+        {
+            break;
+        }
+        if(emitted != 0U && best[i].scan_int == best[last].scan_int && best[i].scan_win == best[last].scan_win &&
+           best[i].result.wifi_airtime_share == best[last].result.wifi_airtime_share &&
+           best[i].result.discovery_latency_p95_ms == best[last].result.discovery_latency_p95_ms)
+        {
+            /* Parameters that have no effect on this traffic model yield duplicates; keep the first */
+            continue;
+        }
+        last = i;
+        if(emitted == 0U)
+        {
+            printf("static const cy_smartcoex_profile_t autotune_profiles[] =\n{\n");
+        }
+        printf("    { %-36s %3u, %4u, %u }, /* scan_int=%u scan_win=%u: Wi-Fi %.1f Mbps, p95 %.0f ms */\n",
+               (best[i].profile.priority == CY_SMARTCOEX_LESCAN_PRIORITY_LOW) ? "CY_SMARTCOEX_LESCAN_PRIORITY_LOW," :
+               (best[i].profile.priority == CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM) ? "CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM," :
+                                                                                  "CY_SMARTCOEX_LESCAN_PRIORITY_HIGH,",
+               (unsigned int)best[i].profile.duty_cycle, (unsigned int)best[i].profile.max_scan_window,
+               (unsigned int)best[i].profile.small_interval_grant,
+               (unsigned int)best[i].scan_int, (unsigned int)best[i].scan_win,
+               best[i].result.wifi_airtime_share * target.phy_mbps, best[i].result.discovery_latency_p95_ms);
+        emitted++;
+    }
+
+    if(emitted == 0U)
+    {
+        printf("/* No configuration meets the target. */\n");
+        free(best);
+        return 1;
+    }
+    printf("};\n");
+
+    free(best);
+    return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_ctrl_replay.c
+* @brief Replays a telemetry trace through the adaptive controller.
+*
+* Each trace line is "interval_ms,wifi_bytes,wifi_frames,wifi_retries,adv_reports"
+* for one sampling interval; lines starting with '#' are ignored. The Wi-Fi
+* deltas are fed to the whd_wifi_get_counters() stand-in and the advertising
+* reports to cy_smartcoex_controller_report_adv(), so the full sample and step
+* path runs against the host radios. With -g, a built-in trace is replayed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_controller.h"
+#include "cy_smartcoex_hostsim.h"
+
+/* Built-in trace: Wi-Fi busy with no BLE, BLE burst, BLE burst with Wi-Fi retrying, quiet */
+static const char *replay_builtin[] =
+{
+    "# interval_ms,wifi_bytes,wifi_frames,wifi_retries,adv_reports",
+    "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0",
+    "100,250000,200,2,3", "100,250000,200,2,4", "100,250000,200,2,3", "100,250000,200,2,5",
+    "100,250000,200,2,4", "100,250000,200,2,3", "100,250000,200,2,4", "100,250000,200,2,6",
+    "100,250000,200,2,0", "100,250000,200,2,2", "100,250000,200,2,3",
+    "100,180000,200,90,4", "100,180000,200,90,5", "100,180000,200,90,4", "100,180000,200,90,4",
+    "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0",
+    "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0",
+    "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0", "100,250000,200,2,0",
+    "100,200,2,0,1", "100,200,2,0,1", "100,200,2,0,1", "100,200,2,0,1",
+};
+
+static uint32_t replay_wifi_calls;
+
+static void replay_bt_cb(wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params)
+{
+    (void)p_command_complete_params;
+}
+
+static void replay_usage(const char *prog)
+{
+    printf("Usage: %s [options] [trace.csv]\n"
+           "  -g          replay the built-in trace\n"
+           "  -L <n>      levels (default 8)\n"
+           "  -d <lo:hi>  duty cycle bounds in percent (default 10:50)\n"
+           "  -G <lo:hi>  small interval grant bounds (default 1:8)\n"
+           "  -A <rate>   BLE active threshold in reports/s (default 10)\n"
+           "  -I <rate>   BLE idle threshold in reports/s (default 1)\n"
+           "  -k <kbps>   Wi-Fi idle threshold (default 64)\n"
+           "  -r <pct>    Wi-Fi retry guard (default 20)\n"
+           "  -H <n>      hold samples (default 3)\n"
+           "Reads the trace from stdin when no file is given.\n", prog);
+}
+
+static int replay_line(cy_smartcoex_controller_t *ctrl, whd_counters_t *counters, const char *line, uint32_t *t_ms)
+{
+    cy_smartcoex_controller_sample_t sample;
+    cy_smartcoex_hostsim_stats_t stats;
+    unsigned int interval, bytes, frames, retries, adv;
+    unsigned int before, after;
+    cy_rslt_t result;
+
+    if(line[0] == '#' || line[0] == '\n' || line[0] == '\0')
+    {
+        return 0;
+    }
+    if(sscanf(line, "%u,%u,%u,%u,%u", &interval, &bytes, &frames, &retries, &adv) != 5)
+    {
+        fprintf(stderr, "bad trace line: %s", line);
+        return -1;
+    }
+
+    counters->txbyte    += bytes;
+    counters->txframe   += frames;
+    counters->txretrans += retries;
+    cy_smartcoex_hostsim_set_wifi_counters(counters);
+    cy_smartcoex_controller_report_adv(ctrl, adv);
+
+    before = cy_smartcoex_controller_get_level(ctrl);
+    if(cy_smartcoex_controller_sample(ctrl, interval, &sample) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "sample failed\n");
+        return -1;
+    }
+    result = cy_smartcoex_controller_step(ctrl, &sample);
+    after  = cy_smartcoex_controller_get_level(ctrl);
+    *t_ms += interval;
+
+    cy_smartcoex_hostsim_wait_idle();
+    cy_smartcoex_hostsim_get_stats(&stats);
+    /* Print every commit and every failed attempt */
+    if(result != CY_RSLT_SUCCESS || stats.wifi_calls != replay_wifi_calls)
+    {
+        replay_wifi_calls = stats.wifi_calls;
+        printf("t=%6u ms  level %u -> %u  duty=%3u%% grant=%u  vsc=%u ioctl=%u%s\n", *t_ms, before, after,
+               stats.last_wifi_config.le_scan_params.duty_cycle, stats.last_wifi_config.le_scan_params.int_grant,
+               stats.vsc_calls, stats.wifi_calls, (result != CY_RSLT_SUCCESS) ? "  (commit failed)" : "");
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    cy_smartcoex_wifi_config_t wifi_config = { CY_SMARTCOEX_INTERFACE_TYPE_STA };
+    cy_smartcoex_bt_config_t bt_config = { .scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_LOW, .scan_int = 96, .scan_win = 48,
+                                             .btcoex_cb = replay_bt_cb };
+    cy_smartcoex_controller_config_t config;
+    cy_smartcoex_controller_t *ctrl;
+    cy_smartcoex_hostsim_stats_t stats;
+    whd_counters_t counters;
+    char line[256];
+    FILE *trace = stdin;
+    uint32_t t_ms = 0;
+    uint32_t samples = 0;
+    bool builtin = false;
+    unsigned int lo, hi;
+    size_t i;
+    int opt;
+    int rc = 0;
+
+    cy_smartcoex_controller_default_config(&config);
+
+    while((opt = getopt(argc, argv, "gL:d:G:A:I:k:r:H:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'g': builtin = true; break;
+            case 'L': config.levels = (uint8_t)atoi(optarg); break;
+            case 'd':
+                if(sscanf(optarg, "%u:%u", &lo, &hi) == 2) { config.duty_cycle_min = (uint8_t)lo; config.duty_cycle_max = (uint8_t)hi; }
+                break;
+            case 'G':
+                if(sscanf(optarg, "%u:%u", &lo, &hi) == 2) { config.small_interval_grant_min = (uint8_t)lo; config.small_interval_grant_max = (uint8_t)hi; }
+                break;
+            case 'A': config.ble_active_reports_per_sec = (uint32_t)atoi(optarg); break;
+            case 'I': config.ble_idle_reports_per_sec = (uint32_t)atoi(optarg); break;
+            case 'k': config.wifi_idle_kbps = (uint32_t)atoi(optarg); break;
+            case 'r': config.wifi_retry_max_percent = (uint8_t)atoi(optarg); break;
+            case 'H': config.hold_samples = (uint8_t)atoi(optarg); break;
+            default:
+                replay_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if(!builtin && optind < argc)
+    {
+        trace = fopen(argv[optind], "r");
+        if(trace == NULL)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    if(cy_smartcoex_hostsim_init(NULL) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "hostsim init failed\n");
+        return 1;
+    }
+
+    if(cy_smartcoex_controller_create(&ctrl, NULL, &wifi_config, &bt_config, &config) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "invalid controller configuration\n");
+        cy_smartcoex_hostsim_deinit();
+        return 2;
+    }
+
+    memset(&counters, 0, sizeof(counters));
+    /* Prime the counter baseline so the first trace line yields real deltas */
+    {
+        cy_smartcoex_controller_sample_t sample;
+        (void)cy_smartcoex_controller_sample(ctrl, 0, &sample);
+    }
+
+    if(builtin)
+    {
+        for(i = 0; i < sizeof(replay_builtin) / sizeof(replay_builtin[0]) && rc == 0; i++)
+        {
+            rc = replay_line(ctrl, &counters, replay_builtin[i], &t_ms);
+            samples++;
+        }
+    }
+    else
+    {
+        while(rc == 0 && fgets(line, sizeof(line), trace) != NULL)
+        {
+            rc = replay_line(ctrl, &counters, line, &t_ms);
+            samples++;
+        }
+    }
+
+    cy_smartcoex_hostsim_wait_idle();
+    cy_smartcoex_hostsim_get_stats(&stats);
+    printf("%u lines, final level %u, %u VSCs, %u ioctls\n", samples, cy_smartcoex_controller_get_level(ctrl),
+           stats.vsc_calls, stats.wifi_calls);
+
+    cy_smartcoex_controller_destroy(ctrl);
+    cy_smartcoex_hostsim_deinit();
+    if(trace != stdin)
+    {
+        fclose(trace);
+    }
+
+    return (rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_logdecode.c
+* @brief Host decoder for Smart Coex binary log records.
+*
+* Expands a file of raw cy_smartcoex_binlog_record_t records, as returned by
+* cy_smartcoex_binlog_read(), with the format strings of the image that
+* produced them. The format strings are the smartcoex_log_fmt section of that
+* image, extracted with:
+*
+*     objcopy -O binary --only-section=smartcoex_log_fmt app.elf fmt.bin
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cy_smartcoex_log.h"
+
+static const char *logdecode_level[] = { "OFF", "ERR", "WARNING", "NOTICE", "INFO", "DEBUG", "DEBUG1", "DEBUG2", "DEBUG3", "DEBUG4" };
+
+static void logdecode_usage(const char *prog)
+{
+    printf("Usage: %s -f <fmt.bin> [-u <us per 10^6 ticks>] <records.bin>\n"
+           "  -f <file>   smartcoex_log_fmt section of the image\n"
+           "  -u <n>      timestamp scale (default 1000000, i.e. 1 tick = 1 us)\n", prog);
+}
+
+static char *logdecode_load(const char *path, long *size)
+{
+    FILE *f = fopen(path, "rb");
+    char *data;
+
+    if(f == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    /* Terminated so that a truncated last string cannot run off the end */
+    data = malloc((size_t)*size + 1);
+    if(data == NULL || fread(data, 1, (size_t)*size, f) != (size_t)*size)
+    {
+        fprintf(stderr, "%s: read failed\n", path);
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    data[*size] = '\0';
+    fclose(f);
+
+    return data;
+}
+
+int main(int argc, char **argv)
+{
+    cy_smartcoex_binlog_record_t record;
+    const char *fmt_path = NULL;
+    uint64_t us_per_mtick = 1000000;
+    uint32_t last_seq = 0;
+    char message[256];
+    char *fmt;
+    long fmt_size;
+    FILE *in;
+    int opt;
+
+    while((opt = getopt(argc, argv, "f:u:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'f': fmt_path = optarg; break;
+            case 'u': us_per_mtick = strtoull(optarg, NULL, 0); break;
+            default:
+                logdecode_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if(fmt_path == NULL || optind >= argc)
+    {
+        logdecode_usage(argv[0]);
+        return 2;
+    }
+
+    fmt = logdecode_load(fmt_path, &fmt_size);
+    if(fmt == NULL)
+    {
+        return 1;
+    }
+
+    in = fopen(argv[optind], "rb");
+    if(in == NULL)
+    {
+        perror(argv[optind]);
+        free(fmt);
+        return 1;
+    }
+
+    while(fread(&record, sizeof(record), 1, in) == 1)
+    {
+        if(last_seq != 0 && record.seq != last_seq + 1)
+        {
+            printf("... %u records lost\n", (unsigned int)(record.seq - last_seq - 1));
+        }
+        last_seq = record.seq;
+
+        if(record.fmt_id >= fmt_size)
+        {
+            printf("%8u %12llu us  %-7s <unknown format %u>\n", (unsigned int)record.seq,
+                   (unsigned long long)(record.timestamp * us_per_mtick / 1000000ULL), "?", record.fmt_id);
+            continue;
+        }
+
+        cy_smartcoex_binlog_format(&fmt[record.fmt_id], &record, message, sizeof(message));
+        printf("%8u %12llu us  %-7s %s", (unsigned int)record.seq,
+               (unsigned long long)(record.timestamp * us_per_mtick / 1000000ULL),
+               (record.level < sizeof(logdecode_level) / sizeof(logdecode_level[0])) ? logdecode_level[record.level] : "?",
+               message);
+        if(message[0] == '\0' || message[strlen(message) - 1] != '\n')
+        {
+            printf("\n");
+        }
+    }
+
+    fclose(in);
+    free(fmt);
+
+    return 0;
+}
@@ -0,0 +1,458 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_trace_replay.c
+* @brief Replays a recorded coex trace through the library against the host radios.
+*
+* The trace is a file written from cy_smartcoex_trace_read() records: the
+* header of cy_smartcoex_trace_encode_header() followed by records encoded with
+* cy_smartcoex_trace_encode(). Each REQUEST is re-issued on a context of the
+* same number with the recorded profile, scan and LE link settings. Before each
+* commit, the host radios are scripted with the send results and completion
+* HCI statuses of its OUTCOME and COMPLETION records, so BUSY returns, failed
+* ioctls and failed completions recur where they occurred. Requests are paced
+* at the recorded times divided by the speed-up, or back to back with -s 0.
+*
+* A request diverges when the replayed result, or the set of radios written,
+* differs from the recording. The exit status is non-zero if any request
+* diverged, so a field trace can serve as a regression test.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_trace.h"
+#include "cy_smartcoex_hostsim.h"
+#include "cy_result_mw.h"
+
+/* Most VSCs a commit sends: the LE scan and the LE link VSC */
+#define REPLAY_MAX_VSC      2
+
+#define REPLAY_MAX_CTX      256
+
+typedef struct
+{
+    cy_smartcoex_ctx_t *ctx[REPLAY_MAX_CTX];
+    uint32_t requests;
+    uint32_t diverged;
+    bool     quiet;
+} replay_t;
+
+static void replay_bt_cb(wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params)
+{
+    (void)p_command_complete_params;
+}
+
+static void replay_usage(const char *prog)
+{
+    printf("Usage: %s [options] trace.bin\n"
+           "  -s <factor>  speed-up over the recorded timing; 0 replays back to back (default 1)\n"
+           "  -c <us>      simulated VSC completion latency\n"
+           "  -a           deliver VSC completions asynchronously\n"
+           "  -q           print only diverging requests and the summary\n"
+#ifdef ENABLE_SMARTCOEX_TRACE
+           "  -o <file>    write the trace recorded during the replay to file\n"
+#endif
+           , prog);
+}
+
+static cy_smartcoex_trace_record_t *replay_load(const char *path, uint32_t *us_per_mtick, uint32_t *count)
+{
+    uint8_t buf[CY_SMARTCOEX_TRACE_RECORD_SIZE];
+    cy_smartcoex_trace_record_t *records = NULL;
+    cy_smartcoex_trace_record_t *grown;
+    uint32_t capacity = 0;
+    FILE *f;
+
+    *count = 0;
+    f = fopen(path, "rb");
+    if(f == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    if(fread(buf, 1, CY_SMARTCOEX_TRACE_HEADER_SIZE, f) != CY_SMARTCOEX_TRACE_HEADER_SIZE ||
+       cy_smartcoex_trace_decode_header(buf, us_per_mtick) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "%s: not a trace of version %d or older\n", path, CY_SMARTCOEX_TRACE_VERSION);
+        fclose(f);
+        return NULL;
+    }
+
+    while(fread(buf, 1, CY_SMARTCOEX_TRACE_RECORD_SIZE, f) == CY_SMARTCOEX_TRACE_RECORD_SIZE)
+    {
+        if(*count == capacity)
+        {
+            capacity = (capacity == 0) ? 256U : capacity * 2U;
+            grown = realloc(records, sizeof(*records) * capacity);
+            if(grown == NULL)
+            {
+                fprintf(stderr, "Out of memory\n");
+                free(records);
+                fclose(f);
+                return NULL;
+            }
+            records = grown;
+        }
+        if(cy_smartcoex_trace_decode(buf, &records[*count]) == CY_RSLT_SUCCESS)
+        {
+            (*count)++;
+        }
+    }
+    fclose(f);
+
+    return records;
+}
+
+/* HCI status the recorded VSC completed with; success if its completion was not recorded */
+static uint8_t replay_hci_status(const cy_smartcoex_trace_record_t *records, uint32_t count, uint8_t ctx_id, bool link, uint32_t gen)
+{
+    uint32_t i;
+
+    for(i = 0; i < count; i++)
+    {
+        if(records[i].type == CY_SMARTCOEX_TRACE_COMPLETION && records[i].ctx_id == ctx_id && records[i].gen == gen &&
+           ((records[i].flags & CY_SMARTCOEX_TRACE_FLAG_LINK) != 0) == link)
+        {
+            return records[i].hci_status;
+        }
+    }
+
+    return 0;
+}
+
+/* Scripts the host radios to answer the commit as they did when outcome was recorded */
+static void replay_script(const cy_smartcoex_trace_record_t *records, uint32_t count, const cy_smartcoex_trace_record_t *outcome)
+{
+    wiced_result_t results[REPLAY_MAX_VSC];
+    uint8_t statuses[REPLAY_MAX_VSC];
+    uint32_t vscs = 0;
+
+    if((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_VSC_SENT) != 0)
+    {
+        results[vscs]  = (wiced_result_t)outcome->vsc_result;
+        statuses[vscs] = replay_hci_status(records, count, outcome->ctx_id, false, outcome->vsc_gen);
+        vscs++;
+    }
+    if((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_LINK_SENT) != 0)
+    {
+        results[vscs]  = (wiced_result_t)outcome->link_result;
+        statuses[vscs] = replay_hci_status(records, count, outcome->ctx_id, true, outcome->link_gen);
+        vscs++;
+    }
+    (void)cy_smartcoex_hostsim_script_vsc(results, statuses, vscs);
+
+    if((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_WIFI_SENT) != 0 && outcome->wifi_result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_hostsim_inject_wifi_result(outcome->wifi_result, 1);
+    }
+    else
+    {
+        cy_smartcoex_hostsim_inject_wifi_result(0, 0);
+    }
+}
+
+/* Profile ID of the context matching the recorded profile, registering it if needed */
+static cy_rslt_t replay_profile(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_profile_t *recorded, cy_smartcoex_lescan_priority_t *profile_id)
+{
+    cy_smartcoex_profile_t profile;
+    uint32_t id;
+
+    for(id = 0; cy_smartcoex_ctx_get_profile(ctx, (cy_smartcoex_lescan_priority_t)id, &profile) == CY_RSLT_SUCCESS; id++)
+    {
+        if(profile.priority == recorded->priority && profile.duty_cycle == recorded->duty_cycle &&
+           profile.max_scan_window == recorded->max_scan_window && profile.small_interval_grant == recorded->small_interval_grant)
+        {
+            *profile_id = (cy_smartcoex_lescan_priority_t)id;
+            return CY_RSLT_SUCCESS;
+        }
+    }
+
+    return cy_smartcoex_ctx_register_profile(ctx, recorded, profile_id);
+}
+
+static void replay_pace(uint64_t offset_us, double speed, uint64_t start_ns)
+{
+    uint64_t due_ns;
+    uint64_t now;
+    struct timespec ts;
+
+    if(speed <= 0.0)
+    {
+        return;
+    }
+    due_ns = start_ns + (uint64_t)((double)offset_us * 1000.0 / speed);
+    now    = cy_smartcoex_hostsim_now_ns();
+    if(due_ns > now)
+    {
+        ts.tv_sec  = (time_t)((due_ns - now) / 1000000000ULL);
+        ts.tv_nsec = (long)((due_ns - now) % 1000000000ULL);
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void replay_request(replay_t *replay, const cy_smartcoex_trace_record_t *records, uint32_t count,
+                           const cy_smartcoex_trace_record_t *request, const cy_smartcoex_trace_record_t *outcome,
+                           uint64_t offset_us)
+{
+    cy_smartcoex_wifi_config_t wifi_configs[CY_SMARTCOEX_INTERFACE_TYPE_AP + 1];
+    cy_smartcoex_bt_config_t bt_config;
+    cy_smartcoex_hostsim_stats_t before, after;
+    cy_smartcoex_ctx_t *ctx;
+    cy_rslt_t result;
+    uint32_t expected_vscs;
+    uint32_t vscs;
+    uint8_t interfaces = 0;
+    uint32_t i;
+    bool wifi_sent;
+    bool diverged;
+
+    if(replay->ctx[request->ctx_id] == NULL &&
+       cy_smartcoex_ctx_create(&replay->ctx[request->ctx_id], NULL) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "context %u: create failed\n", (unsigned int)request->ctx_id);
+        return;
+    }
+    ctx = replay->ctx[request->ctx_id];
+
+    memset(&bt_config, 0, sizeof(bt_config));
+    if(replay_profile(ctx, &request->profile, &bt_config.scan_priority) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "seq %u: profile not registered\n", (unsigned int)request->seq);
+        return;
+    }
+    bt_config.scan_int  = request->scan_int;
+    bt_config.scan_win  = request->scan_win;
+    bt_config.btcoex_cb = replay_bt_cb;
+    memcpy(bt_config.conn, request->conn, sizeof(bt_config.conn));
+    bt_config.adv       = request->adv;
+    for(i = 0; i < sizeof(wifi_configs) / sizeof(wifi_configs[0]); i++)
+    {
+        if((request->interfaces & (1U << i)) != 0)
+        {
+            wifi_configs[interfaces++].interface = (cy_smartcoex_wifi_interface_t)i;
+        }
+    }
+
+    replay_script(records, count, outcome);
+    cy_smartcoex_hostsim_get_stats(&before);
+    if(interfaces == 1)
+    {
+        result = cy_smartcoex_ctx_config(ctx, &wifi_configs[0], &bt_config);
+    }
+    else
+    {
+        result = cy_smartcoex_ctx_config_batch(ctx, wifi_configs, interfaces, &bt_config);
+    }
+    cy_smartcoex_hostsim_get_stats(&after);
+    (void)cy_smartcoex_hostsim_script_vsc(NULL, NULL, 0);
+
+    expected_vscs = (((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_VSC_SENT) != 0) ? 1U : 0U) +
+                    (((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_LINK_SENT) != 0) ? 1U : 0U);
+    vscs      = after.vsc_calls - before.vsc_calls;
+    wifi_sent = (after.wifi_calls != before.wifi_calls);
+    diverged  = (result != outcome->result || vscs != expected_vscs ||
+                 wifi_sent != ((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_WIFI_SENT) != 0));
+
+    replay->requests++;
+    if(diverged)
+    {
+        replay->diverged++;
+    }
+    if(diverged || !replay->quiet)
+    {
+        printf("t=%10.3f ms  ctx %u  seq %-6u prio=%u int=%-5u win=%-5u  vsc=%u/%u wifi=%u/%u  result=0x%08X/0x%08X%s\n",
+               (double)offset_us / 1000.0, (unsigned int)request->ctx_id, (unsigned int)request->seq,
+               (unsigned int)request->scan_priority, (unsigned int)request->scan_int, (unsigned int)request->scan_win,
+               (unsigned int)vscs, (unsigned int)expected_vscs,
+               wifi_sent ? 1U : 0U, ((outcome->flags & CY_SMARTCOEX_TRACE_FLAG_WIFI_SENT) != 0) ? 1U : 0U,
+               (unsigned int)result, (unsigned int)outcome->result, diverged ? "  DIVERGED" : "");
+    }
+}
+
+#ifdef ENABLE_SMARTCOEX_TRACE
+/* Appends the records written since cursor to f */
+static void replay_drain(FILE *f, uint32_t *cursor)
+{
+    cy_smartcoex_trace_record_t records[32];
+    uint8_t buf[CY_SMARTCOEX_TRACE_RECORD_SIZE];
+    uint32_t count;
+    uint32_t i;
+
+    while((count = cy_smartcoex_trace_read(cursor, records, 32, NULL)) != 0)
+    {
+        for(i = 0; i < count; i++)
+        {
+            cy_smartcoex_trace_encode(&records[i], buf);
+            fwrite(buf, 1, sizeof(buf), f);
+        }
+    }
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    cy_smartcoex_hostsim_config_t sim_config;
+    cy_smartcoex_trace_record_t *records;
+    replay_t replay;
+    uint32_t us_per_mtick;
+    uint32_t count;
+    uint32_t prev_ts = 0;
+    uint64_t offset_ticks = 0;
+    uint64_t start_ns;
+    double speed = 1.0;
+    bool started = false;
+    uint32_t i;
+    int opt;
+#ifdef ENABLE_SMARTCOEX_TRACE
+    uint8_t header[CY_SMARTCOEX_TRACE_HEADER_SIZE];
+    uint32_t cursor = 0;
+    uint32_t own_scale;
+    FILE *out = NULL;
+#endif
+
+    memset(&sim_config, 0, sizeof(sim_config));
+    memset(&replay, 0, sizeof(replay));
+    while((opt = getopt(argc, argv, "s:c:aqo:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 's': speed = strtod(optarg, NULL); break;
+            case 'c': sim_config.vsc_complete_latency_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'a': sim_config.vsc_async_complete = true; break;
+            case 'q': replay.quiet = true; break;
+#ifdef ENABLE_SMARTCOEX_TRACE
+            case 'o':
+                out = fopen(optarg, "wb");
+                if(out == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+#endif
+            default:
+                replay_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if(optind >= argc)
+    {
+        replay_usage(argv[0]);
+        return 2;
+    }
+
+    records = replay_load(argv[optind], &us_per_mtick, &count);
+    if(records == NULL)
+    {
+        return 1;
+    }
+
+    if(cy_smartcoex_hostsim_init(&sim_config) != CY_RSLT_SUCCESS)
+    {
+        fprintf(stderr, "hostsim init failed\n");
+        free(records);
+        return 1;
+    }
+
+#ifdef ENABLE_SMARTCOEX_TRACE
+    if(out != NULL)
+    {
+        (void)cy_smartcoex_trace_read(&cursor, NULL, 0, &own_scale);
+        cy_smartcoex_trace_encode_header(own_scale, header);
+        fwrite(header, 1, sizeof(header), out);
+    }
+#endif
+
+    start_ns = cy_smartcoex_hostsim_now_ns();
+    for(i = 0; i + 1U < count; i++)
+    {
+        /* A commit claims its REQUEST and OUTCOME together, so a REQUEST without its OUTCOME was overwritten */
+        if(records[i].type != CY_SMARTCOEX_TRACE_REQUEST || records[i + 1U].type != CY_SMARTCOEX_TRACE_OUTCOME ||
+           records[i + 1U].ctx_id != records[i].ctx_id)
+        {
+            continue;
+        }
+
+        /* Accumulated deltas survive the 32-bit timestamp wrapping */
+        if(started)
+        {
+            offset_ticks += (uint32_t)(records[i].timestamp - prev_ts);
+        }
+        started = true;
+        prev_ts = records[i].timestamp;
+
+        replay_pace(offset_ticks * us_per_mtick / 1000000ULL, speed, start_ns);
+        replay_request(&replay, records, count, &records[i], &records[i + 1U], offset_ticks * us_per_mtick / 1000000ULL);
+        /* Back to back, let completions catch up so the in-flight window does not fill where it did not when recorded */
+        if(sim_config.vsc_async_complete && speed <= 0.0)
+        {
+            cy_smartcoex_hostsim_wait_idle();
+        }
+#ifdef ENABLE_SMARTCOEX_TRACE
+        if(out != NULL)
+        {
+            replay_drain(out, &cursor);
+        }
+#endif
+        i++;
+    }
+
+    cy_smartcoex_hostsim_wait_idle();
+    printf("%u requests replayed in %.1f ms, %u diverged\n", (unsigned int)replay.requests,
+           (double)(cy_smartcoex_hostsim_now_ns() - start_ns) / 1e6, (unsigned int)replay.diverged);
+
+#ifdef ENABLE_SMARTCOEX_TRACE
+    if(out != NULL)
+    {
+        replay_drain(out, &cursor);
+        fclose(out);
+    }
+#endif
+    for(i = 0; i < REPLAY_MAX_CTX; i++)
+    {
+        if(replay.ctx[i] != NULL)
+        {
+            cy_smartcoex_ctx_destroy(replay.ctx[i]);
+        }
+    }
+    cy_smartcoex_hostsim_deinit();
+    free(records);
+
+    return (replay.diverged == 0) ? 0 : 1;
+}
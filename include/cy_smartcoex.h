@@ -46,6 +46,7 @@ extern "C" {
 
 #include "cy_result.h"
 #include "wiced_bt_dev.h"
+#include "whd_types.h"
 
 
 /**
@@ -55,6 +56,63 @@ extern "C" {
  * \defgroup group_smartcoex_functions Functions
  */
 
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * Number of coex profiles a context can hold, including the three built-in
+ * LOW/MEDIUM/HIGH profiles. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_MAX_PROFILES
+#define CY_SMARTCOEX_MAX_PROFILES               (8)
+#endif
+
+/**
+ * Number of coex VSCs a context may have awaiting completion. A commit that
+ * needs to send another VSC while the window is full fails as if the BT stack
+ * were busy. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_VSC_WINDOW
+#define CY_SMARTCOEX_VSC_WINDOW                 (4)
+#endif
+
+/**
+ * OCF of the BT controller's vendor-specific command that sets the coex
+ * arbitration of LE connection and advertising events. 0 when the controller
+ * firmware has no such command, in which case only LE scan coex is available.
+ * Set in the application's 'DEFINES' for firmware that supports it.
+ */
+#ifndef CY_SMARTCOEX_VSC_OCF_BTCX_LELINK
+#define CY_SMARTCOEX_VSC_OCF_BTCX_LELINK        (0)
+#endif
+
+/**
+ * OCF of the BT controller's vendor-specific command that reads its coex
+ * counters. The command takes no parameters; its completion returns the HCI
+ * status followed by the cumulative number of BT requests granted and denied
+ * by the coex arbiter, each as a little-endian uint32_t. 0 when the controller
+ * firmware has no such command, in which case \ref cy_smartcoex_readback
+ * reports Wi-Fi statistics only. Set in the application's 'DEFINES' for
+ * firmware that supports it.
+ */
+#ifndef CY_SMARTCOEX_VSC_OCF_BTCX_STATS
+#define CY_SMARTCOEX_VSC_OCF_BTCX_STATS         (0)
+#endif
+
+/** Size of the BT vendor-specific command payload held in a \ref cy_smartcoex_snapshot_t. */
+#define CY_SMARTCOEX_SNAPSHOT_VSC_SIZE          (4)
+
+/** Size of the LE link vendor-specific command payload held in a \ref cy_smartcoex_snapshot_t. */
+#define CY_SMARTCOEX_SNAPSHOT_LINK_SIZE         (9)
+
+/** \} group_smartcoex_macros */
+
 /******************************************************
  *                   Typedefs
  ******************************************************/
@@ -69,6 +127,12 @@ extern "C" {
  */
 typedef wiced_bt_dev_vendor_specific_command_complete_cback_t* btcoex_cb_t;
 
+/**
+ * Smart Coex context handle. A context holds all state for one BT/Wi-Fi radio
+ * pair; see \ref cy_smartcoex_ctx_create.
+ */
+typedef struct cy_smartcoex_ctx cy_smartcoex_ctx_t;
+
 /** \} group_smartcoex_typedefs */
 
 /******************************************************
@@ -86,6 +150,7 @@ typedef wiced_bt_dev_vendor_specific_command_complete_cback_t* btcoex_cb_t;
 typedef enum
 {
     CY_SMARTCOEX_INTERFACE_TYPE_STA = 0,                                   /**< STA or Client interface.*/
+    CY_SMARTCOEX_INTERFACE_TYPE_AP,                                        /**< Soft-AP interface. */
     /* Should be the last entry. */
     CY_SMARTCOEX_INTERFACE_TYPE_DEFAULT = CY_SMARTCOEX_INTERFACE_TYPE_STA, /**< Default interface. */
 } cy_smartcoex_wifi_interface_t;
@@ -100,6 +165,16 @@ typedef enum
     CY_SMARTCOEX_LESCAN_PRIORITY_HIGH            /**< High priority.   */
 } cy_smartcoex_lescan_priority_t;
 
+/**
+ * BLE roles with their own connection-event coex settings
+ */
+typedef enum
+{
+    CY_SMARTCOEX_LE_ROLE_CENTRAL = 0,            /**< Connections in which the device is central.    */
+    CY_SMARTCOEX_LE_ROLE_PERIPHERAL,             /**< Connections in which the device is peripheral. */
+    CY_SMARTCOEX_LE_ROLE_MAX                     /**< Number of roles. */
+} cy_smartcoex_le_role_t;
+
 /** \} group_smartcoex_enums */
 
 /******************************************************
@@ -118,13 +193,48 @@ typedef struct
     cy_smartcoex_wifi_interface_t interface;    /**< Wi-Fi interface on which to set up the Smart Coex configuration. */
 } cy_smartcoex_wifi_config_t;
 
+/**
+ * Coex arbitration of one kind of LE link event. All zero leaves these events
+ * to the controller's default policy.
+ */
+typedef struct
+{
+    /**
+     * Priority of these events against Wi-Fi. One of the built-in LOW/MEDIUM/HIGH priorities.
+     */
+    cy_smartcoex_lescan_priority_t priority;
+
+    /**
+     * Every grant'th event is given high priority; 1 grants every event.
+     * 0 leaves these events to the controller's default policy.
+     *
+     * Range: 0-255
+     */
+    uint8_t  grant;
+
+    /**
+     * Consecutive events that may lose arbitration to Wi-Fi before the next one
+     * is given high priority regardless of grant, e.g. to stay well inside the
+     * connection supervision timeout. 0 disables.
+     *
+     * Range: 0-255
+     */
+    uint8_t  max_missed;
+} cy_smartcoex_le_event_config_t;
+
 /**
  * Smart Coex BT configuration parameters.
+ *
+ * Zero-initialize the whole structure (e.g. with memset() or a `= {0}`
+ * initializer) before setting fields; fields added in later versions then
+ * keep their default behaviour. Initializers written for an older version
+ * that list only the scan fields are zero-filled by the compiler, but a stack
+ * variable assigned field by field is not.
  */
 typedef struct
 {
     /**
-     * BT scan priority.
+     * BT scan priority, or a profile ID returned by \ref cy_smartcoex_register_profile.
      */
     cy_smartcoex_lescan_priority_t scan_priority;
 
@@ -150,10 +260,222 @@ typedef struct
      * Callback registered with BT stack to inform the status of the Vendor-specific command issued for setting the coex config.
      */
     btcoex_cb_t btcoex_cb;
+
+    /**
+     * Coex of connection events, per role. Ignored when CY_SMARTCOEX_VSC_OCF_BTCX_LELINK
+     * is 0; otherwise validated, so zero-initialize to leave connections to the controller.
+     */
+    cy_smartcoex_le_event_config_t conn[CY_SMARTCOEX_LE_ROLE_MAX];
+
+    /**
+     * Coex of advertising events. Ignored when CY_SMARTCOEX_VSC_OCF_BTCX_LELINK
+     * is 0; otherwise validated, so zero-initialize to leave advertising to the controller.
+     */
+    cy_smartcoex_le_event_config_t adv;
 } cy_smartcoex_bt_config_t;
 
+/**
+ * Coex profile: the LE scan parameters applied to the BT controller and WLAN.
+ */
+typedef struct
+{
+    /**
+     * Scan priority reported to WLAN.
+     */
+    cy_smartcoex_lescan_priority_t priority;
+
+    /**
+     * The upper bound of the percentage of the scan time that is given high priority.
+     *
+     * Units: percentage
+     * Range: 0-100
+     */
+    uint8_t  duty_cycle;
+
+    /**
+     * Allowed maximum scan window size, above which the host-specified scan
+     * interval and scan window are re-adjusted.
+     *
+     * Units: slots (1 slot = 0.625 ms)
+     * Range: 4-16384
+     */
+    uint16_t max_scan_window;
+
+    /**
+     * When the host-specified scan interval is smaller than max_scan_window,
+     * every small_interval_grant'th scan window is given high priority.
+     *
+     * Range: 1-255
+     */
+    uint8_t  small_interval_grant;
+} cy_smartcoex_profile_t;
+
+/**
+ * Radio operations used by a context to reach its BT controller and WLAN.
+ *
+ * A context created without radio operations uses the BT stack's
+ * wiced_bt_dev_vendor_specific_command() and the Wi-Fi port of the library.
+ *
+ * Each distinct pair of send_vsc and arg is taken to be one BT controller, which
+ * completes its commands in the order they were sent. Contexts sharing a controller
+ * must pass the same pair. Up to four controllers may be in use at a time.
+ */
+typedef struct
+{
+    /**
+     * Sends a vendor-specific command to the BT controller. Same contract as
+     * wiced_bt_dev_vendor_specific_command().
+     */
+    wiced_result_t (*send_vsc)(void *arg, uint16_t opcode, uint8_t param_len, uint8_t *p_param_buf,
+                               wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback);
+
+    /**
+     * Applies the coex configuration to the given Wi-Fi interface.
+     */
+    cy_rslt_t (*set_wifi_coex_config)(void *arg, cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config);
+
+    /**
+     * User argument passed to the operations.
+     */
+    void *arg;
+} cy_smartcoex_radio_ops_t;
+
+/**
+ * Completion tracking of the coex VSCs sent by a context.
+ */
+typedef struct
+{
+    uint32_t sent;              /**< VSCs accepted by the BT stack. */
+    uint32_t completed;         /**< Completions received. */
+    uint32_t failed;            /**< Completions that reported a non-zero HCI status. */
+    uint8_t  inflight;          /**< VSCs awaiting completion. */
+    uint8_t  last_hci_status;   /**< HCI status of the most recent completion. */
+    uint32_t last_rtt_us;       /**< Time from send to completion of the most recent VSC, in us. */
+    uint32_t last_applied_us;   /**< Time from the start of the most recent applied commit until its VSC completed and its Wi-Fi ioctl returned, in us. */
+} cy_smartcoex_vsc_status_t;
+
+/**
+ * Generations of the coex config live on each radio of a context.
+ *
+ * Every commit that sends anything to a radio is assigned the next generation.
+ * A radio is at generation N once it is confirmed to run the payload commit N
+ * asked for, including when that payload was already live and not resent.
+ * Both radios report the same generation when they run matching configs.
+ */
+typedef struct
+{
+    uint32_t requested;         /**< Generation of the most recent commit, whether or not it was applied. */
+    uint32_t bt;                /**< Generation confirmed by the BT controller's VSC completion. */
+    uint32_t wifi;              /**< Generation applied by the Wi-Fi ioctl. */
+} cy_smartcoex_generation_t;
+
+/**
+ * Compact record of the configuration last committed to both radios of a
+ * context: the BT vendor-specific command payload and the WHD coex config,
+ * with the Wi-Fi interfaces it was applied to.
+ *
+ * The record is self-checking, so it may be kept in RAM that survives a reset
+ * (e.g. a noinit section) and passed to \ref cy_smartcoex_restore after the
+ * BT stack or the Wi-Fi driver comes back up. The layout is private to the library.
+ */
+typedef struct
+{
+    uint32_t          magic;            /**< Identifies a snapshot and its layout version. */
+    uint32_t          check;            /**< Check value over the fields below. */
+    whd_coex_config_t wifi_config;      /**< WHD coex config. */
+    uint8_t           vsc_param[CY_SMARTCOEX_SNAPSHOT_VSC_SIZE]; /**< BT vendor-specific command payload. */
+    uint8_t           link_param[CY_SMARTCOEX_SNAPSHOT_LINK_SIZE]; /**< LE link vendor-specific command payload; zero if not configured. */
+    uint8_t           wifi_interfaces;  /**< Mask of the Wi-Fi interfaces, one bit per cy_smartcoex_wifi_interface_t. */
+    uint8_t           scan_priority;    /**< BT scan priority or profile ID of the commit. */
+    uint8_t           reserved[1];      /**< Zero. */
+} cy_smartcoex_snapshot_t;
+
+/**
+ * Advertiser to be discovered, and how soon.
+ */
+typedef struct
+{
+    /**
+     * Advertising interval of the device to discover.
+     *
+     * Units: slots (1 slot = 0.625 ms)
+     * Range: 32-16384
+     */
+    uint16_t adv_interval;
+
+    /**
+     * Probability of discovering the device within latency_ms.
+     *
+     * Units: permille
+     * Range: 1-1000
+     */
+    uint16_t probability;
+
+    /**
+     * Time within which the device should be discovered.
+     *
+     * Units: milliseconds
+     * Range: 1-600000
+     */
+    uint32_t latency_ms;
+} cy_smartcoex_discovery_target_t;
+
+/**
+ * Predicted behaviour of LE scan parameters under a coex profile. The
+ * prediction assumes Wi-Fi wants the medium all the time, so BT keeps only
+ * the high-priority part of its scan windows.
+ */
+typedef struct
+{
+    uint16_t eff_scan_int;      /**< Scan interval after the controller readjusts it, in slots. */
+    uint16_t eff_scan_win;      /**< Scan window after the controller readjusts it, in slots. */
+    uint16_t scan_duty;         /**< Share of time spent scanning while Wi-Fi is idle, in permille. */
+    uint16_t bt_airtime;        /**< Share of time BT keeps while Wi-Fi is busy, i.e. the airtime Wi-Fi loses, in permille. */
+    uint16_t discovery;         /**< Probability of discovering the target within its latency, in permille; 0 without a target. */
+} cy_smartcoex_scan_estimate_t;
+
+/**
+ * Coex config and statistics read back from the radios. Counters are deltas
+ * between the two most recent reads of the radio, so that a poller never has
+ * to keep the previous values.
+ */
+typedef struct
+{
+    uint32_t          seq;              /**< Number of the read this data comes from; unchanged when the data was served from the cache. */
+    uint32_t          age_ms;           /**< Time since the data was read, in ms. */
+    bool              wifi_config_valid; /**< wifi_config was read from WHD. */
+    bool              wifi_config_match; /**< wifi_config is the config last committed to the interface. */
+    whd_coex_config_t wifi_config;      /**< Coex config live in the WLAN firmware. */
+    bool              wifi_stats_valid; /**< The Wi-Fi deltas below are valid. */
+    uint32_t          wifi_interval_ms; /**< Time covered by the Wi-Fi deltas, in ms. */
+    uint32_t          wifi_bytes;       /**< Bytes sent and received. */
+    uint32_t          wifi_frames;      /**< Frames sent and received. */
+    uint32_t          wifi_retries;     /**< Frames retransmitted. */
+    bool              bt_stats_valid;   /**< The BT deltas below are valid. */
+    uint32_t          bt_interval_ms;   /**< Time covered by the BT deltas, in ms. */
+    uint32_t          bt_grants;        /**< BT requests granted by the coex arbiter. */
+    uint32_t          bt_denials;       /**< BT requests denied by the coex arbiter in favour of Wi-Fi. */
+} cy_smartcoex_readback_t;
+
 /** \} group_smartcoex_structs */
 
+/**
+ * \addtogroup group_smartcoex_typedefs
+ * \{
+ */
+
+/**
+ * Callback invoked from the async worker thread with the final result of a
+ * coex update queued through \ref cy_smartcoex_config_async.
+ *
+ * @param[in]  result     : CY_RSLT_SUCCESS if both radios accepted the update; an error code otherwise.
+ * @param[in]  bt_config  : The BT config that was committed.
+ * @param[in]  arg        : User argument passed to \ref cy_smartcoex_async_init.
+ */
+typedef void (*cy_smartcoex_async_cb_t)(cy_rslt_t result, cy_smartcoex_bt_config_t *bt_config, void *arg);
+
+/** \} group_smartcoex_typedefs */
+
 /******************************************************
  *                   Functions
  ******************************************************/
@@ -169,6 +491,19 @@ typedef struct
  * This function configures Wi-Fi BT Smart Coex based on the inputs provided.
  * Note: This should be called every time LE scan interval and/or scan window is updated.
  *
+ * The library keeps a shadow of the configuration last committed to each radio
+ * and only sends the side whose payload changed. The BT vendor-specific command
+ * depends only on the scan priority, so when just the scan interval or window
+ * changes, only the Wi-Fi side is updated and bt_config->btcoex_cb is not invoked.
+ * Use \ref cy_smartcoex_force_resync to send both sides on the next call.
+ *
+ * The connection and advertising settings in bt_config are sent in a second
+ * vendor-specific command, only when they change. They concern BT alone and
+ * are not part of the transaction between the two radios: if that command
+ * fails, the scan side stays committed, an error is returned, and the settings
+ * are sent again by the next call. bt_config->btcoex_cb is invoked for both
+ * commands; the opcode of the completion tells them apart.
+ *
  * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure.
  * @param[in]  bt_config    : Pointer to the BT config structure.
  *
@@ -176,6 +511,483 @@ typedef struct
  */
 cy_rslt_t cy_smartcoex_config(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config);
 
+/**
+ * Applies one Smart Coex configuration to several Wi-Fi interfaces, e.g. STA
+ * and soft-AP in concurrent mode.
+ *
+ * The BT vendor-specific command is sent once. The WHD interface of each
+ * Wi-Fi interface is resolved once and cached by the port. Interfaces served
+ * by one WHD driver instance share its coex config, so the ioctl is issued
+ * once per driver, and not at all for interfaces already covered by the last
+ * commit. Commits through \ref cy_smartcoex_config that name an interface
+ * covered by the last commit are skipped the same way.
+ *
+ * An interface that cannot take the config, e.g. STA while it is down, does
+ * not keep the others from it. The config is committed to BT and to the
+ * interfaces that took it, the error of the first failed interface is returned,
+ * and the failed interfaces are sent again by the next call. Only if no
+ * interface takes the config is nothing committed.
+ *
+ * @param[in]  wifi_configs : Array of Wi-Fi config structures, one per interface.
+ * @param[in]  count        : Number of entries in wifi_configs.
+ * @param[in]  bt_config    : Pointer to the BT config structure.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_config_batch(cy_smartcoex_wifi_config_t *wifi_configs, uint8_t count, cy_smartcoex_bt_config_t *bt_config);
+
+/**
+ * Invalidates the shadow of the committed configuration.
+ *
+ * The next call to \ref cy_smartcoex_config sends both the BT vendor-specific
+ * command and the Wi-Fi coex configuration, even if unchanged. Call this after
+ * the BT stack or the Wi-Fi driver has been restarted. The WHD interface
+ * handles cached by the port are resolved again.
+ */
+void cy_smartcoex_force_resync(void);
+
+/**
+ * Starts the worker thread that commits updates queued by \ref cy_smartcoex_config_async.
+ *
+ * @param[in]  cb   : Completion callback, invoked once per committed update. May be NULL.
+ * @param[in]  arg  : User argument passed to the callback.
+ *
+ * @return status   : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_async_init(cy_smartcoex_async_cb_t cb, void *arg);
+
+/**
+ * Stops the async worker thread. An update that is queued but not yet
+ * committed is discarded.
+ *
+ * @return status   : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_async_deinit(void);
+
+/**
+ * Queues a Smart Coex update and returns without waiting for the radios.
+ *
+ * The parameters are validated in the caller's context. The worker thread then
+ * commits the update as \ref cy_smartcoex_config would. Updates are coalesced
+ * latest-wins: if several are queued before the worker picks one up, only the
+ * most recent is committed and reported through the completion callback. When
+ * the BT stack reports busy or CY_SMARTCOEX_VSC_WINDOW VSCs are still awaiting
+ * completion, the commit is retried with exponential backoff,
+ * bounded by CY_SMARTCOEX_ASYNC_BUSY_RETRY_MAX attempts, and abandoned early in
+ * favour of a newer queued update.
+ *
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure. Copied before return.
+ * @param[in]  bt_config    : Pointer to the BT config structure. Copied before return.
+ *
+ * @return status           : CY_RSLT_SUCCESS if queued; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_config_async(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config);
+
+/**
+ * Creates a Smart Coex context for one BT/Wi-Fi radio pair.
+ *
+ * All library state (committed-config shadow, async worker) lives in the
+ * context, so independent contexts never share or contend on state. The
+ * functions without a context argument operate on a built-in default context.
+ *
+ * Thread safety: every cy_smartcoex_ctx_* call may be made from any thread.
+ * Validation and payload derivation run in the caller's context without locks.
+ * Commits on one context are serialized by a per-context mutex, which is held
+ * across the radio I/O so that the radios see commits in the order they are
+ * recorded; commits on different contexts run in parallel. To keep the
+ * caller off the radio I/O entirely, use \ref cy_smartcoex_ctx_config_async.
+ * \ref cy_smartcoex_ctx_destroy must not race with other calls on the same context.
+ *
+ * @param[out] ctx        : Receives the new context.
+ * @param[in]  radio_ops  : Radio operations for this pair, or NULL for the BT stack and the Wi-Fi port. Copied.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_create(cy_smartcoex_ctx_t **ctx, const cy_smartcoex_radio_ops_t *radio_ops);
+
+/**
+ * Destroys a context created by \ref cy_smartcoex_ctx_create, stopping its
+ * async worker if running. The configuration applied to the radios is left in place.
+ *
+ * @param[in]  ctx     : Context to destroy.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_destroy(cy_smartcoex_ctx_t *ctx);
+
+/**
+ * Context variant of \ref cy_smartcoex_config.
+ *
+ * @param[in]  ctx          : Context.
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure.
+ * @param[in]  bt_config    : Pointer to the BT config structure.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_config(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config);
+
+/**
+ * Context variant of \ref cy_smartcoex_config_batch. With custom radio ops,
+ * nothing is known about which interfaces share a driver, and every interface
+ * not in the last commit gets its own set_wifi_coex_config call.
+ *
+ * @param[in]  ctx          : Context.
+ * @param[in]  wifi_configs : Array of Wi-Fi config structures, one per interface.
+ * @param[in]  count        : Number of entries in wifi_configs.
+ * @param[in]  bt_config    : Pointer to the BT config structure.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_config_batch(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_configs, uint8_t count,
+                                        cy_smartcoex_bt_config_t *bt_config);
+
+/**
+ * Context variant of \ref cy_smartcoex_force_resync.
+ *
+ * @param[in]  ctx     : Context.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_force_resync(cy_smartcoex_ctx_t *ctx);
+
+/**
+ * Context variant of \ref cy_smartcoex_async_init.
+ *
+ * @param[in]  ctx  : Context.
+ * @param[in]  cb   : Completion callback, invoked once per committed update. May be NULL.
+ * @param[in]  arg  : User argument passed to the callback.
+ *
+ * @return status   : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_async_init(cy_smartcoex_ctx_t *ctx, cy_smartcoex_async_cb_t cb, void *arg);
+
+/**
+ * Context variant of \ref cy_smartcoex_async_deinit.
+ *
+ * @param[in]  ctx  : Context.
+ *
+ * @return status   : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_async_deinit(cy_smartcoex_ctx_t *ctx);
+
+/**
+ * Context variant of \ref cy_smartcoex_config_async.
+ *
+ * @param[in]  ctx          : Context.
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure. Copied before return.
+ * @param[in]  bt_config    : Pointer to the BT config structure. Copied before return.
+ *
+ * @return status           : CY_RSLT_SUCCESS if queued; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_config_async(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config);
+
+/**
+ * Registers a coex profile on the default context.
+ *
+ * The profile is validated once and its BT vendor-specific command payload and
+ * WHD coex configuration are prebuilt, so selecting it on the hot path is a
+ * table lookup. Select the profile by setting cy_smartcoex_bt_config_t::scan_priority
+ * to the returned ID. The built-in LOW/MEDIUM/HIGH profiles occupy IDs 0-2.
+ * Profiles cannot be unregistered.
+ *
+ * @param[in]  profile     : Profile to register. Copied.
+ * @param[out] profile_id  : Receives the ID of the profile.
+ *
+ * @return status          : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG if the profile is invalid;
+ *                           CY_RSLT_MW_NOMEM if CY_SMARTCOEX_MAX_PROFILES are registered.
+ */
+cy_rslt_t cy_smartcoex_register_profile(const cy_smartcoex_profile_t *profile, cy_smartcoex_lescan_priority_t *profile_id);
+
+/**
+ * Context variant of \ref cy_smartcoex_register_profile. Profile IDs are per context.
+ *
+ * @param[in]  ctx         : Context.
+ * @param[in]  profile     : Profile to register. Copied.
+ * @param[out] profile_id  : Receives the ID of the profile.
+ *
+ * @return status          : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_register_profile(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_profile_t *profile,
+                                            cy_smartcoex_lescan_priority_t *profile_id);
+
+/**
+ * Reads back a profile of the default context, including the built-in ones.
+ *
+ * @param[in]  profile_id  : Profile ID, or one of the cy_smartcoex_lescan_priority_t values.
+ * @param[out] profile     : Receives the profile parameters.
+ *
+ * @return status          : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG if the ID is not registered.
+ */
+cy_rslt_t cy_smartcoex_get_profile(cy_smartcoex_lescan_priority_t profile_id, cy_smartcoex_profile_t *profile);
+
+/**
+ * Context variant of \ref cy_smartcoex_get_profile.
+ *
+ * @param[in]  ctx         : Context.
+ * @param[in]  profile_id  : Profile ID.
+ * @param[out] profile     : Receives the profile parameters.
+ *
+ * @return status          : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_get_profile(cy_smartcoex_ctx_t *ctx, cy_smartcoex_lescan_priority_t profile_id, cy_smartcoex_profile_t *profile);
+
+/**
+ * Predicts how the BT controller runs LE scan parameters under the profile
+ * selected by bt_config->scan_priority, on the default context.
+ *
+ * A scan window above the profile's max scan window is cut to it, and the scan
+ * interval is scaled by the same ratio. The effective duty cycle and the
+ * airtime taken from a busy Wi-Fi follow from the readjusted parameters. With
+ * a target, the probability of discovering it in time is estimated in closed
+ * form, assuming advertising events at random phases; the host airtime
+ * simulator gives slot-exact figures. Runs in a few microseconds without locks.
+ *
+ * @param[in]  bt_config  : Scan priority, interval and window to evaluate. btcoex_cb is ignored.
+ * @param[in]  target     : Advertiser to discover, or NULL.
+ * @param[out] estimate   : Receives the prediction.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_estimate_scan(const cy_smartcoex_bt_config_t *bt_config, const cy_smartcoex_discovery_target_t *target,
+                                     cy_smartcoex_scan_estimate_t *estimate);
+
+/**
+ * Context variant of \ref cy_smartcoex_estimate_scan.
+ *
+ * @param[in]  ctx        : Context.
+ * @param[in]  bt_config  : Scan priority, interval and window to evaluate.
+ * @param[in]  target     : Advertiser to discover, or NULL.
+ * @param[out] estimate   : Receives the prediction.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_estimate_scan(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_bt_config_t *bt_config,
+                                         const cy_smartcoex_discovery_target_t *target, cy_smartcoex_scan_estimate_t *estimate);
+
+/**
+ * Recommends the LE scan interval and window that meet a discovery target
+ * under the profile selected by bt_config->scan_priority, taking the least
+ * airtime from a busy Wi-Fi, on the default context.
+ *
+ * Only windows within the profile's max scan window are considered, so the
+ * controller runs the recommendation as given. Ties go to the pair that scans
+ * less while Wi-Fi is idle. Uses the model of \ref cy_smartcoex_estimate_scan.
+ * The search tries at most two windows per slot of the advertising period,
+ * fewer with a small max scan window as in the built-in profiles; call it when
+ * the target changes rather than before every commit.
+ *
+ * @param[in]  target     : Advertiser to discover.
+ * @param[in,out] bt_config : scan_priority selects the profile; scan_int and scan_win receive the recommendation.
+ * @param[out] estimate   : Receives the prediction for the recommendation. May be NULL.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters;
+ *                          CY_RSLT_MW_ERROR if no scan parameters meet the target under this profile.
+ */
+cy_rslt_t cy_smartcoex_recommend_scan(const cy_smartcoex_discovery_target_t *target, cy_smartcoex_bt_config_t *bt_config,
+                                      cy_smartcoex_scan_estimate_t *estimate);
+
+/**
+ * Context variant of \ref cy_smartcoex_recommend_scan.
+ *
+ * @param[in]  ctx        : Context.
+ * @param[in]  target     : Advertiser to discover.
+ * @param[in,out] bt_config : scan_priority selects the profile; scan_int and scan_win receive the recommendation.
+ * @param[out] estimate   : Receives the prediction for the recommendation. May be NULL.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_recommend_scan(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_discovery_target_t *target,
+                                          cy_smartcoex_bt_config_t *bt_config, cy_smartcoex_scan_estimate_t *estimate);
+
+/**
+ * Returns the VSC completion tracking of the default context.
+ *
+ * The library hands the BT stack its own completion callback, matches each
+ * completion to its VSC, records the round-trip time and HCI status, and then
+ * invokes bt_config->btcoex_cb. A completion with a non-zero HCI status makes
+ * the next commit resend the VSC. Each BT controller completes vendor-specific
+ * commands in the order they were sent, so completions are matched in send
+ * order per controller, across all contexts sending to it.
+ *
+ * @param[out] status  : Receives the tracking state.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_get_vsc_status(cy_smartcoex_vsc_status_t *status);
+
+/**
+ * Context variant of \ref cy_smartcoex_get_vsc_status.
+ *
+ * @param[in]  ctx     : Context.
+ * @param[out] status  : Receives the tracking state.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_get_vsc_status(cy_smartcoex_ctx_t *ctx, cy_smartcoex_vsc_status_t *status);
+
+/**
+ * Returns the generations live on each radio of the default context.
+ *
+ * Commits are transactional across the two radios. Both payloads are built and
+ * validated, and a VSC slot is reserved, before either radio is touched. The
+ * Wi-Fi ioctl is issued first; if it fails, the VSC is not sent. If the BT stack
+ * rejects the VSC, or its completion reports a failed HCI status, the Wi-Fi side
+ * is rolled back to the config it ran before the commit. A failed rollback leaves
+ * the Wi-Fi side marked for resend by the next commit.
+ *
+ * A rollback triggered by a completion restores the Wi-Fi config from before the
+ * failed commit, undoing any Wi-Fi-only commits made while the VSC was in flight.
+ *
+ * @param[out] gen     : Receives the generations.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_get_generation(cy_smartcoex_generation_t *gen);
+
+/**
+ * Context variant of \ref cy_smartcoex_get_generation.
+ *
+ * @param[in]  ctx     : Context.
+ * @param[out] gen     : Receives the generations.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_get_generation(cy_smartcoex_ctx_t *ctx, cy_smartcoex_generation_t *gen);
+
+/**
+ * Sets where the default context keeps a copy of its snapshot.
+ *
+ * The library writes the snapshot to storage after every commit that changed
+ * either radio. Place storage in RAM that is retained across resets to restore
+ * the configuration on the next boot. storage is not cleared: a snapshot left
+ * there by a previous boot stays valid until the first commit overwrites it.
+ *
+ * @param[in]  storage  : Snapshot storage, or NULL to stop writing it. Must stay valid while set.
+ *
+ * @return status       : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_set_snapshot_storage(cy_smartcoex_snapshot_t *storage);
+
+/**
+ * Context variant of \ref cy_smartcoex_set_snapshot_storage.
+ *
+ * @param[in]  ctx      : Context.
+ * @param[in]  storage  : Snapshot storage, or NULL to stop writing it.
+ *
+ * @return status       : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_set_snapshot_storage(cy_smartcoex_ctx_t *ctx, cy_smartcoex_snapshot_t *storage);
+
+/**
+ * Returns the snapshot of the configuration last committed by the default context.
+ *
+ * @param[out] snapshot  : Receives the snapshot.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; CY_RSLT_MW_ERROR if nothing has been committed yet.
+ */
+cy_rslt_t cy_smartcoex_get_snapshot(cy_smartcoex_snapshot_t *snapshot);
+
+/**
+ * Context variant of \ref cy_smartcoex_get_snapshot.
+ *
+ * @param[in]  ctx       : Context.
+ * @param[out] snapshot  : Receives the snapshot.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_get_snapshot(cy_smartcoex_ctx_t *ctx, cy_smartcoex_snapshot_t *snapshot);
+
+/**
+ * Re-applies a snapshot to both radios of the default context.
+ *
+ * Both the BT vendor-specific command and the Wi-Fi coex config are sent, as
+ * after \ref cy_smartcoex_force_resync, without rebuilding or revalidating the
+ * payloads. Call this on BTM_ENABLED_EVT, or after a Wi-Fi driver restart, to
+ * bring the radios back to the last configuration in a single commit.
+ *
+ * @param[in]  snapshot   : Snapshot to apply, or NULL for the last one committed, or else the one in the snapshot storage.
+ * @param[in]  btcoex_cb  : BT coex status callback, or NULL for the one of the last commit, if any.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG if there is no valid snapshot; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_restore(const cy_smartcoex_snapshot_t *snapshot, btcoex_cb_t btcoex_cb);
+
+/**
+ * Context variant of \ref cy_smartcoex_restore.
+ *
+ * @param[in]  ctx        : Context.
+ * @param[in]  snapshot   : Snapshot to apply, or NULL for the context's own.
+ * @param[in]  btcoex_cb  : BT coex status callback, or NULL.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_restore(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_snapshot_t *snapshot, btcoex_cb_t btcoex_cb);
+
+/**
+ * Enables or disables re-applying the snapshot of the default context when
+ * the Wi-Fi link comes up.
+ *
+ * On every connect event from the port, the Wi-Fi coex config of the snapshot
+ * is sent again, as the link-up may follow a driver restart. The BT side is
+ * only resent if its shadow was invalidated. Nothing is sent before the first
+ * commit, unless the snapshot storage holds a valid snapshot.
+ * Enabling starts a worker thread that runs the restore, so the Wi-Fi event
+ * callback never waits on a commit; disabling stops it.
+ * Requires a context created without custom radio operations.
+ *
+ * @param[in]  enable  : true to re-apply on link-up.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_set_auto_restore(bool enable);
+
+/**
+ * Context variant of \ref cy_smartcoex_set_auto_restore.
+ *
+ * @param[in]  ctx     : Context.
+ * @param[in]  enable  : true to re-apply on link-up.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG for a context with custom radio operations; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_set_auto_restore(cy_smartcoex_ctx_t *ctx, bool enable);
+
+/**
+ * Reads back the coex config live on the given Wi-Fi interface, and the coex
+ * statistics of both radios, through the default context.
+ *
+ * Data younger than max_age_ms is returned from the cache without touching the
+ * bus. Otherwise the live config and the Wi-Fi counters are read from WHD, and
+ * the counter deltas since the previous read are computed. The BT counters are
+ * read with \ref CY_SMARTCOEX_VSC_OCF_BTCX_STATS without waiting for the
+ * completion, so the BT deltas may lag by one read: they cover the interval
+ * between the two most recent completions, and are not valid if no completion
+ * arrived since the previous read. One BT read is outstanding at a time.
+ *
+ * Deltas are reported once per read; a caller polling faster than max_age_ms
+ * sees the same seq and the same deltas again.
+ *
+ * @param[in]  wifi_config  : Wi-Fi interface to read.
+ * @param[in]  max_age_ms   : Maximum age of cached data, in ms; 0 to always read.
+ * @param[out] readback     : Receives the config and statistics.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success, see the valid flags; CY_RSLT_MW_UNSUPPORTED if neither radio can be read; the error of a failed WHD read, with the BT part still filled.
+ */
+cy_rslt_t cy_smartcoex_readback(cy_smartcoex_wifi_config_t *wifi_config, uint32_t max_age_ms, cy_smartcoex_readback_t *readback);
+
+/**
+ * Context variant of \ref cy_smartcoex_readback. The Wi-Fi side is only read
+ * for a context created without custom radio operations.
+ *
+ * @param[in]  ctx          : Context.
+ * @param[in]  wifi_config  : Wi-Fi interface to read.
+ * @param[in]  max_age_ms   : Maximum age of cached data, in ms; 0 to always read.
+ * @param[out] readback     : Receives the config and statistics.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_readback(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, uint32_t max_age_ms,
+                                    cy_smartcoex_readback_t *readback);
+
 /** \} group_smart_functions */
 
 #ifdef __cplusplus
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_arbiter.h
+* @brief Arbiter that merges the coex demands of several application modules
+* into one committed config.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_ARBITER_H_
+#define INCLUDED_CY_SMARTCOEX_ARBITER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * Maximum number of clients of an arbiter; at most 32. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_ARBITER_MAX_CLIENTS
+#define CY_SMARTCOEX_ARBITER_MAX_CLIENTS        (8)
+#endif
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Typedefs
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_typedefs
+ * \{
+ */
+
+/**
+ * Arbiter handle; see \ref cy_smartcoex_arbiter_create.
+ */
+typedef struct cy_smartcoex_arbiter cy_smartcoex_arbiter_t;
+
+/**
+ * Callback invoked from the arbiter thread after each merged config it commits.
+ * Busy retries are not reported, only their final result.
+ *
+ * @param[in]  result     : Result of the commit.
+ * @param[in]  bt_config  : Merged config that was committed.
+ * @param[in]  arg        : User argument passed to \ref cy_smartcoex_arbiter_create.
+ */
+typedef void (*cy_smartcoex_arbiter_cb_t)(cy_rslt_t result, const cy_smartcoex_bt_config_t *bt_config, void *arg);
+
+/** \} group_smartcoex_typedefs */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Coex demand of one client.
+ */
+typedef struct
+{
+    /**
+     * Built-in priority or registered profile ID the client needs at least.
+     * Profiles are ranked by their WLAN priority, then by duty cycle.
+     */
+    cy_smartcoex_lescan_priority_t scan_priority;
+
+    /**
+     * BT scan interval the client needs at most; 0 if the client does not scan.
+     *
+     * Units: slots (1 slot = 0.625 ms)
+     * Range: 0, 4-16384
+     */
+    uint16_t scan_int;
+
+    /**
+     * BT scan window the client needs per scan_int. Ignored when scan_int is 0.
+     *
+     * Units: slots (1 slot = 0.625 ms)
+     * Range: 4-16384
+     */
+    uint16_t scan_win;
+
+    /**
+     * Time after submission at which the demand lapses, as if withdrawn.
+     * 0 keeps the demand until it is withdrawn or replaced.
+     *
+     * Units: milliseconds
+     */
+    uint32_t deadline_ms;
+} cy_smartcoex_demand_t;
+
+/**
+ * Snapshot of an arbiter.
+ */
+typedef struct
+{
+    uint32_t                       clients;         /**< Bit n set if client n is registered. */
+    uint32_t                       active;          /**< Bit n set if client n has a demand in force. */
+    int8_t                         priority_client; /**< Client whose demand set the priority, or -1 for the base config. */
+    cy_smartcoex_lescan_priority_t scan_priority;   /**< Profile ID last committed. */
+    uint16_t                       scan_int;        /**< Scan interval last committed. */
+    uint16_t                       scan_win;        /**< Scan window last committed. */
+    uint32_t                       merges;          /**< Merges of the demands. */
+    uint32_t                       commits;         /**< Merges that changed the config and were committed. */
+    uint32_t                       failures;        /**< Commits that failed, after any busy retries. */
+} cy_smartcoex_arbiter_state_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *                   Functions
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Creates an arbiter on a context and starts its thread.
+ *
+ * Clients submit demands with \ref cy_smartcoex_arbiter_submit. Whenever a
+ * demand is submitted, withdrawn or lapses, the arbiter thread merges the
+ * demands in force in a single pass over the clients:
+ *  - the priority is the highest-ranked profile demanded;
+ *  - the scan interval is the shortest demanded, and the scan window is the
+ *    shortest that gives every client at least its demanded share of scan time.
+ *
+ * The merged config is committed through the same path as
+ * \ref cy_smartcoex_ctx_config only when it differs from the last one
+ * committed. A commit that fails as busy is retried with bounded exponential
+ * backoff; any other failure is reported once and not retried until a submit,
+ * withdrawal or lapse changes the merged config. The base config applies while no
+ * demand is in force, and its scan parameters while no demand includes a scan;
+ * it also supplies btcoex_cb and the LE link settings. It is committed once the
+ * arbiter starts.
+ *
+ * @param[out] arbiter      : Receives the new arbiter.
+ * @param[in]  ctx          : Context, or NULL for the default context.
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure. Copied.
+ * @param[in]  bt_config    : Pointer to the base BT config structure. Copied.
+ * @param[in]  cb           : Called after each commit; may be NULL.
+ * @param[in]  cb_arg       : User argument passed to cb.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_arbiter_create(cy_smartcoex_arbiter_t **arbiter, cy_smartcoex_ctx_t *ctx,
+                                      cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                      cy_smartcoex_arbiter_cb_t cb, void *cb_arg);
+
+/**
+ * Stops and destroys an arbiter. The configuration applied to the radios is left in place.
+ *
+ * @param[in]  arbiter  : Arbiter to destroy.
+ *
+ * @return status       : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_arbiter_destroy(cy_smartcoex_arbiter_t *arbiter);
+
+/**
+ * Registers a client, with no demand.
+ *
+ * @param[in]  arbiter    : Arbiter.
+ * @param[out] client_id  : Receives the client ID.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters;
+ *                          CY_RSLT_MW_NOMEM if CY_SMARTCOEX_ARBITER_MAX_CLIENTS are registered.
+ */
+cy_rslt_t cy_smartcoex_arbiter_add_client(cy_smartcoex_arbiter_t *arbiter, uint8_t *client_id);
+
+/**
+ * Withdraws the demand of a client and unregisters it.
+ *
+ * @param[in]  arbiter    : Arbiter.
+ * @param[in]  client_id  : Client ID.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_arbiter_remove_client(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id);
+
+/**
+ * Submits the demand of a client, replacing its previous one, and restarts its
+ * deadline. Does not block on radio I/O; the merged config is committed by the
+ * arbiter thread.
+ *
+ * @param[in]  arbiter    : Arbiter.
+ * @param[in]  client_id  : Client ID.
+ * @param[in]  demand     : Demand. Copied.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_arbiter_submit(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id, const cy_smartcoex_demand_t *demand);
+
+/**
+ * Withdraws the demand of a client. The client stays registered.
+ *
+ * @param[in]  arbiter    : Arbiter.
+ * @param[in]  client_id  : Client ID.
+ *
+ * @return status         : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_arbiter_withdraw(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id);
+
+/**
+ * Returns a snapshot of the arbiter.
+ *
+ * @param[in]  arbiter  : Arbiter.
+ * @param[out] state    : Receives the snapshot.
+ *
+ * @return status       : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_arbiter_get_state(cy_smartcoex_arbiter_t *arbiter, cy_smartcoex_arbiter_state_t *state);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_CY_SMARTCOEX_ARBITER_H_ */
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_controller.h
+* @brief Closed-loop controller that adapts the coex duty cycle and small
+* interval grant to Wi-Fi and BLE telemetry.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_CONTROLLER_H_
+#define INCLUDED_CY_SMARTCOEX_CONTROLLER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * Maximum number of levels between the Wi-Fi-friendly and the BLE-friendly end
+ * of a controller's range. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_CONTROLLER_MAX_LEVELS
+#define CY_SMARTCOEX_CONTROLLER_MAX_LEVELS      (16)
+#endif
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Typedefs
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_typedefs
+ * \{
+ */
+
+/**
+ * Adaptive controller handle; see \ref cy_smartcoex_controller_create.
+ */
+typedef struct cy_smartcoex_controller cy_smartcoex_controller_t;
+
+/** \} group_smartcoex_typedefs */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Adaptive controller configuration.
+ *
+ * Level 0 applies duty_cycle_min and small_interval_grant_max (Wi-Fi friendly);
+ * level (levels - 1) applies duty_cycle_max and small_interval_grant_min (BLE
+ * friendly). Intermediate levels are interpolated linearly.
+ */
+typedef struct
+{
+    /**
+     * Duty cycle bounds.
+     *
+     * Units: percentage
+     * Range: 0-100, duty_cycle_min <= duty_cycle_max
+     */
+    uint8_t  duty_cycle_min;
+    uint8_t  duty_cycle_max;           /**< See duty_cycle_min. */
+
+    /**
+     * Small interval grant bounds.
+     *
+     * Range: 1-255, small_interval_grant_min <= small_interval_grant_max
+     */
+    uint8_t  small_interval_grant_min;
+    uint8_t  small_interval_grant_max; /**< See small_interval_grant_min. */
+
+    /**
+     * Allowed maximum scan window size, applied at every level.
+     *
+     * Units: slots (1 slot = 0.625 ms)
+     * Range: 4-16384
+     */
+    uint16_t max_scan_window;
+
+    /**
+     * Number of levels.
+     *
+     * Range: 2-CY_SMARTCOEX_CONTROLLER_MAX_LEVELS
+     */
+    uint8_t  levels;
+
+    /**
+     * Advertising report rate at or above which BLE is considered active and
+     * the controller steps towards BLE.
+     *
+     * Units: reports per second
+     */
+    uint32_t ble_active_reports_per_sec;
+
+    /**
+     * Advertising report rate at or below which BLE has nothing to find and the
+     * controller steps towards Wi-Fi. Must be below ble_active_reports_per_sec;
+     * rates in between hold the current level.
+     *
+     * Units: reports per second
+     */
+    uint32_t ble_idle_reports_per_sec;
+
+    /**
+     * Wi-Fi throughput below which Wi-Fi is considered idle. While Wi-Fi is
+     * idle, any advertising report rate above ble_idle_reports_per_sec steps
+     * towards BLE. 0 treats Wi-Fi as always busy.
+     *
+     * Units: kbit/s
+     */
+    uint32_t wifi_idle_kbps;
+
+    /**
+     * Wi-Fi transmit retry rate above which steps towards BLE are blocked while
+     * Wi-Fi is busy.
+     *
+     * Units: percentage of frames
+     * Range: 0-100
+     */
+    uint8_t  wifi_retry_max_percent;
+
+    /**
+     * Number of consecutive samples that must call for the same direction
+     * before the controller moves one level.
+     *
+     * Range: 1-255
+     */
+    uint8_t  hold_samples;
+} cy_smartcoex_controller_config_t;
+
+/**
+ * Telemetry for one sampling interval. Counters are deltas over the interval.
+ */
+typedef struct
+{
+    uint32_t interval_ms;     /**< Length of the interval in milliseconds. */
+    uint32_t wifi_bytes;      /**< Wi-Fi bytes transmitted and received. */
+    uint32_t wifi_frames;     /**< Wi-Fi frames transmitted and received. */
+    uint32_t wifi_retries;    /**< Wi-Fi transmit retries. */
+    uint32_t ble_adv_reports; /**< BLE advertising reports received. */
+} cy_smartcoex_controller_sample_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *                   Functions
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Fills a controller configuration with defaults: duty cycle 10-50%, small
+ * interval grant 1-8, max scan window 48 slots, 8 levels, BLE active at 10 and
+ * idle at 1 report per second, Wi-Fi idle below 64 kbit/s, retry guard at 20%,
+ * and a hold of 3 samples.
+ *
+ * @param[out] config  : Configuration to fill.
+ */
+void cy_smartcoex_controller_default_config(cy_smartcoex_controller_config_t *config);
+
+/**
+ * Creates an adaptive controller on a context.
+ *
+ * The controller owns the coex profile of the context while it exists: every
+ * level's payloads are prebuilt here, and \ref cy_smartcoex_controller_step
+ * commits a level through the same VSC and Wi-Fi paths as
+ * \ref cy_smartcoex_ctx_config. The controller starts at level 0 and commits it
+ * on the first step. bt_config->scan_priority is ignored.
+ *
+ * @param[out] ctrl         : Receives the new controller.
+ * @param[in]  ctx          : Context, or NULL for the default context.
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure. Copied.
+ * @param[in]  bt_config    : Pointer to the BT config structure. Copied.
+ * @param[in]  config       : Controller configuration. Copied.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_controller_create(cy_smartcoex_controller_t **ctrl, cy_smartcoex_ctx_t *ctx,
+                                         cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                         const cy_smartcoex_controller_config_t *config);
+
+/**
+ * Destroys a controller. The configuration applied to the radios is left in place.
+ *
+ * @param[in]  ctrl    : Controller to destroy.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_controller_destroy(cy_smartcoex_controller_t *ctrl);
+
+/**
+ * Counts BLE advertising reports for the next \ref cy_smartcoex_controller_sample.
+ * Intended to be called from the application's scan result callback.
+ *
+ * @param[in]  ctrl    : Controller.
+ * @param[in]  count   : Number of reports received.
+ */
+void cy_smartcoex_controller_report_adv(cy_smartcoex_controller_t *ctrl, uint32_t count);
+
+/**
+ * Collects the telemetry of the interval that just ended: the Wi-Fi counter
+ * deltas read from WHD, and the advertising reports counted by
+ * \ref cy_smartcoex_controller_report_adv. The Wi-Fi deltas of the first
+ * sample are zero.
+ *
+ * @param[in]  ctrl         : Controller.
+ * @param[in]  interval_ms  : Time since the previous sample, in milliseconds.
+ * @param[out] sample       : Receives the telemetry.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; an error code if the Wi-Fi counters could not be read.
+ */
+cy_rslt_t cy_smartcoex_controller_sample(cy_smartcoex_controller_t *ctrl, uint32_t interval_ms,
+                                         cy_smartcoex_controller_sample_t *sample);
+
+/**
+ * Feeds one telemetry sample to the controller.
+ *
+ * The sample either comes from \ref cy_smartcoex_controller_sample or is
+ * injected by the caller. The controller moves at most one level per call, and
+ * only after hold_samples consecutive samples called for that direction. The
+ * radios are written only when the level changes; if the commit fails, the
+ * level is kept and the commit is retried on the next call.
+ *
+ * @param[in]  ctrl    : Controller.
+ * @param[in]  sample  : Telemetry of the interval.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code if the commit failed.
+ */
+cy_rslt_t cy_smartcoex_controller_step(cy_smartcoex_controller_t *ctrl, const cy_smartcoex_controller_sample_t *sample);
+
+/**
+ * Updates the LE scan interval and window. Applied on the next \ref cy_smartcoex_controller_step.
+ *
+ * @param[in]  ctrl      : Controller.
+ * @param[in]  scan_int  : BT scan interval in slots.
+ * @param[in]  scan_win  : BT scan window in slots.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_controller_set_scan_params(cy_smartcoex_controller_t *ctrl, uint16_t scan_int, uint16_t scan_win);
+
+/**
+ * Returns the current level of the controller.
+ *
+ * @param[in]  ctrl    : Controller.
+ *
+ * @return level       : 0 (Wi-Fi friendly) to levels - 1 (BLE friendly).
+ */
+uint8_t cy_smartcoex_controller_get_level(cy_smartcoex_controller_t *ctrl);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_CY_SMARTCOEX_CONTROLLER_H_ */
@@ -36,6 +36,13 @@
 
 #include "cy_log.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * \defgroup group_smartcoex_macros Macros
  */
@@ -53,7 +60,62 @@
  * The application must add this flag to its 'DEFINES' and call
  * `cy_log_init()`. For more details, see README.md.
  */
-#ifdef ENABLE_SMARTCOEX_LOGS
+
+/**
+ * ENABLE_SMARTCOEX_BINARY_LOGS
+ *
+ * When defined, log messages are not formatted. Each one is written in
+ * constant time as a binary record (format ID, level, timestamp, and up to
+ * CY_SMARTCOEX_BINARY_LOG_MAX_ARGS integer arguments) into a lock-free ring
+ * buffer. Records are read with \ref cy_smartcoex_binlog_read and expanded
+ * later, on the device with \ref cy_smartcoex_binlog_format or on a host with
+ * the decoder in hostsim/tools. Takes precedence over ENABLE_SMARTCOEX_LOGS.
+ *
+ * The format ID is the offset of the format string in the smartcoex_log_fmt
+ * section, so a host decoder needs that section of the application image:
+ *
+ *     arm-none-eabi-objcopy -O binary --only-section=smartcoex_log_fmt app.elf fmt.bin
+ *
+ * Requires GCC or Clang, and atomic read-modify-write instructions (Cortex-M3
+ * and above).
+ */
+
+/**
+ * Number of records held by the ring buffer; must be a power of two. Older
+ * records are overwritten. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_BINARY_LOG_RECORDS
+#define CY_SMARTCOEX_BINARY_LOG_RECORDS         (64)
+#endif
+
+/**
+ * Most verbose level recorded in binary mode; less important levels compile to nothing.
+ */
+#ifndef CY_SMARTCOEX_BINARY_LOG_LEVEL
+#define CY_SMARTCOEX_BINARY_LOG_LEVEL           (CY_LOG_DEBUG)
+#endif
+
+/** Number of arguments stored per binary record. Further arguments are dropped. */
+#define CY_SMARTCOEX_BINARY_LOG_MAX_ARGS        (4)
+
+#if defined(ENABLE_SMARTCOEX_BINARY_LOGS)
+#if !defined(__GNUC__)
+#error "ENABLE_SMARTCOEX_BINARY_LOGS requires GCC or Clang"
+#endif
+#define cy_smartcoex_log_msg(facility, level, fmt, ...)                                                         \
+    do                                                                                                          \
+    {                                                                                                           \
+        if((level) <= CY_SMARTCOEX_BINARY_LOG_LEVEL)                                                            \
+        {                                                                                                       \
+            static const char smartcoex_log_fmt_str[] __attribute__((section("smartcoex_log_fmt"), used)) = fmt; \
+            const uint32_t smartcoex_log_args[] = { 0, ##__VA_ARGS__ };                                          \
+            (void)(facility);                                                                                   \
+            cy_smartcoex_binlog_write((uint8_t)(level), smartcoex_log_fmt_str,                                  \
+                                      (uint8_t)(sizeof(smartcoex_log_args) / sizeof(uint32_t) - 1U),            \
+                                      &smartcoex_log_args[1]);                                                  \
+        }                                                                                                       \
+    } while(0)
+#elif defined(ENABLE_SMARTCOEX_LOGS)
 #define cy_smartcoex_log_msg cy_log_msg
 #else
 #define cy_smartcoex_log_msg(a,b,c,...)
@@ -61,4 +123,96 @@
 
 /** \} group_smartcoex_macros */
 
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Binary log record. Integer arguments are stored as 32-bit values; string
+ * arguments are not supported in binary mode.
+ */
+typedef struct
+{
+    uint32_t seq;                                      /**< Sequence number of the record, starting at 1. */
+    uint32_t timestamp;                                /**< Port timestamp at the time of the call; see \ref cy_smartcoex_binlog_read. */
+    uint16_t fmt_id;                                   /**< Offset of the format string in the smartcoex_log_fmt section. */
+    uint8_t  level;                                    /**< CY_LOG_LEVEL_T of the message. */
+    uint8_t  nargs;                                    /**< Number of valid entries in args. */
+    uint32_t args[CY_SMARTCOEX_BINARY_LOG_MAX_ARGS];   /**< Arguments, in format order. */
+} cy_smartcoex_binlog_record_t;
+
+/** \} group_smartcoex_structs */
+
+#if defined(ENABLE_SMARTCOEX_BINARY_LOGS)
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Writes one binary record. Called by cy_smartcoex_log_msg(); lock-free and
+ * safe from any thread.
+ *
+ * @param[in]  level  : Log level.
+ * @param[in]  fmt    : Format string in the smartcoex_log_fmt section.
+ * @param[in]  nargs  : Number of arguments.
+ * @param[in]  args   : Arguments.
+ */
+void cy_smartcoex_binlog_write(uint8_t level, const char *fmt, uint8_t nargs, const uint32_t *args);
+
+/**
+ * Copies the records written since a cursor, oldest first. Records overwritten
+ * before they could be read are skipped, and can be detected as gaps in seq.
+ *
+ * @param[in,out] cursor       : Sequence number of the last record read; 0 to start from the oldest held record. Updated.
+ * @param[out]    records      : Receives the records.
+ * @param[in]     max_records  : Capacity of records.
+ * @param[out]    us_per_mtick : Optional; receives the microseconds per 10^6 timestamp ticks, for converting timestamps.
+ *
+ * @return count               : Number of records copied.
+ */
+uint32_t cy_smartcoex_binlog_read(uint32_t *cursor, cy_smartcoex_binlog_record_t *records, uint32_t max_records,
+                                  uint32_t *us_per_mtick);
+
+/**
+ * Returns the format string of a record in this image.
+ *
+ * @param[in]  fmt_id  : Format ID from a record.
+ *
+ * @return fmt         : The format string.
+ */
+const char *cy_smartcoex_binlog_fmt(uint16_t fmt_id);
+
+/** \} group_smartcoex_functions */
+
+#endif /* ENABLE_SMARTCOEX_BINARY_LOGS */
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Expands a binary record with its format string. Supports the d, i, u, x, X,
+ * o and c conversions with flags, width, precision, and the h, l and z
+ * length modifiers; other conversions print as '?'. Available in every log
+ * mode, so that host decoders can link it.
+ *
+ * @param[in]  fmt     : Format string of the record.
+ * @param[in]  record  : Record.
+ * @param[out] buf     : Output buffer.
+ * @param[in]  len     : Size of buf.
+ *
+ * @return length      : Length of the expanded message, excluding the terminator.
+ */
+int cy_smartcoex_binlog_format(const char *fmt, const cy_smartcoex_binlog_record_t *record, char *buf, size_t len);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
 #endif /* INCLUDED_CY_SMARTCOEX_LOG_H_ */
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_policy.h
+* @brief Event-driven policy engine that switches the coex profile on Wi-Fi
+* and BLE scan state changes.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_POLICY_H_
+#define INCLUDED_CY_SMARTCOEX_POLICY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * Maximum number of rules in a policy. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_POLICY_MAX_RULES
+#define CY_SMARTCOEX_POLICY_MAX_RULES           (8)
+#endif
+
+/** Condition: the Wi-Fi STA is connected. */
+#define CY_SMARTCOEX_COND_WIFI_CONNECTED        (1UL << 0)
+
+/** Condition: a Wi-Fi scan is in progress. */
+#define CY_SMARTCOEX_COND_WIFI_SCANNING         (1UL << 1)
+
+/** Condition: a Wi-Fi bulk transfer is active. */
+#define CY_SMARTCOEX_COND_WIFI_BULK             (1UL << 2)
+
+/** Condition: a BLE scan is in progress. */
+#define CY_SMARTCOEX_COND_BLE_SCANNING          (1UL << 3)
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_enums
+ * \{
+ */
+
+/**
+ * Events fed to a policy engine. Wi-Fi connection events are delivered by the
+ * port when the engine subscribes to them; the others are posted by the
+ * application with \ref cy_smartcoex_policy_post_event.
+ */
+typedef enum
+{
+    CY_SMARTCOEX_EVENT_WIFI_CONNECTED = 0,  /**< Sets CY_SMARTCOEX_COND_WIFI_CONNECTED.   */
+    CY_SMARTCOEX_EVENT_WIFI_DISCONNECTED,   /**< Clears CY_SMARTCOEX_COND_WIFI_CONNECTED. */
+    CY_SMARTCOEX_EVENT_WIFI_SCAN_START,     /**< Sets CY_SMARTCOEX_COND_WIFI_SCANNING.    */
+    CY_SMARTCOEX_EVENT_WIFI_SCAN_COMPLETE,  /**< Clears CY_SMARTCOEX_COND_WIFI_SCANNING.  */
+    CY_SMARTCOEX_EVENT_WIFI_BULK_START,     /**< Sets CY_SMARTCOEX_COND_WIFI_BULK.        */
+    CY_SMARTCOEX_EVENT_WIFI_BULK_STOP,      /**< Clears CY_SMARTCOEX_COND_WIFI_BULK.      */
+    CY_SMARTCOEX_EVENT_BLE_SCAN_START,      /**< Sets CY_SMARTCOEX_COND_BLE_SCANNING.     */
+    CY_SMARTCOEX_EVENT_BLE_SCAN_STOP,       /**< Clears CY_SMARTCOEX_COND_BLE_SCANNING.   */
+    CY_SMARTCOEX_EVENT_MAX                  /**< Number of events. */
+} cy_smartcoex_event_t;
+
+/** \} group_smartcoex_enums */
+
+/******************************************************
+ *                   Typedefs
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_typedefs
+ * \{
+ */
+
+/**
+ * Policy engine handle; see \ref cy_smartcoex_policy_create.
+ */
+typedef struct cy_smartcoex_policy cy_smartcoex_policy_t;
+
+/**
+ * Callback invoked from the policy engine thread after each profile switch it commits,
+ * once per switch: busy retries are not reported, only their final result.
+ *
+ * @param[in]  result         : Result of the commit.
+ * @param[in]  scan_priority  : Profile ID that was committed.
+ * @param[in]  arg            : User argument from the policy configuration.
+ */
+typedef void (*cy_smartcoex_policy_cb_t)(cy_rslt_t result, cy_smartcoex_lescan_priority_t scan_priority, void *arg);
+
+/** \} group_smartcoex_typedefs */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Policy rule. A rule matches while all of its required conditions are set and
+ * none of its excluded conditions are.
+ */
+typedef struct
+{
+    uint32_t require;           /**< CY_SMARTCOEX_COND_* bits that must be set. */
+    uint32_t exclude;           /**< CY_SMARTCOEX_COND_* bits that must be clear. */
+
+    /**
+     * How long the rule keeps matching after the latest of its required
+     * conditions was set. 0 matches for as long as the conditions hold.
+     *
+     * Units: milliseconds
+     */
+    uint32_t duration_ms;
+
+    cy_smartcoex_lescan_priority_t scan_priority; /**< Built-in priority or registered profile ID to apply. */
+} cy_smartcoex_policy_rule_t;
+
+/**
+ * Policy engine configuration.
+ *
+ * Rules are evaluated in order and the first match wins; default_priority
+ * applies when none matches. For example, "LOW while a Wi-Fi bulk transfer is
+ * active, HIGH for 10 s after BLE scan start" is the rule list
+ * { { WIFI_BULK, 0, 0, LOW }, { BLE_SCANNING, 0, 10000, HIGH } }.
+ */
+typedef struct
+{
+    cy_smartcoex_policy_rule_t     rules[CY_SMARTCOEX_POLICY_MAX_RULES]; /**< Rules, in order of precedence. */
+    uint8_t                        rule_count;       /**< Number of rules. */
+    cy_smartcoex_lescan_priority_t default_priority; /**< Profile applied when no rule matches. */
+
+    /**
+     * Quiet time after the last event before the policy is evaluated, so that
+     * bursts of events cause a single commit.
+     *
+     * Units: milliseconds
+     */
+    uint32_t                       debounce_ms;
+
+    bool                           wifi_events;      /**< Subscribe to Wi-Fi connection events through the port. */
+    cy_smartcoex_policy_cb_t       cb;               /**< Called after each commit; may be NULL. */
+    void                           *cb_arg;          /**< User argument passed to cb. */
+} cy_smartcoex_policy_config_t;
+
+/**
+ * Snapshot of a policy engine.
+ */
+typedef struct
+{
+    uint32_t                       conditions;       /**< CY_SMARTCOEX_COND_* bits currently set. */
+    int8_t                         active_rule;      /**< Index of the matching rule, or -1 for the default. */
+    cy_smartcoex_lescan_priority_t scan_priority;    /**< Profile ID last committed. */
+    uint32_t                       commits;          /**< Profile switches committed. */
+    uint32_t                       failures;         /**< Profile switches that failed. */
+} cy_smartcoex_policy_state_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *                   Functions
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Creates a policy engine on a context and starts its thread.
+ *
+ * The engine blocks until an event is posted or a rule's duration or the
+ * debounce time elapses; it never polls. When the evaluated profile or the BLE
+ * scan parameters differ from what was last committed, it commits them through
+ * the same path as \ref cy_smartcoex_ctx_config. A commit that fails as busy is
+ * retried with bounded exponential backoff; any other failure is reported and
+ * not retried until the next event.
+ * The default priority is committed once the engine starts.
+ * bt_config->scan_priority is ignored.
+ *
+ * @param[out] policy       : Receives the new engine.
+ * @param[in]  ctx          : Context, or NULL for the default context.
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure. Copied.
+ * @param[in]  bt_config    : Pointer to the BT config structure with the initial scan parameters. Copied.
+ * @param[in]  config       : Policy configuration. Copied.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_policy_create(cy_smartcoex_policy_t **policy, cy_smartcoex_ctx_t *ctx,
+                                     cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                     const cy_smartcoex_policy_config_t *config);
+
+/**
+ * Stops and destroys a policy engine. The configuration applied to the radios is left in place.
+ *
+ * @param[in]  policy  : Engine to destroy.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_policy_destroy(cy_smartcoex_policy_t *policy);
+
+/**
+ * Posts an event to the engine. Does not block on radio I/O; safe to call from
+ * WCM, BT stack, and application callbacks.
+ *
+ * @param[in]  policy  : Engine.
+ * @param[in]  event   : Event.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_policy_post_event(cy_smartcoex_policy_t *policy, cy_smartcoex_event_t event);
+
+/**
+ * Reports a BLE scan state change, typically from the BTM_BLE_SCAN_STATE_CHANGED_EVT
+ * management event. Posts CY_SMARTCOEX_EVENT_BLE_SCAN_START or
+ * CY_SMARTCOEX_EVENT_BLE_SCAN_STOP; the scan interval and window of a started
+ * scan are committed with the next profile.
+ *
+ * @param[in]  policy    : Engine.
+ * @param[in]  scanning  : true if a scan started, false if it stopped.
+ * @param[in]  scan_int  : BT scan interval in slots. Ignored when scanning is false.
+ * @param[in]  scan_win  : BT scan window in slots. Ignored when scanning is false.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_policy_ble_scan(cy_smartcoex_policy_t *policy, bool scanning, uint16_t scan_int, uint16_t scan_win);
+
+/**
+ * Returns a snapshot of the engine.
+ *
+ * @param[in]  policy  : Engine.
+ * @param[out] state   : Receives the snapshot.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_policy_get_state(cy_smartcoex_policy_t *policy, cy_smartcoex_policy_state_t *state);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_CY_SMARTCOEX_POLICY_H_ */
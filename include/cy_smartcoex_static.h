@@ -0,0 +1,239 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_static.h
+* @brief Coex configurations fixed at build time, with a bounded-time switch.
+*
+* A static configuration is checked by the compiler and holds the VSC and WHD
+* payloads as const data. Switching to it skips parameter validation and
+* profile lookup, and returns busy rather than waiting for a commit in
+* progress, so it can be called from a timer callback or a thread deferred
+* from an ISR.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_STATIC_H_
+#define INCLUDED_CY_SMARTCOEX_STATIC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/** Range of the BT scan interval and scan window, in slots. */
+#define CY_SMARTCOEX_SCAN_SLOTS_MIN                     (4)
+#define CY_SMARTCOEX_SCAN_SLOTS_MAX                     (16384) /**< \copydoc CY_SMARTCOEX_SCAN_SLOTS_MIN */
+
+/** Built-in LOW priority profile: duty cycle in percent, max scan window in slots, small interval grant. */
+#define CY_SMARTCOEX_PROFILE_LOW_DUTY_CYCLE             (25)
+#define CY_SMARTCOEX_PROFILE_LOW_MAX_SCAN_WINDOW        (48)    /**< \copydoc CY_SMARTCOEX_PROFILE_LOW_DUTY_CYCLE */
+#define CY_SMARTCOEX_PROFILE_LOW_SMALL_INTERVAL_GRANT   (4)     /**< \copydoc CY_SMARTCOEX_PROFILE_LOW_DUTY_CYCLE */
+
+/** Built-in MEDIUM priority profile: duty cycle in percent, max scan window in slots, small interval grant. */
+#define CY_SMARTCOEX_PROFILE_MEDIUM_DUTY_CYCLE          (50)
+#define CY_SMARTCOEX_PROFILE_MEDIUM_MAX_SCAN_WINDOW     (48)    /**< \copydoc CY_SMARTCOEX_PROFILE_MEDIUM_DUTY_CYCLE */
+#define CY_SMARTCOEX_PROFILE_MEDIUM_SMALL_INTERVAL_GRANT (2)    /**< \copydoc CY_SMARTCOEX_PROFILE_MEDIUM_DUTY_CYCLE */
+
+/** Built-in HIGH priority profile: duty cycle in percent, max scan window in slots, small interval grant. */
+#define CY_SMARTCOEX_PROFILE_HIGH_DUTY_CYCLE            (90)
+#define CY_SMARTCOEX_PROFILE_HIGH_MAX_SCAN_WINDOW       (48)    /**< \copydoc CY_SMARTCOEX_PROFILE_HIGH_DUTY_CYCLE */
+#define CY_SMARTCOEX_PROFILE_HIGH_SMALL_INTERVAL_GRANT  (1)     /**< \copydoc CY_SMARTCOEX_PROFILE_HIGH_DUTY_CYCLE */
+
+/** Length of the LE scan coex VSC payload. */
+#define CY_SMARTCOEX_STATIC_VSC_PARAM_LEN               (4)
+
+/** \cond INTERNAL */
+/* 0 if cond holds; a negative array size, and so a compile error, otherwise */
+#define CY_SMARTCOEX_STATIC_CHECK(cond)                 (0U * sizeof(char[(cond) ? 1 : -1]))
+
+/* Parameter of the built-in profile of priority */
+#define CY_SMARTCOEX_STATIC_PROFILE(priority, param)                                        \
+    (((priority) == CY_SMARTCOEX_LESCAN_PRIORITY_LOW)    ? CY_SMARTCOEX_PROFILE_LOW_##param :    \
+     ((priority) == CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM) ? CY_SMARTCOEX_PROFILE_MEDIUM_##param : \
+                                                           CY_SMARTCOEX_PROFILE_HIGH_##param)
+/** \endcond */
+
+/**
+ * Initializer of a \ref cy_smartcoex_static_config_t. All arguments must be
+ * constant expressions; an invalid combination fails the build.
+ *
+ * @param[in]  scan_prio      : Built-in scan priority, CY_SMARTCOEX_LESCAN_PRIORITY_LOW/MEDIUM/HIGH.
+ * @param[in]  scan_interval  : BT scan interval in slots, 4-16384.
+ * @param[in]  scan_window    : BT scan window in slots, 4-16384 and at most scan_interval.
+ * @param[in]  coex_cb        : BT coex status callback, or NULL.
+ *
+ * Example:
+ * @code
+ * static const cy_smartcoex_static_config_t scan_idle =
+ *     CY_SMARTCOEX_STATIC_CONFIG_INIT(CY_SMARTCOEX_LESCAN_PRIORITY_LOW, 160, 16, NULL);
+ * @endcode
+ */
+#define CY_SMARTCOEX_STATIC_CONFIG_INIT(scan_prio, scan_interval, scan_window, coex_cb)                               \
+{                                                                                                                     \
+    .scan_priority = (cy_smartcoex_lescan_priority_t)((scan_prio) +                                                   \
+                     CY_SMARTCOEX_STATIC_CHECK((unsigned int)(scan_prio) <= CY_SMARTCOEX_LESCAN_PRIORITY_HIGH)),      \
+    .scan_int      = (uint16_t)((scan_interval) +                                                                     \
+                     CY_SMARTCOEX_STATIC_CHECK((scan_interval) >= CY_SMARTCOEX_SCAN_SLOTS_MIN &&                      \
+                                               (scan_interval) <= CY_SMARTCOEX_SCAN_SLOTS_MAX)),                      \
+    .scan_win      = (uint16_t)((scan_window) +                                                                       \
+                     CY_SMARTCOEX_STATIC_CHECK((scan_window) >= CY_SMARTCOEX_SCAN_SLOTS_MIN &&                        \
+                                               (scan_window) <= CY_SMARTCOEX_SCAN_SLOTS_MAX &&                        \
+                                               (scan_window) <= (scan_interval))),                                    \
+    .btcoex_cb     = (coex_cb),                                                                                       \
+    .vsc_param     =                                                                                                  \
+    {                                                                                                                 \
+        (uint8_t)(CY_SMARTCOEX_STATIC_PROFILE(scan_prio, MAX_SCAN_WINDOW) & 0xFFU),                                   \
+        (uint8_t)(CY_SMARTCOEX_STATIC_PROFILE(scan_prio, MAX_SCAN_WINDOW) >> 8),                                      \
+        (uint8_t)CY_SMARTCOEX_STATIC_PROFILE(scan_prio, DUTY_CYCLE),                                                  \
+        (uint8_t)CY_SMARTCOEX_STATIC_PROFILE(scan_prio, SMALL_INTERVAL_GRANT)                                         \
+    },                                                                                                                \
+    .wifi_config   =                                                                                                  \
+    {                                                                                                                 \
+        .le_scan_params =                                                                                             \
+        {                                                                                                             \
+            .priority   = (uint16_t)(scan_prio),                                                                      \
+            .duty_cycle = (uint16_t)CY_SMARTCOEX_STATIC_PROFILE(scan_prio, DUTY_CYCLE),                               \
+            .max_win    = (uint16_t)CY_SMARTCOEX_STATIC_PROFILE(scan_prio, MAX_SCAN_WINDOW),                          \
+            .int_grant  = (uint16_t)CY_SMARTCOEX_STATIC_PROFILE(scan_prio, SMALL_INTERVAL_GRANT),                     \
+            .scan_int   = (uint16_t)(scan_interval),                                                                  \
+            .scan_win   = (uint16_t)(scan_window)                                                                     \
+        }                                                                                                             \
+    }                                                                                                                 \
+}
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Coex configuration fixed at build time. Define it with
+ * \ref CY_SMARTCOEX_STATIC_CONFIG_INIT only; the payloads are not checked at
+ * run time. LE link coex is left to the controller's default policy.
+ */
+typedef struct
+{
+    cy_smartcoex_lescan_priority_t scan_priority;   /**< Built-in scan priority. */
+    uint16_t          scan_int;                     /**< BT scan interval, in slots. */
+    uint16_t          scan_win;                     /**< BT scan window, in slots. */
+    btcoex_cb_t       btcoex_cb;                    /**< BT coex status callback. */
+    uint8_t           vsc_param[CY_SMARTCOEX_STATIC_VSC_PARAM_LEN]; /**< LE scan coex VSC payload, little-endian. */
+    whd_coex_config_t wifi_config;                  /**< Coex config of the WHD ioctl. */
+} cy_smartcoex_static_config_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Resolves the handle of a Wi-Fi interface ahead of \ref cy_smartcoex_static_apply,
+ * so that the first switch does not look it up. Call again after the Wi-Fi
+ * interface has been brought up anew.
+ *
+ * @param[in]  wifi_config  : Wi-Fi interface the static configurations are applied to.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; the error of the port otherwise.
+ */
+cy_rslt_t cy_smartcoex_static_prepare(const cy_smartcoex_wifi_config_t *wifi_config);
+
+/**
+ * Context variant of \ref cy_smartcoex_static_prepare. Nothing is resolved for
+ * a context created with custom radio operations.
+ *
+ * @param[in]  ctx          : Context.
+ * @param[in]  wifi_config  : Wi-Fi interface the static configurations are applied to.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_static_prepare(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_wifi_config_t *wifi_config);
+
+/**
+ * Switches to a static configuration. Commits like \ref cy_smartcoex_config,
+ * with the same skipping of unchanged radios and the same rollback, but
+ * without validating or building the payloads. Does not wait for another
+ * commit in progress: it then fails with CY_RSLT_MW_TIMEOUT, as it does when
+ * the BT stack is busy, and the caller retries later.
+ *
+ * The time taken is bounded by the WHD ioctl and the BT stack's send of the
+ * VSC, which block and so must not be called from an ISR itself. From an
+ * ISR, defer to a thread or a timer callback.
+ *
+ * @param[in]  wifi_config  : Wi-Fi interface on which to apply the configuration.
+ * @param[in]  config       : Static configuration.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_TIMEOUT if a commit is in progress or the BT stack is busy; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_static_apply(const cy_smartcoex_wifi_config_t *wifi_config, const cy_smartcoex_static_config_t *config);
+
+/**
+ * Context variant of \ref cy_smartcoex_static_apply.
+ *
+ * @param[in]  ctx          : Context.
+ * @param[in]  wifi_config  : Wi-Fi interface on which to apply the configuration.
+ * @param[in]  config       : Static configuration.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_TIMEOUT if busy; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_static_apply(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_wifi_config_t *wifi_config,
+                                        const cy_smartcoex_static_config_t *config);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* ifndef INCLUDED_CY_SMARTCOEX_STATIC_H_ */
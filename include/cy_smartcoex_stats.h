@@ -0,0 +1,211 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_stats.h
+* @brief Per-stage latency histograms and result counters of the coex
+* configuration path. Available when ENABLE_SMARTCOEX_STATS is defined.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_STATS_H_
+#define INCLUDED_CY_SMARTCOEX_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+#ifdef ENABLE_SMARTCOEX_STATS
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * ENABLE_SMARTCOEX_STATS
+ *
+ * When defined, the library timestamps each stage of a coex update and counts
+ * results. When not defined, the instrumentation and this API are compiled out.
+ */
+
+/**
+ * Number of histogram buckets. Bucket 0 counts latencies below 1 us; bucket i
+ * counts latencies from 2^(i-1) us up to 2^i us; the last bucket also counts
+ * everything above.
+ */
+#define CY_SMARTCOEX_STATS_BUCKETS              (24)
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_enums
+ * \{
+ */
+
+/**
+ * Timed stages of a coex update
+ */
+typedef enum
+{
+    CY_SMARTCOEX_STATS_STAGE_VALIDATE = 0,  /**< Parameter validation.                                  */
+    CY_SMARTCOEX_STATS_STAGE_VSC_SEND,      /**< Call into the BT stack to send the VSC.                */
+    CY_SMARTCOEX_STATS_STAGE_VSC_COMPLETE,  /**< From the VSC send until btcoex_cb is invoked.          */
+    CY_SMARTCOEX_STATS_STAGE_WIFI_IOCTL,    /**< WHD interface lookup and coex ioctl.                   */
+    CY_SMARTCOEX_STATS_STAGE_CONFIG,        /**< End to end cy_smartcoex_config(), validation included. */
+    CY_SMARTCOEX_STATS_STAGE_APPLIED,       /**< From the start of a commit until the VSC completed and the Wi-Fi ioctl returned. */
+    CY_SMARTCOEX_STATS_STAGE_MAX            /**< Number of stages.                                      */
+} cy_smartcoex_stats_stage_t;
+
+/**
+ * Counted results of a coex update
+ */
+typedef enum
+{
+    CY_SMARTCOEX_STATS_RESULT_SUCCESS = 0,  /**< Committed, or skipped because unchanged. */
+    CY_SMARTCOEX_STATS_RESULT_BUSY,         /**< The BT stack reported busy, or the VSC window was full. */
+    CY_SMARTCOEX_STATS_RESULT_ERROR,        /**< A radio rejected the update.             */
+    CY_SMARTCOEX_STATS_RESULT_BADARG,       /**< Parameters failed validation.            */
+    CY_SMARTCOEX_STATS_RESULT_MAX           /**< Number of results.                       */
+} cy_smartcoex_stats_result_t;
+
+/** \} group_smartcoex_enums */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Latency histogram of one stage.
+ */
+typedef struct
+{
+    uint32_t count;                                 /**< Number of samples.            */
+    uint32_t min_us;                                /**< Smallest sample, in us.       */
+    uint32_t max_us;                                /**< Largest sample, in us.        */
+    uint64_t sum_us;                                /**< Sum of all samples, in us.    */
+    uint32_t buckets[CY_SMARTCOEX_STATS_BUCKETS];   /**< Log2 buckets, see CY_SMARTCOEX_STATS_BUCKETS. */
+} cy_smartcoex_stats_histogram_t;
+
+/**
+ * Snapshot of the statistics of a context.
+ */
+typedef struct
+{
+    cy_smartcoex_stats_histogram_t stage[CY_SMARTCOEX_STATS_STAGE_MAX];   /**< Per-stage latency.   */
+    uint32_t                       result[CY_SMARTCOEX_STATS_RESULT_MAX]; /**< Per-result counters. */
+} cy_smartcoex_stats_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *                   Functions
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Copies the statistics of the default context.
+ *
+ * VSC completions are matched to sends in order per BT controller, so the VSC
+ * completion stage is exact with several controllers too.
+ *
+ * @param[out] stats   : Receives the snapshot.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_stats_get(cy_smartcoex_stats_t *stats);
+
+/**
+ * Clears the statistics of the default context.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_stats_reset(void);
+
+/**
+ * Context variant of \ref cy_smartcoex_stats_get.
+ *
+ * @param[in]  ctx     : Context.
+ * @param[out] stats   : Receives the snapshot.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_stats_get(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_t *stats);
+
+/**
+ * Context variant of \ref cy_smartcoex_stats_reset.
+ *
+ * @param[in]  ctx     : Context.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_ctx_stats_reset(cy_smartcoex_ctx_t *ctx);
+
+/**
+ * Estimates a percentile of a histogram as the upper bound of the bucket that
+ * contains it, capped at the largest sample.
+ *
+ * @param[in]  hist     : Histogram from a snapshot.
+ * @param[in]  percent  : Percentile, 0-100.
+ *
+ * @return latency      : Estimated latency in us; 0 if the histogram is empty.
+ */
+uint32_t cy_smartcoex_stats_percentile(const cy_smartcoex_stats_histogram_t *hist, uint8_t percent);
+
+/** \} group_smartcoex_functions */
+
+#endif /* ENABLE_SMARTCOEX_STATS */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_CY_SMARTCOEX_STATS_H_ */
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_timeline.h
+* @brief Timeline that commits pre-planned coex profile changes at their deadlines.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_TIMELINE_H_
+#define INCLUDED_CY_SMARTCOEX_TIMELINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * Maximum number of entries in a timeline. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_TIMELINE_MAX_ENTRIES
+#define CY_SMARTCOEX_TIMELINE_MAX_ENTRIES       (16)
+#endif
+
+/**
+ * Number of application triggers a timeline accepts, numbered from 1.
+ */
+#define CY_SMARTCOEX_TIMELINE_MAX_TRIGGERS      (8)
+
+/** Trigger of the entries timed from the start of the timeline. */
+#define CY_SMARTCOEX_TIMELINE_START             (0)
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Typedefs
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_typedefs
+ * \{
+ */
+
+/**
+ * Timeline handle; see \ref cy_smartcoex_timeline_create.
+ */
+typedef struct cy_smartcoex_timeline cy_smartcoex_timeline_t;
+
+/**
+ * Callback invoked from the timeline thread after each commit. Busy retries
+ * are not reported, only their final result.
+ *
+ * @param[in]  result  : Result of the commit.
+ * @param[in]  entry   : Index of the entry that was committed.
+ * @param[in]  arg     : User argument from the timeline configuration.
+ */
+typedef void (*cy_smartcoex_timeline_cb_t)(cy_rslt_t result, uint8_t entry, void *arg);
+
+/** \} group_smartcoex_typedefs */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Timeline entry: the profile and scan parameters to commit, and when.
+ */
+typedef struct
+{
+    /**
+     * CY_SMARTCOEX_TIMELINE_START to time the entry from the start of the
+     * timeline, or an application trigger (1 to CY_SMARTCOEX_TIMELINE_MAX_TRIGGERS)
+     * to time it from each \ref cy_smartcoex_timeline_trigger call.
+     */
+    uint8_t  trigger;
+
+    /**
+     * Deadline of the entry, after its trigger.
+     *
+     * Units: milliseconds
+     */
+    uint32_t at_ms;
+
+    cy_smartcoex_lescan_priority_t scan_priority; /**< Built-in priority or registered profile ID to apply. */
+    uint16_t scan_int;          /**< BT scan interval in slots. */
+    uint16_t scan_win;          /**< BT scan window in slots. */
+} cy_smartcoex_timeline_entry_t;
+
+/**
+ * Timeline configuration.
+ *
+ * For example, an OTA window opening 60 s after boot and closing 5 minutes
+ * later, with a BLE inventory sweep of 10 s every time the application raises
+ * trigger 1, is the entry list
+ * { { START, 60000, LOW }, { START, 360000, MEDIUM }, { 1, 0, HIGH }, { 1, 10000, MEDIUM } }.
+ */
+typedef struct
+{
+    cy_smartcoex_timeline_entry_t entries[CY_SMARTCOEX_TIMELINE_MAX_ENTRIES]; /**< Entries, in any order. */
+    uint8_t                       entry_count;  /**< Number of entries. */
+
+    /**
+     * Period with which the entries timed from the start repeat; 0 to run them
+     * once. Must exceed the at_ms of every such entry.
+     *
+     * Units: milliseconds
+     */
+    uint32_t                      period_ms;
+
+    cy_smartcoex_timeline_cb_t    cb;           /**< Called after each commit; may be NULL. */
+    void                          *cb_arg;      /**< User argument passed to cb. */
+} cy_smartcoex_timeline_config_t;
+
+/**
+ * Snapshot of a timeline.
+ */
+typedef struct
+{
+    int8_t   last_entry;        /**< Index of the entry last committed, or -1. */
+    uint32_t commits;           /**< Entries committed. */
+    uint32_t failures;          /**< Entries whose commit failed, after any busy retries. */
+    uint32_t skipped;           /**< Entries superseded by a later entry due at the same time. */
+    uint32_t last_late_ms;      /**< Time from the deadline of the last entry until its commit started, in ms. */
+    uint32_t max_late_ms;       /**< Largest last_late_ms so far, in ms. */
+} cy_smartcoex_timeline_state_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *                   Functions
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+/**
+ * Creates a timeline on a context and starts its thread. The timeline starts
+ * now.
+ *
+ * Every entry is validated, and its profile payloads are copied from the
+ * context's profile table, before the timeline starts. Profiles registered
+ * later do not affect it. At each deadline the thread commits the prebuilt
+ * payloads without any lookup or validation. The commit uses the same path as
+ * \ref cy_smartcoex_ctx_config, so a payload already live is not resent.
+ * The thread blocks until the earliest deadline or a trigger; it never polls.
+ * When several entries are due together, only the latest in time, or else the
+ * last in the list, is committed. A commit that fails as busy is retried with
+ * bounded exponential backoff until the next entry falls due; any other
+ * failure is reported once and the timeline waits for the next entry.
+ *
+ * The thread priority is CY_SMARTCOEX_TIMELINE_THREAD_PRIORITY, which is high
+ * by default so that commits start within a tick of their deadline.
+ *
+ * @param[out] timeline     : Receives the new timeline.
+ * @param[in]  ctx          : Context, or NULL for the default context.
+ * @param[in]  wifi_config  : Pointer to the Wi-Fi config structure. Copied.
+ * @param[in]  bt_config    : BT config with the coex status callback and the LE link settings; the scan priority and parameters are ignored. Copied.
+ * @param[in]  config       : Timeline configuration. Copied.
+ *
+ * @return status           : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_timeline_create(cy_smartcoex_timeline_t **timeline, cy_smartcoex_ctx_t *ctx,
+                                       cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                       const cy_smartcoex_timeline_config_t *config);
+
+/**
+ * Stops and destroys a timeline. The configuration applied to the radios is left in place.
+ *
+ * @param[in]  timeline  : Timeline to destroy.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_timeline_destroy(cy_smartcoex_timeline_t *timeline);
+
+/**
+ * Raises an application trigger, scheduling every entry of that trigger at_ms
+ * from now. Entries of the trigger still pending from a previous call are
+ * rescheduled. Does not block on radio I/O.
+ *
+ * @param[in]  timeline  : Timeline.
+ * @param[in]  trigger   : Trigger, 1 to CY_SMARTCOEX_TIMELINE_MAX_TRIGGERS.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_timeline_trigger(cy_smartcoex_timeline_t *timeline, uint8_t trigger);
+
+/**
+ * Returns a snapshot of the timeline.
+ *
+ * @param[in]  timeline  : Timeline.
+ * @param[out] state     : Receives the snapshot.
+ *
+ * @return status        : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters.
+ */
+cy_rslt_t cy_smartcoex_timeline_get_state(cy_smartcoex_timeline_t *timeline, cy_smartcoex_timeline_state_t *state);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_CY_SMARTCOEX_TIMELINE_H_ */
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+/**
+* @file cy_smartcoex_trace.h
+* @brief Compact binary trace of coex config requests and their outcomes, for
+* replay on a host. Recording is available when ENABLE_SMARTCOEX_TRACE is defined.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_TRACE_H_
+#define INCLUDED_CY_SMARTCOEX_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_smartcoex.h"
+
+/******************************************************
+ *                   Macros
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_macros
+ * \{
+ */
+
+/**
+ * ENABLE_SMARTCOEX_TRACE
+ *
+ * When defined, every commit records its request and its outcome, and every
+ * coex VSC completion its HCI status, into a lock-free ring buffer read with
+ * \ref cy_smartcoex_trace_read. The records are encoded for transfer with
+ * \ref cy_smartcoex_trace_encode and replayed on a host with the replayer in
+ * hostsim/tools. When not defined, the recorder is compiled out; the encoding
+ * functions remain available.
+ *
+ * Requires GCC or Clang, and atomic read-modify-write instructions (Cortex-M3
+ * and above).
+ */
+
+/**
+ * Number of records held by the ring buffer; must be a power of two. Older
+ * records are overwritten. Override in the application's 'DEFINES'.
+ */
+#ifndef CY_SMARTCOEX_TRACE_RECORDS
+#define CY_SMARTCOEX_TRACE_RECORDS              (64)
+#endif
+
+/** Version of the trace encoding. */
+#define CY_SMARTCOEX_TRACE_VERSION              (1)
+
+/** Size of the encoded trace header, in bytes. */
+#define CY_SMARTCOEX_TRACE_HEADER_SIZE          (16)
+
+/** Size of an encoded trace record, in bytes. */
+#define CY_SMARTCOEX_TRACE_RECORD_SIZE          (32)
+
+/** Record flag: the commit applied the Wi-Fi side. */
+#define CY_SMARTCOEX_TRACE_FLAG_WIFI_SENT       (0x01)
+
+/** Record flag: the commit sent the LE scan VSC. */
+#define CY_SMARTCOEX_TRACE_FLAG_VSC_SENT        (0x02)
+
+/** Record flag: the commit sent the LE link VSC. */
+#define CY_SMARTCOEX_TRACE_FLAG_LINK_SENT       (0x04)
+
+/** Record flag: the commit failed because the BT stack was busy. */
+#define CY_SMARTCOEX_TRACE_FLAG_BUSY            (0x08)
+
+/** Record flag: the completion is of the LE link VSC. */
+#define CY_SMARTCOEX_TRACE_FLAG_LINK            (0x10)
+
+/** \} group_smartcoex_macros */
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_enums
+ * \{
+ */
+
+/**
+ * Trace record types
+ */
+typedef enum
+{
+    CY_SMARTCOEX_TRACE_REQUEST = 1,     /**< Config reaching a commit, after validation. Immediately followed by its OUTCOME. */
+    CY_SMARTCOEX_TRACE_OUTCOME,         /**< Result of the commit of the preceding REQUEST of the same context. */
+    CY_SMARTCOEX_TRACE_COMPLETION       /**< Completion of a coex VSC. */
+} cy_smartcoex_trace_type_t;
+
+/** \} group_smartcoex_enums */
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_structs
+ * \{
+ */
+
+/**
+ * Trace record. Only the fields of its type are meaningful.
+ */
+typedef struct
+{
+    uint32_t seq;                       /**< Sequence number of the record, starting at 1. */
+    uint32_t timestamp;                 /**< Port timestamp: the start of the commit for a REQUEST, else the time of the record. */
+    cy_smartcoex_trace_type_t type;     /**< Record type. */
+    uint8_t  ctx_id;                    /**< Context, numbered in order of creation from 0. */
+    uint8_t  flags;                     /**< CY_SMARTCOEX_TRACE_FLAG_* bits. */
+
+    /* CY_SMARTCOEX_TRACE_REQUEST */
+    uint8_t  interfaces;                /**< Mask of the Wi-Fi interfaces, bit n for cy_smartcoex_wifi_interface_t n. */
+    uint8_t  scan_priority;             /**< Scan priority, i.e. the profile, as requested. */
+    cy_smartcoex_profile_t profile;     /**< The profile's parameters, from which le_scan_param was derived. */
+    uint16_t scan_int;                  /**< Requested LE scan interval, in slots. */
+    uint16_t scan_win;                  /**< Requested LE scan window, in slots. */
+    cy_smartcoex_le_event_config_t conn[CY_SMARTCOEX_LE_ROLE_MAX]; /**< LE connection event settings. */
+    cy_smartcoex_le_event_config_t adv; /**< LE advertising event settings. */
+
+    /* CY_SMARTCOEX_TRACE_OUTCOME */
+    cy_rslt_t result;                   /**< Result returned by the commit. */
+    uint32_t wifi_result;               /**< Result of the Wi-Fi side, if sent. */
+    uint16_t vsc_result;                /**< wiced_result_t of sending the LE scan VSC, if sent. */
+    uint16_t link_result;               /**< wiced_result_t of sending the LE link VSC, if sent. */
+    uint32_t vsc_gen;                   /**< Sequence number of the LE scan VSC, if sent. */
+    uint32_t link_gen;                  /**< Sequence number of the LE link VSC, if sent. */
+
+    /* CY_SMARTCOEX_TRACE_COMPLETION */
+    uint8_t  hci_status;                /**< HCI status of the completion. */
+    uint32_t gen;                       /**< Sequence number of the completed VSC, as in vsc_gen or link_gen. */
+    uint32_t rtt_us;                    /**< Time from the send to the completion, in microseconds. */
+} cy_smartcoex_trace_record_t;
+
+/** \} group_smartcoex_structs */
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+/**
+ * \addtogroup group_smartcoex_functions
+ * \{
+ */
+
+#ifdef ENABLE_SMARTCOEX_TRACE
+
+/**
+ * Copies the records written since a cursor, oldest first. Records overwritten
+ * before they could be read are skipped, and can be detected as gaps in seq.
+ *
+ * @param[in,out] cursor       : Sequence number of the last record read; 0 to start from the oldest held record. Updated.
+ * @param[out]    records      : Receives the records.
+ * @param[in]     max_records  : Capacity of records.
+ * @param[out]    us_per_mtick : Optional; receives the microseconds per 10^6 timestamp ticks, for converting timestamps.
+ *
+ * @return count               : Number of records copied.
+ */
+uint32_t cy_smartcoex_trace_read(uint32_t *cursor, cy_smartcoex_trace_record_t *records, uint32_t max_records,
+                                 uint32_t *us_per_mtick);
+
+#endif /* ENABLE_SMARTCOEX_TRACE */
+
+/**
+ * Encodes the header that starts a trace file: "SCXT", the version and record
+ * size as 16-bit, and us_per_mtick as 32-bit little-endian values, then 4
+ * reserved bytes.
+ *
+ * @param[in]  us_per_mtick  : Timestamp scale, as returned by \ref cy_smartcoex_trace_read.
+ * @param[out] buf           : Receives CY_SMARTCOEX_TRACE_HEADER_SIZE bytes.
+ */
+void cy_smartcoex_trace_encode_header(uint32_t us_per_mtick, uint8_t *buf);
+
+/**
+ * Decodes a trace file header.
+ *
+ * @param[in]  buf           : CY_SMARTCOEX_TRACE_HEADER_SIZE bytes.
+ * @param[out] us_per_mtick  : Receives the timestamp scale.
+ *
+ * @return status            : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG if not a trace header;
+ *                             CY_RSLT_MW_UNSUPPORTED for a newer version.
+ */
+cy_rslt_t cy_smartcoex_trace_decode_header(const uint8_t *buf, uint32_t *us_per_mtick);
+
+/**
+ * Encodes a record into CY_SMARTCOEX_TRACE_RECORD_SIZE little-endian bytes:
+ * seq, timestamp, type, ctx_id, flags and a type-specific body.
+ *
+ * @param[in]  record  : Record.
+ * @param[out] buf     : Receives CY_SMARTCOEX_TRACE_RECORD_SIZE bytes.
+ */
+void cy_smartcoex_trace_encode(const cy_smartcoex_trace_record_t *record, uint8_t *buf);
+
+/**
+ * Decodes a record.
+ *
+ * @param[in]  buf     : CY_SMARTCOEX_TRACE_RECORD_SIZE bytes.
+ * @param[out] record  : Receives the record.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG for an unknown record type.
+ */
+cy_rslt_t cy_smartcoex_trace_decode(const uint8_t *buf, cy_smartcoex_trace_record_t *record);
+
+/** \} group_smartcoex_functions */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_CY_SMARTCOEX_TRACE_H_ */
@@ -0,0 +1,567 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_hostsim.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+
+#include "whd.h"
+#include "whd_wifi_api.h"
+
+/* Maximum number of accepted VSCs awaiting completion; further commands are rejected as busy */
+#define HOSTSIM_MAX_PENDING_VSC         32
+
+/* Maximum number of VSCs a script covers */
+#define HOSTSIM_MAX_SCRIPT_VSC          8
+
+/* Simulated latencies below this are spun rather than slept for accuracy */
+#define HOSTSIM_SPIN_THRESHOLD_US       200
+
+typedef struct
+{
+    uint64_t due_ns;
+    uint16_t opcode;
+    uint8_t  status;
+    uint32_t bt_grants;     /* Coex counters returned by a counter read */
+    uint32_t bt_denials;
+    wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback;
+} hostsim_completion_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    pthread_t       thread;
+    bool            initialized;
+    bool            running;
+
+    cy_smartcoex_hostsim_config_t config;
+    cy_smartcoex_hostsim_stats_t  stats;
+
+    hostsim_completion_t pending[HOSTSIM_MAX_PENDING_VSC];
+    uint32_t        head;
+    uint32_t        count;
+
+    wiced_result_t  vsc_result;
+    uint32_t        vsc_result_count;
+    uint8_t         vsc_status;
+    uint32_t        vsc_status_count;
+    wiced_result_t  script_result[HOSTSIM_MAX_SCRIPT_VSC];
+    uint8_t         script_status[HOSTSIM_MAX_SCRIPT_VSC];
+    uint32_t        script_next;
+    uint32_t        script_count;
+    cy_rslt_t       wcm_result;
+    uint32_t        wcm_result_count;
+    uint32_t        wifi_result;
+    uint32_t        wifi_result_count;
+    whd_counters_t  wifi_counters;
+    uint32_t        bt_grants;
+    uint32_t        bt_denials;
+} hostsim_t;
+
+static hostsim_t hostsim = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+/* Opaque handles handed out as the simulated interfaces, all on one simulated driver */
+static struct whd_interface
+{
+    uint32_t bsscfgidx;
+} hostsim_ifaces[] = { { 0 }, { 1 } };
+
+uint64_t cy_smartcoex_hostsim_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void hostsim_delay_us(uint32_t us)
+{
+    uint64_t end;
+    struct timespec ts;
+
+    if(us == 0)
+    {
+        return;
+    }
+
+    if(us < HOSTSIM_SPIN_THRESHOLD_US)
+    {
+        end = cy_smartcoex_hostsim_now_ns() + ((uint64_t)us * 1000ULL);
+        while(cy_smartcoex_hostsim_now_ns() < end)
+        {
+        }
+        return;
+    }
+
+    ts.tv_sec  = us / 1000000U;
+    ts.tv_nsec = (long)(us % 1000000U) * 1000L;
+    nanosleep(&ts, NULL);
+}
+
+static void hostsim_put_le32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static void hostsim_deliver(const hostsim_completion_t *completion)
+{
+    uint8_t buf[9];
+    wiced_bt_dev_vendor_specific_command_complete_params_t params;
+
+    buf[0] = completion->status;
+    params.opcode      = completion->opcode;
+    params.param_len   = 1;
+    params.p_param_buf = buf;
+
+    /* A successful counter read returns the LE uint32_t grants and denials after the status */
+    if(CY_SMARTCOEX_VSC_OCF_BTCX_STATS != 0 && completion->opcode == CY_SMARTCOEX_VSC_OCF_BTCX_STATS &&
+       completion->status == 0)
+    {
+        hostsim_put_le32(&buf[1], completion->bt_grants);
+        hostsim_put_le32(&buf[5], completion->bt_denials);
+        params.param_len = sizeof(buf);
+    }
+
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.stats.vsc_complete_ns = cy_smartcoex_hostsim_now_ns();
+    hostsim.stats.vsc_completions++;
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    if(completion->p_cback != NULL)
+    {
+        completion->p_cback(&params);
+    }
+}
+
+static void *hostsim_completion_thread(void *arg)
+{
+    hostsim_completion_t completion;
+    struct timespec ts;
+    uint64_t now;
+
+    (void)arg;
+
+    pthread_mutex_lock(&hostsim.mutex);
+    while(hostsim.running || hostsim.count > 0)
+    {
+        if(hostsim.count == 0)
+        {
+            pthread_cond_wait(&hostsim.cond, &hostsim.mutex);
+            continue;
+        }
+
+        now = cy_smartcoex_hostsim_now_ns();
+        if(hostsim.pending[hostsim.head].due_ns > now)
+        {
+            /* The condition variable uses CLOCK_REALTIME; convert the relative wait */
+            clock_gettime(CLOCK_REALTIME, &ts);
+            now = hostsim.pending[hostsim.head].due_ns - now;
+            ts.tv_sec  += (time_t)(now / 1000000000ULL);
+            ts.tv_nsec += (long)(now % 1000000000ULL);
+            if(ts.tv_nsec >= 1000000000L)
+            {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&hostsim.cond, &hostsim.mutex, &ts);
+            continue;
+        }
+
+        completion = hostsim.pending[hostsim.head];
+        hostsim.head = (hostsim.head + 1U) % HOSTSIM_MAX_PENDING_VSC;
+        hostsim.count--;
+
+        pthread_mutex_unlock(&hostsim.mutex);
+        hostsim_deliver(&completion);
+        pthread_mutex_lock(&hostsim.mutex);
+
+        pthread_cond_broadcast(&hostsim.cond);
+    }
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    return NULL;
+}
+
+cy_rslt_t cy_smartcoex_hostsim_init(const cy_smartcoex_hostsim_config_t *config)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    if(hostsim.initialized)
+    {
+        pthread_mutex_unlock(&hostsim.mutex);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    memset(&hostsim.config, 0, sizeof(hostsim.config));
+    if(config != NULL)
+    {
+        hostsim.config = *config;
+    }
+    memset(&hostsim.stats, 0, sizeof(hostsim.stats));
+    hostsim.head              = 0;
+    hostsim.count             = 0;
+    hostsim.vsc_result_count  = 0;
+    hostsim.vsc_status_count  = 0;
+    hostsim.script_next       = 0;
+    hostsim.script_count      = 0;
+    hostsim.wcm_result_count  = 0;
+    hostsim.wifi_result_count = 0;
+    memset(&hostsim.wifi_counters, 0, sizeof(hostsim.wifi_counters));
+    hostsim.bt_grants         = 0;
+    hostsim.bt_denials        = 0;
+    hostsim.running           = true;
+
+    if(pthread_create(&hostsim.thread, NULL, hostsim_completion_thread, NULL) != 0)
+    {
+        hostsim.running = false;
+        pthread_mutex_unlock(&hostsim.mutex);
+        return CY_RSLT_MW_ERROR;
+    }
+    hostsim.initialized = true;
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_smartcoex_hostsim_deinit(void)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    if(!hostsim.initialized)
+    {
+        pthread_mutex_unlock(&hostsim.mutex);
+        return;
+    }
+    hostsim.running = false;
+    pthread_cond_broadcast(&hostsim.cond);
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    pthread_join(hostsim.thread, NULL);
+
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.initialized = false;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+void cy_smartcoex_hostsim_inject_vsc_result(wiced_result_t result, uint32_t count)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.vsc_result       = result;
+    hostsim.vsc_result_count = count;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+void cy_smartcoex_hostsim_inject_vsc_status(uint8_t hci_status, uint32_t count)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.vsc_status       = hci_status;
+    hostsim.vsc_status_count = count;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+cy_rslt_t cy_smartcoex_hostsim_script_vsc(const wiced_result_t *results, const uint8_t *hci_statuses, uint32_t count)
+{
+    uint32_t i;
+
+    if(count > HOSTSIM_MAX_SCRIPT_VSC || (count > 0 && (results == NULL || hci_statuses == NULL)))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    pthread_mutex_lock(&hostsim.mutex);
+    for(i = 0; i < count; i++)
+    {
+        hostsim.script_result[i] = results[i];
+        hostsim.script_status[i] = hci_statuses[i];
+    }
+    hostsim.script_next  = 0;
+    hostsim.script_count = count;
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_smartcoex_hostsim_inject_wcm_result(cy_rslt_t result, uint32_t count)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.wcm_result       = result;
+    hostsim.wcm_result_count = count;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+void cy_smartcoex_hostsim_inject_wifi_result(uint32_t result, uint32_t count)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.wifi_result       = result;
+    hostsim.wifi_result_count = count;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+void cy_smartcoex_hostsim_wait_idle(void)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    while(hostsim.count > 0)
+    {
+        pthread_cond_wait(&hostsim.cond, &hostsim.mutex);
+    }
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+void cy_smartcoex_hostsim_get_stats(cy_smartcoex_hostsim_stats_t *stats)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    *stats = hostsim.stats;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+wiced_result_t wiced_bt_dev_vendor_specific_command(uint16_t opcode, uint8_t param_len, uint8_t *p_param_buf,
+                                                    wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback)
+{
+    wiced_result_t result = WICED_BT_PENDING;
+    hostsim_completion_t completion;
+    uint32_t tail;
+    uint32_t delay_us;
+    bool deliver_now = false;
+
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.stats.vsc_enter_ns = cy_smartcoex_hostsim_now_ns();
+    delay_us = hostsim.config.vsc_latency_us;
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    hostsim_delay_us(delay_us);
+
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.stats.vsc_calls++;
+    hostsim.stats.last_vsc_opcode = opcode;
+    hostsim.stats.last_vsc_payload_len = (param_len < sizeof(hostsim.stats.last_vsc_payload)) ?
+                                          param_len : (uint8_t)sizeof(hostsim.stats.last_vsc_payload);
+    memcpy(hostsim.stats.last_vsc_payload, p_param_buf, hostsim.stats.last_vsc_payload_len);
+
+    if(hostsim.script_next < hostsim.script_count)
+    {
+        result = hostsim.script_result[hostsim.script_next];
+    }
+    else if(hostsim.vsc_result_count > 0)
+    {
+        hostsim.vsc_result_count--;
+        result = hostsim.vsc_result;
+    }
+
+    if(result == WICED_BT_PENDING || result == WICED_BT_SUCCESS)
+    {
+        completion.opcode  = opcode;
+        completion.p_cback = p_cback;
+        completion.status  = 0;
+        completion.bt_grants  = hostsim.bt_grants;
+        completion.bt_denials = hostsim.bt_denials;
+        completion.due_ns  = cy_smartcoex_hostsim_now_ns() + ((uint64_t)hostsim.config.vsc_complete_latency_us * 1000ULL);
+        if(hostsim.script_next < hostsim.script_count)
+        {
+            completion.status = hostsim.script_status[hostsim.script_next];
+        }
+        else if(hostsim.vsc_status_count > 0)
+        {
+            hostsim.vsc_status_count--;
+            completion.status = hostsim.vsc_status;
+        }
+
+        if(!hostsim.config.vsc_async_complete)
+        {
+            deliver_now = true;
+        }
+        else if(hostsim.count >= HOSTSIM_MAX_PENDING_VSC || !hostsim.running)
+        {
+            result = WICED_BT_BUSY;
+        }
+        else
+        {
+            tail = (hostsim.head + hostsim.count) % HOSTSIM_MAX_PENDING_VSC;
+            hostsim.pending[tail] = completion;
+            hostsim.count++;
+            pthread_cond_broadcast(&hostsim.cond);
+        }
+    }
+    if(hostsim.script_next < hostsim.script_count)
+    {
+        hostsim.script_next++;
+    }
+    hostsim.stats.vsc_exit_ns = cy_smartcoex_hostsim_now_ns();
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    if(deliver_now)
+    {
+        hostsim_delay_us(hostsim.config.vsc_complete_latency_us);
+        hostsim_deliver(&completion);
+    }
+
+    return result;
+}
+
+void cy_smartcoex_hostsim_wifi_enter(void)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.stats.wifi_enter_ns = cy_smartcoex_hostsim_now_ns();
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+cy_rslt_t cy_smartcoex_hostsim_get_whd_interface(uint32_t bsscfgidx, whd_interface_t *whd_iface)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t delay_us;
+
+    if(bsscfgidx >= sizeof(hostsim_ifaces) / sizeof(hostsim_ifaces[0]))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.stats.wcm_calls++;
+    delay_us = hostsim.config.wcm_latency_us;
+    if(hostsim.wcm_result_count > 0)
+    {
+        hostsim.wcm_result_count--;
+        result = hostsim.wcm_result;
+    }
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    hostsim_delay_us(delay_us);
+
+    *whd_iface = (result == CY_RSLT_SUCCESS) ? &hostsim_ifaces[bsscfgidx] : NULL;
+    return result;
+}
+
+uint32_t whd_wifi_set_coex_config(whd_interface_t ifp, whd_coex_config_t *coex_config)
+{
+    uint32_t result = WHD_SUCCESS;
+    uint32_t delay_us;
+
+    if(ifp == NULL || coex_config == NULL)
+    {
+        return WHD_BADARG;
+    }
+
+    pthread_mutex_lock(&hostsim.mutex);
+    delay_us = hostsim.config.wifi_latency_us;
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    hostsim_delay_us(delay_us);
+
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.stats.wifi_calls++;
+    if(hostsim.wifi_result_count > 0)
+    {
+        hostsim.wifi_result_count--;
+        result = hostsim.wifi_result;
+    }
+    else
+    {
+        hostsim.stats.last_wifi_config = *coex_config;
+    }
+    hostsim.stats.wifi_exit_ns = cy_smartcoex_hostsim_now_ns();
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    return result;
+}
+
+void cy_smartcoex_hostsim_set_wifi_counters(const whd_counters_t *counters)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.wifi_counters = *counters;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+uint32_t whd_wifi_get_counters(whd_interface_t ifp, whd_counters_t *counters)
+{
+    if(ifp == NULL || counters == NULL)
+    {
+        return WHD_BADARG;
+    }
+
+    pthread_mutex_lock(&hostsim.mutex);
+    *counters = hostsim.wifi_counters;
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    return WHD_SUCCESS;
+}
+
+uint32_t whd_wifi_get_iovar_buffer(whd_interface_t ifp, const char *iovar_name, uint8_t *out_buf, uint32_t out_length)
+{
+    if(ifp == NULL || iovar_name == NULL || out_buf == NULL)
+    {
+        return WHD_BADARG;
+    }
+
+    /* Only the LE scan coex iovar is modelled; it holds the last config applied */
+    if(strcmp(iovar_name, "btc_lescan_params") != 0 || out_length > sizeof(whd_btc_lescan_params_t))
+    {
+        return WHD_BADARG;
+    }
+
+    pthread_mutex_lock(&hostsim.mutex);
+    memcpy(out_buf, &hostsim.stats.last_wifi_config.le_scan_params, out_length);
+    pthread_mutex_unlock(&hostsim.mutex);
+
+    return WHD_SUCCESS;
+}
+
+void cy_smartcoex_hostsim_set_bt_coex_counters(uint32_t grants, uint32_t denials)
+{
+    pthread_mutex_lock(&hostsim.mutex);
+    hostsim.bt_grants  = grants;
+    hostsim.bt_denials = denials;
+    pthread_mutex_unlock(&hostsim.mutex);
+}
+
+cy_rslt_t cy_log_msg(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...)
+{
+    va_list args;
+
+    (void)facility;
+    (void)level;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+
+    return CY_RSLT_SUCCESS;
+}
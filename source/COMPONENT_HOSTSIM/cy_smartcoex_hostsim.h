@@ -0,0 +1,168 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_hostsim.h
+* @brief Host simulation port for the Smart Coex library.
+*
+* Provides Linux stand-ins for the BT vendor-specific command and the WHD coex
+* ioctl so that the configuration path can be exercised and benchmarked
+* without a kit attached. Build with COMPONENTS=HOSTSIM instead of WCM.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_HOSTSIM_H_
+#define INCLUDED_CY_SMARTCOEX_HOSTSIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_result.h"
+#include "wiced_bt_dev.h"
+#include "whd_types.h"
+
+/**
+ * Latency and completion behaviour of the simulated radios.
+ */
+typedef struct
+{
+    uint32_t vsc_latency_us;          /**< Time spent inside wiced_bt_dev_vendor_specific_command(). */
+    uint32_t vsc_complete_latency_us; /**< Delay between the VSC being accepted and its completion callback. */
+    bool     vsc_async_complete;      /**< Deliver the VSC completion from the simulator thread instead of the caller's context. */
+    uint32_t wcm_latency_us;          /**< Time spent resolving the WHD interface. */
+    uint32_t wifi_latency_us;         /**< Time spent inside whd_wifi_set_coex_config(). */
+} cy_smartcoex_hostsim_config_t;
+
+/**
+ * Timestamps of the most recent call into each simulated radio, in
+ * nanoseconds on the cy_smartcoex_hostsim_now_ns() clock, plus call counters.
+ */
+typedef struct
+{
+    uint64_t vsc_enter_ns;            /**< Entry into the VSC stand-in. */
+    uint64_t vsc_exit_ns;             /**< Return from the VSC stand-in. */
+    uint64_t vsc_complete_ns;         /**< Invocation of the VSC completion callback. */
+    uint64_t wifi_enter_ns;           /**< Entry into the Wi-Fi port (before interface resolution). */
+    uint64_t wifi_exit_ns;            /**< Return from the WHD coex ioctl stand-in. */
+    uint32_t vsc_calls;               /**< Number of VSCs issued. */
+    uint32_t vsc_completions;         /**< Number of VSC completion callbacks delivered. */
+    uint32_t wifi_calls;              /**< Number of WHD coex ioctls issued. */
+    uint32_t wcm_calls;               /**< Number of WHD interface lookups. */
+    uint8_t  last_vsc_payload[16];    /**< Payload of the most recent VSC. */
+    uint8_t  last_vsc_payload_len;    /**< Length of last_vsc_payload. */
+    uint16_t last_vsc_opcode;         /**< Opcode of the most recent VSC. */
+    whd_coex_config_t last_wifi_config; /**< Configuration of the most recent WHD coex ioctl. */
+} cy_smartcoex_hostsim_stats_t;
+
+/**
+ * Initializes the simulator. Must be called before the first Smart Coex call.
+ *
+ * @param[in]  config  : Simulated latencies, or NULL for zero latency with synchronous completion.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_hostsim_init(const cy_smartcoex_hostsim_config_t *config);
+
+/**
+ * Drains outstanding completions and stops the simulator thread.
+ */
+void cy_smartcoex_hostsim_deinit(void);
+
+/**
+ * Makes the next @p count VSCs return @p result. WICED_BT_SUCCESS and
+ * WICED_BT_PENDING are accepted and completed; any other value is rejected
+ * without a completion callback.
+ */
+void cy_smartcoex_hostsim_inject_vsc_result(wiced_result_t result, uint32_t count);
+
+/**
+ * Makes the next @p count VSC completions report HCI status @p hci_status.
+ */
+void cy_smartcoex_hostsim_inject_vsc_status(uint8_t hci_status, uint32_t count);
+
+/**
+ * Scripts the next @p count VSCs, taking precedence over the inject functions:
+ * VSC i returns @p results[i] and, if accepted, completes with HCI status
+ * @p hci_statuses[i]. Replaces any earlier script; a count of 0 clears it.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG if count exceeds 8.
+ */
+cy_rslt_t cy_smartcoex_hostsim_script_vsc(const wiced_result_t *results, const uint8_t *hci_statuses, uint32_t count);
+
+/**
+ * Makes the next @p count WHD interface lookups fail with @p result.
+ */
+void cy_smartcoex_hostsim_inject_wcm_result(cy_rslt_t result, uint32_t count);
+
+/**
+ * Makes the next @p count WHD coex ioctls fail with @p result.
+ */
+void cy_smartcoex_hostsim_inject_wifi_result(uint32_t result, uint32_t count);
+
+/**
+ * Sets the cumulative counters returned by the whd_wifi_get_counters() stand-in.
+ */
+void cy_smartcoex_hostsim_set_wifi_counters(const whd_counters_t *counters);
+
+/**
+ * Sets the cumulative coex counters returned by the BT controller stand-in to
+ * a CY_SMARTCOEX_VSC_OCF_BTCX_STATS read.
+ */
+void cy_smartcoex_hostsim_set_bt_coex_counters(uint32_t grants, uint32_t denials);
+
+/**
+ * Sets the Wi-Fi STA connection state and delivers the change to the Wi-Fi
+ * event subscriber, as WCM would.
+ */
+void cy_smartcoex_hostsim_set_wifi_connected(bool connected);
+
+/**
+ * Blocks until every accepted VSC has delivered its completion callback.
+ */
+void cy_smartcoex_hostsim_wait_idle(void);
+
+/**
+ * Copies the current timestamps and counters.
+ */
+void cy_smartcoex_hostsim_get_stats(cy_smartcoex_hostsim_stats_t *stats);
+
+/**
+ * Returns the simulator's monotonic clock in nanoseconds.
+ */
+uint64_t cy_smartcoex_hostsim_now_ns(void);
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* ifndef INCLUDED_CY_SMARTCOEX_HOSTSIM_H_ */
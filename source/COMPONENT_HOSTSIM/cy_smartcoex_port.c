@@ -0,0 +1,223 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+
+#include "whd.h"
+#include "whd_wifi_api.h"
+#include "cy_smartcoex_hostsim.h"
+
+#include <pthread.h>
+#include <string.h>
+
+cy_rslt_t cy_smartcoex_hostsim_get_whd_interface(uint32_t bsscfgidx, whd_interface_t *whd_iface);
+void cy_smartcoex_hostsim_wifi_enter(void);
+
+/* Iovar behind whd_wifi_set_coex_config() */
+#define SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS   "btc_lescan_params"
+
+/* Wi-Fi link state, delivered to new event subscribers */
+static bool wifi_connected = false;
+
+/* WHD interface handles, resolved through the simulator on first use */
+static whd_interface_t whd_ifaces[SMARTCOEX_WIFI_INTERFACE_COUNT];
+
+static cy_rslt_t get_whd_interface(cy_smartcoex_wifi_interface_t interface, whd_interface_t *whd_iface)
+{
+    cy_rslt_t res;
+    whd_interface_t iface;
+
+    if((uint32_t)interface >= SMARTCOEX_WIFI_INTERFACE_COUNT)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Interface type [0x%X] not supported\n", (unsigned int)interface);
+        return CY_RSLT_MW_BADARG;
+    }
+
+    iface = whd_ifaces[interface];
+    if(iface == NULL)
+    {
+        res = cy_smartcoex_hostsim_get_whd_interface((uint32_t)interface, &iface);
+        if(res != CY_RSLT_SUCCESS)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_smartcoex_hostsim_get_whd_interface failed with error:[0x%X]\n", (unsigned int)res);
+            return res;
+        }
+        whd_ifaces[interface] = iface;
+    }
+
+    *whd_iface = iface;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t set_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    cy_rslt_t res;
+    uint32_t result;
+    whd_interface_t whd_iface;
+
+    cy_smartcoex_hostsim_wifi_enter();
+
+    res = get_whd_interface(wifi_config->interface, &whd_iface);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    result = whd_wifi_set_coex_config(whd_iface, coex_config);
+    if(result != WHD_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_set_coex_config failed with error:[0x%X]\n", (unsigned int)result);
+        whd_ifaces[wifi_config->interface] = NULL;
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t get_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    cy_rslt_t res;
+    uint32_t result;
+    whd_interface_t whd_iface;
+
+    res = get_whd_interface(wifi_config->interface, &whd_iface);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    memset(coex_config, 0, sizeof(*coex_config));
+    result = whd_wifi_get_iovar_buffer(whd_iface, SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS, (uint8_t *)&coex_config->le_scan_params,
+                                       sizeof(coex_config->le_scan_params));
+    if(result != WHD_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_get_iovar_buffer failed with error:[0x%X]\n", (unsigned int)result);
+        whd_ifaces[wifi_config->interface] = NULL;
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t get_wifi_counters(cy_smartcoex_wifi_config_t *wifi_config, uint32_t *bytes, uint32_t *frames, uint32_t *retries)
+{
+    cy_rslt_t res;
+    uint32_t result;
+    whd_interface_t whd_iface;
+    whd_counters_t counters;
+
+    res = get_whd_interface(wifi_config->interface, &whd_iface);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    result = whd_wifi_get_counters(whd_iface, &counters);
+    if(result != WHD_SUCCESS)
+    {
+        return result;
+    }
+
+    *bytes   = counters.txbyte + counters.rxbyte;
+    *frames  = counters.txframe + counters.rxframe;
+    *retries = counters.txretrans;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* The simulator models a single WHD driver instance */
+bool wifi_interfaces_share_driver(cy_smartcoex_wifi_interface_t a, cy_smartcoex_wifi_interface_t b)
+{
+    (void)a;
+    (void)b;
+
+    return true;
+}
+
+void reset_wifi_interfaces(void)
+{
+    memset(whd_ifaces, 0, sizeof(whd_ifaces));
+}
+
+cy_rslt_t prepare_wifi_interface(cy_smartcoex_wifi_interface_t interface)
+{
+    whd_interface_t whd_iface;
+
+    return get_whd_interface(interface, &whd_iface);
+}
+
+cy_rslt_t register_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg)
+{
+    return smartcoex_wifi_events_add(handler, arg, wifi_connected, NULL);
+}
+
+void deregister_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg)
+{
+    smartcoex_wifi_events_remove(handler, arg, NULL);
+}
+
+void cy_smartcoex_hostsim_set_wifi_connected(bool connected)
+{
+    wifi_connected = connected;
+    smartcoex_wifi_events_dispatch(connected);
+}
+
+/* Microseconds of the host monotonic clock, truncated; differences are exact across wrap */
+uint32_t get_timestamp(void)
+{
+    return (uint32_t)(cy_smartcoex_hostsim_now_ns() / 1000U);
+}
+
+uint32_t timestamp_to_us(uint32_t ticks)
+{
+    return ticks;
+}
+
+static pthread_mutex_t critical_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+uint32_t enter_critical_section(void)
+{
+    (void)pthread_mutex_lock(&critical_mutex);
+    return 0;
+}
+
+void exit_critical_section(uint32_t state)
+{
+    (void)state;
+    (void)pthread_mutex_unlock(&critical_mutex);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_linux.h
+* @brief Linux userspace port for the Smart Coex library.
+*
+* Sends the coex VSCs to the BT controller over a raw HCI socket, and applies
+* the WLAN side as the btc_lescan_params iovar through the WLAN driver's wl
+* private ioctl. Wi-Fi link state is followed through rtnetlink. In loopback
+* mode, socketpair stand-ins take the place of the BT controller and the WLAN
+* firmware, so the full path runs on any Linux host. Build with
+* COMPONENTS=LINUX instead of WCM.
+*/
+
+#ifndef INCLUDED_CY_SMARTCOEX_LINUX_H_
+#define INCLUDED_CY_SMARTCOEX_LINUX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cy_result.h"
+#include "whd_types.h"
+
+/** WLC_GET_VAR ioctl command of the wl private ioctl */
+#define CY_SMARTCOEX_LINUX_WLC_GET_VAR          (262)
+
+/** WLC_SET_VAR ioctl command of the wl private ioctl */
+#define CY_SMARTCOEX_LINUX_WLC_SET_VAR          (263)
+
+/**
+ * WLAN driver transport. Issues a wl ioctl on a network interface: for
+ * WLC_SET_VAR, buf holds the NUL-terminated iovar name followed by its value;
+ * for WLC_GET_VAR, buf holds the name on entry and receives the value.
+ *
+ * @param[in]     arg     : User argument from the configuration.
+ * @param[in]     ifname  : Network interface.
+ * @param[in]     cmd     : wl ioctl command.
+ * @param[in]     set     : true for a set command.
+ * @param[in,out] buf     : Command buffer.
+ * @param[in]     len     : Length of buf.
+ *
+ * @return status         : 0 on success; a negative errno or a driver error otherwise.
+ */
+typedef int (*cy_smartcoex_linux_wl_ioctl_t)(void *arg, const char *ifname, uint32_t cmd, bool set, void *buf, uint32_t len);
+
+/**
+ * Port configuration.
+ */
+typedef struct
+{
+    uint16_t    hci_dev;            /**< Index of the BT controller, N of hciN. */
+    const char  *sta_ifname;        /**< Network interface of the STA, e.g. "wlan0"; NULL if none. Copied. */
+    const char  *ap_ifname;         /**< Network interface of the soft AP, e.g. "uap0"; NULL if none. Copied. */
+
+    /**
+     * WLAN driver transport, or NULL for the wl private ioctl (SIOCDEVPRIVATE)
+     * of the DHD driver. Drivers that take wl commands through nl80211 vendor
+     * commands instead plug their transport in here.
+     */
+    cy_smartcoex_linux_wl_ioctl_t wl_ioctl;
+    void        *wl_ioctl_arg;      /**< User argument passed to wl_ioctl. */
+
+    bool        loopback;           /**< Use the socketpair stand-ins instead of hci_dev and the WLAN driver. */
+} cy_smartcoex_linux_config_t;
+
+/**
+ * State of the loopback stand-ins.
+ */
+typedef struct
+{
+    uint32_t    hci_commands;           /**< HCI commands received by the stand-in controller. */
+    uint16_t    last_opcode;            /**< Opcode of the last HCI command, OGF included. */
+    uint8_t     last_payload[16];       /**< Parameters of the last HCI command. */
+    uint8_t     last_payload_len;       /**< Length of last_payload. */
+    uint32_t    wl_sets;                /**< WLC_SET_VAR commands received by the stand-in WLAN firmware. */
+    uint32_t    wl_gets;                /**< WLC_GET_VAR commands received by the stand-in WLAN firmware. */
+    whd_btc_lescan_params_t lescan;     /**< btc_lescan_params held by the stand-in WLAN firmware. */
+} cy_smartcoex_linux_loopback_state_t;
+
+/**
+ * Opens the BT controller and the WLAN transport, or the stand-ins, and starts
+ * the HCI event and link monitor threads. Must be called before the first
+ * Smart Coex call.
+ *
+ * @param[in]  config  : Port configuration.
+ *
+ * @return status      : CY_RSLT_SUCCESS on success; CY_RSLT_MW_BADARG on invalid parameters; an error code on failure.
+ */
+cy_rslt_t cy_smartcoex_linux_init(const cy_smartcoex_linux_config_t *config);
+
+/**
+ * Stops the threads and closes the transports. VSCs awaiting completion are dropped.
+ */
+void cy_smartcoex_linux_deinit(void);
+
+/**
+ * Makes the stand-in controller complete the next @p count HCI commands with
+ * HCI status @p hci_status.
+ */
+void cy_smartcoex_linux_loopback_inject_hci_status(uint8_t hci_status, uint32_t count);
+
+/**
+ * Makes the stand-in WLAN firmware fail the next @p count wl ioctls with @p error.
+ */
+void cy_smartcoex_linux_loopback_inject_wl_error(int32_t error, uint32_t count);
+
+/**
+ * Sets the cumulative coex counters the stand-in controller returns to a
+ * CY_SMARTCOEX_VSC_OCF_BTCX_STATS read.
+ */
+void cy_smartcoex_linux_loopback_set_bt_coex_counters(uint32_t grants, uint32_t denials);
+
+/**
+ * Sets the STA link state and delivers the change to the Wi-Fi event
+ * subscribers, as the link monitor would.
+ */
+void cy_smartcoex_linux_loopback_set_wifi_connected(bool connected);
+
+/**
+ * Copies the state of the stand-ins.
+ */
+void cy_smartcoex_linux_loopback_get_state(cy_smartcoex_linux_loopback_state_t *state);
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* ifndef INCLUDED_CY_SMARTCOEX_LINUX_H_ */
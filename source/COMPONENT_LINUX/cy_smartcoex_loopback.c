@@ -0,0 +1,400 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_loopback.c
+* @brief Socketpair stand-ins for the BT controller and the WLAN firmware of the Linux port.
+*
+* The stand-in controller speaks H4 HCI on the far end of the socketpair that
+* takes the place of the raw HCI socket, and answers every command with a
+* Command Complete. The stand-in WLAN firmware serves wl ioctls on a second
+* socketpair and holds btc_lescan_params. Both run on one thread.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_linux.h"
+#include "cy_result_mw.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/socket.h>
+
+/* Port side, see cy_smartcoex_port.c */
+cy_rslt_t smartcoex_loopback_open(int *hci_fd);
+void smartcoex_loopback_close(void);
+int smartcoex_loopback_wl_ioctl(void *arg, const char *ifname, uint32_t cmd, bool set, void *buf, uint32_t len);
+void smartcoex_linux_wifi_link(bool connected);
+
+#define LOOPBACK_HCI_COMMAND_PKT            (0x01)
+#define LOOPBACK_HCI_EVENT_PKT              (0x04)
+#define LOOPBACK_HCI_EV_CMD_COMPLETE        (0x0E)
+#define LOOPBACK_HCI_MAX_PACKET             (260)
+#define LOOPBACK_WL_MAX_BUF                 (64)
+
+#define LOOPBACK_IOVAR_BTC_LESCAN_PARAMS    "btc_lescan_params"
+
+/* A wl ioctl as it crosses the WLAN socketpair */
+typedef struct
+{
+    uint32_t cmd;
+    uint32_t set;
+    uint32_t len;
+    char     ifname[IFNAMSIZ];
+    uint8_t  buf[LOOPBACK_WL_MAX_BUF];
+} loopback_wl_req_t;
+
+typedef struct
+{
+    int32_t  status;
+    uint32_t len;
+    uint8_t  buf[LOOPBACK_WL_MAX_BUF];
+} loopback_wl_rsp_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;      /* Guards the state and the injections */
+    pthread_mutex_t wl_mutex;   /* One wl ioctl on the socketpair at a time */
+    bool            running;
+    pthread_t       thread;
+    int             hci[2];     /* [0] port end, [1] controller end */
+    int             wl[2];      /* [0] port end, [1] firmware end */
+    int             wake[2];
+
+    cy_smartcoex_linux_loopback_state_t state;
+    uint8_t         hci_status;
+    uint32_t        hci_status_count;
+    int32_t         wl_error;
+    uint32_t        wl_error_count;
+    uint32_t        bt_grants;
+    uint32_t        bt_denials;
+} loopback_t;
+
+static loopback_t loopback = { .mutex = PTHREAD_MUTEX_INITIALIZER, .wl_mutex = PTHREAD_MUTEX_INITIALIZER,
+                               .hci = { -1, -1 }, .wl = { -1, -1 }, .wake = { -1, -1 } };
+
+static void loopback_put_le32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+static void loopback_hci_command(const uint8_t *packet, ssize_t len)
+{
+    uint8_t event[3 + 3 + 1 + 8];
+    uint8_t event_len;
+    uint8_t param_len;
+    uint16_t opcode;
+
+    if(len < 4 || packet[0] != LOOPBACK_HCI_COMMAND_PKT)
+    {
+        return;
+    }
+    opcode    = (uint16_t)(packet[1] | (packet[2] << 8));
+    param_len = (uint8_t)((packet[3] <= len - 4) ? packet[3] : len - 4);
+
+    event[0] = LOOPBACK_HCI_EVENT_PKT;
+    event[1] = LOOPBACK_HCI_EV_CMD_COMPLETE;
+    event[3] = 1;                       /* Num_HCI_Command_Packets */
+    event[4] = packet[1];
+    event[5] = packet[2];
+    event_len = 4;
+
+    pthread_mutex_lock(&loopback.mutex);
+    loopback.state.hci_commands++;
+    loopback.state.last_opcode      = opcode;
+    loopback.state.last_payload_len = (param_len <= sizeof(loopback.state.last_payload)) ?
+                                      param_len : (uint8_t)sizeof(loopback.state.last_payload);
+    memcpy(loopback.state.last_payload, &packet[4], loopback.state.last_payload_len);
+
+    event[6] = 0;
+    if(loopback.hci_status_count > 0)
+    {
+        event[6] = loopback.hci_status;
+        loopback.hci_status_count--;
+    }
+    /* A successful counter read returns the LE uint32_t grants and denials after the status */
+    if(event[6] == 0 && CY_SMARTCOEX_VSC_OCF_BTCX_STATS != 0 && (opcode & 0x03FFU) == CY_SMARTCOEX_VSC_OCF_BTCX_STATS)
+    {
+        loopback_put_le32(&event[7], loopback.bt_grants);
+        loopback_put_le32(&event[11], loopback.bt_denials);
+        event_len += 8;
+    }
+    pthread_mutex_unlock(&loopback.mutex);
+
+    event[2] = event_len;
+    (void)write(loopback.hci[1], event, 3U + event_len);
+}
+
+static void loopback_wl_command(void)
+{
+    loopback_wl_req_t req;
+    loopback_wl_rsp_t rsp;
+    size_t name_len;
+    bool lescan;
+
+    if(read(loopback.wl[1], &req, sizeof(req)) != (ssize_t)sizeof(req))
+    {
+        return;
+    }
+
+    memset(&rsp, 0, sizeof(rsp));
+    rsp.len  = (req.len <= LOOPBACK_WL_MAX_BUF) ? req.len : LOOPBACK_WL_MAX_BUF;
+    memcpy(rsp.buf, req.buf, rsp.len);
+    name_len = strnlen((const char *)req.buf, rsp.len);
+    lescan   = (name_len < rsp.len) && strcmp((const char *)req.buf, LOOPBACK_IOVAR_BTC_LESCAN_PARAMS) == 0;
+
+    pthread_mutex_lock(&loopback.mutex);
+    if(loopback.wl_error_count > 0)
+    {
+        rsp.status = loopback.wl_error;
+        loopback.wl_error_count--;
+    }
+    else if(!lescan || (req.cmd != CY_SMARTCOEX_LINUX_WLC_SET_VAR && req.cmd != CY_SMARTCOEX_LINUX_WLC_GET_VAR))
+    {
+        rsp.status = -EOPNOTSUPP;
+    }
+    else if(req.set != 0)
+    {
+        if(rsp.len < name_len + 1U + sizeof(loopback.state.lescan))
+        {
+            rsp.status = -EINVAL;
+        }
+        else
+        {
+            memcpy(&loopback.state.lescan, &req.buf[name_len + 1U], sizeof(loopback.state.lescan));
+            loopback.state.wl_sets++;
+        }
+    }
+    else
+    {
+        if(rsp.len < sizeof(loopback.state.lescan))
+        {
+            rsp.status = -EINVAL;
+        }
+        else
+        {
+            memcpy(rsp.buf, &loopback.state.lescan, sizeof(loopback.state.lescan));
+            loopback.state.wl_gets++;
+        }
+    }
+    pthread_mutex_unlock(&loopback.mutex);
+
+    (void)write(loopback.wl[1], &rsp, sizeof(rsp));
+}
+
+static void *loopback_thread(void *arg)
+{
+    struct pollfd fds[3];
+    uint8_t packet[LOOPBACK_HCI_MAX_PACKET];
+    ssize_t len;
+
+    (void)arg;
+
+    fds[0].fd     = loopback.hci[1];
+    fds[0].events = POLLIN;
+    fds[1].fd     = loopback.wl[1];
+    fds[1].events = POLLIN;
+    fds[2].fd     = loopback.wake[0];
+    fds[2].events = POLLIN;
+
+    for(;;)
+    {
+        if(poll(fds, 3, -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if(fds[2].revents != 0)
+        {
+            break;
+        }
+        if(fds[0].revents != 0)
+        {
+            len = read(loopback.hci[1], packet, sizeof(packet));
+            loopback_hci_command(packet, len);
+        }
+        if(fds[1].revents != 0)
+        {
+            loopback_wl_command();
+        }
+    }
+
+    return NULL;
+}
+
+static void loopback_close_fds(void)
+{
+    int *fds[] = { loopback.hci, loopback.wl, loopback.wake };
+    size_t i;
+
+    for(i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+    {
+        /* The port owns and closes the port end of the HCI socketpair */
+        if(fds[i][0] >= 0 && fds[i] != loopback.hci)
+        {
+            close(fds[i][0]);
+        }
+        if(fds[i][1] >= 0)
+        {
+            close(fds[i][1]);
+        }
+        fds[i][0] = -1;
+        fds[i][1] = -1;
+    }
+}
+
+cy_rslt_t smartcoex_loopback_open(int *hci_fd)
+{
+    if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, loopback.hci) < 0 ||
+       socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, loopback.wl) < 0 ||
+       pipe(loopback.wake) < 0)
+    {
+        if(loopback.hci[0] >= 0)
+        {
+            close(loopback.hci[0]);
+        }
+        loopback_close_fds();
+        return CY_RSLT_MW_ERROR;
+    }
+
+    pthread_mutex_lock(&loopback.mutex);
+    memset(&loopback.state, 0, sizeof(loopback.state));
+    loopback.hci_status_count = 0;
+    loopback.wl_error_count   = 0;
+    loopback.bt_grants        = 0;
+    loopback.bt_denials       = 0;
+    pthread_mutex_unlock(&loopback.mutex);
+
+    if(pthread_create(&loopback.thread, NULL, loopback_thread, NULL) != 0)
+    {
+        close(loopback.hci[0]);
+        loopback_close_fds();
+        return CY_RSLT_MW_ERROR;
+    }
+    loopback.running = true;
+    *hci_fd          = loopback.hci[0];
+
+    return CY_RSLT_SUCCESS;
+}
+
+void smartcoex_loopback_close(void)
+{
+    if(loopback.running)
+    {
+        (void)write(loopback.wake[1], "x", 1);
+        pthread_join(loopback.thread, NULL);
+        loopback.running = false;
+    }
+    loopback_close_fds();
+}
+
+int smartcoex_loopback_wl_ioctl(void *arg, const char *ifname, uint32_t cmd, bool set, void *buf, uint32_t len)
+{
+    loopback_wl_req_t req;
+    loopback_wl_rsp_t rsp;
+
+    (void)arg;
+
+    if(len > LOOPBACK_WL_MAX_BUF)
+    {
+        return -EINVAL;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.cmd = cmd;
+    req.set = set ? 1U : 0U;
+    req.len = len;
+    strncpy(req.ifname, ifname, IFNAMSIZ - 1);
+    memcpy(req.buf, buf, len);
+
+    pthread_mutex_lock(&loopback.wl_mutex);
+    if(!loopback.running || write(loopback.wl[0], &req, sizeof(req)) != (ssize_t)sizeof(req) ||
+       read(loopback.wl[0], &rsp, sizeof(rsp)) != (ssize_t)sizeof(rsp))
+    {
+        pthread_mutex_unlock(&loopback.wl_mutex);
+        return -EIO;
+    }
+    pthread_mutex_unlock(&loopback.wl_mutex);
+
+    if(rsp.status == 0 && !set)
+    {
+        memcpy(buf, rsp.buf, (rsp.len < len) ? rsp.len : len);
+    }
+
+    return rsp.status;
+}
+
+void cy_smartcoex_linux_loopback_inject_hci_status(uint8_t hci_status, uint32_t count)
+{
+    pthread_mutex_lock(&loopback.mutex);
+    loopback.hci_status       = hci_status;
+    loopback.hci_status_count = count;
+    pthread_mutex_unlock(&loopback.mutex);
+}
+
+void cy_smartcoex_linux_loopback_inject_wl_error(int32_t error, uint32_t count)
+{
+    pthread_mutex_lock(&loopback.mutex);
+    loopback.wl_error       = error;
+    loopback.wl_error_count = count;
+    pthread_mutex_unlock(&loopback.mutex);
+}
+
+void cy_smartcoex_linux_loopback_set_bt_coex_counters(uint32_t grants, uint32_t denials)
+{
+    pthread_mutex_lock(&loopback.mutex);
+    loopback.bt_grants  = grants;
+    loopback.bt_denials = denials;
+    pthread_mutex_unlock(&loopback.mutex);
+}
+
+void cy_smartcoex_linux_loopback_set_wifi_connected(bool connected)
+{
+    smartcoex_linux_wifi_link(connected);
+}
+
+void cy_smartcoex_linux_loopback_get_state(cy_smartcoex_linux_loopback_state_t *state)
+{
+    pthread_mutex_lock(&loopback.mutex);
+    *state = loopback.state;
+    pthread_mutex_unlock(&loopback.mutex);
+}
@@ -0,0 +1,815 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_port.c
+* @brief Linux userspace port: raw HCI socket, wl private ioctl and rtnetlink.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_smartcoex_linux.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sockios.h>
+
+/* Stand-ins, see cy_smartcoex_loopback.c */
+cy_rslt_t smartcoex_loopback_open(int *hci_fd);
+void smartcoex_loopback_close(void);
+int smartcoex_loopback_wl_ioctl(void *arg, const char *ifname, uint32_t cmd, bool set, void *buf, uint32_t len);
+void smartcoex_linux_wifi_link(bool connected);
+
+/* Raw HCI socket definitions of the kernel ABI, so that no BlueZ headers are needed */
+#ifndef AF_BLUETOOTH
+#define AF_BLUETOOTH                        (31)
+#endif
+#define LINUX_BTPROTO_HCI                   (1)
+#define LINUX_SOL_HCI                       (0)
+#define LINUX_HCI_FILTER                    (2)
+#define LINUX_HCI_CHANNEL_RAW               (0)
+
+struct linux_sockaddr_hci
+{
+    sa_family_t    hci_family;
+    unsigned short hci_dev;
+    unsigned short hci_channel;
+};
+
+struct linux_hci_filter
+{
+    uint32_t type_mask;
+    uint32_t event_mask[2];
+    uint16_t opcode;
+};
+
+/* HCI packet types and events */
+#define LINUX_HCI_COMMAND_PKT               (0x01)
+#define LINUX_HCI_EVENT_PKT                 (0x04)
+#define LINUX_HCI_EV_CMD_COMPLETE           (0x0E)
+#define LINUX_HCI_EV_CMD_STATUS             (0x0F)
+#define LINUX_HCI_OGF_VENDOR                (0x3F)
+#define LINUX_HCI_MAX_PACKET                (260)
+
+/* Accepted VSCs awaiting their Command Complete; further commands are rejected as busy */
+#define LINUX_MAX_PENDING_VSC               (16)
+
+/* wl private ioctl request, as the DHD driver expects it behind SIOCDEVPRIVATE */
+typedef struct
+{
+    uint32_t cmd;
+    void     *buf;
+    uint32_t len;
+    uint8_t  set;
+    uint32_t used;
+    uint32_t needed;
+} linux_wl_ioctl_req_t;
+
+/* Iovar behind whd_wifi_set_coex_config() */
+#define SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS   "btc_lescan_params"
+
+typedef struct
+{
+    uint16_t opcode;
+    wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback;
+} linux_vsc_t;
+
+/**
+ * Port state. The mutex guards the pending VSCs and is held across the HCI
+ * write, so a completion never overtakes the bookkeeping of its command.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    bool            initialized;
+    bool            loopback;
+    uint16_t        hci_dev;
+    char            ifname[SMARTCOEX_WIFI_INTERFACE_COUNT][IFNAMSIZ];
+    cy_smartcoex_linux_wl_ioctl_t wl_ioctl;
+    void            *wl_ioctl_arg;
+
+    int             hci_fd;
+    int             ioctl_fd;   /* Socket the ioctls of the network interfaces are issued on */
+    int             nl_fd;      /* rtnetlink link notifications, -1 in loopback mode */
+    int             wake[2];    /* Written to stop the threads */
+    pthread_t       hci_thread;
+    pthread_t       link_thread;
+
+    linux_vsc_t     pending[LINUX_MAX_PENDING_VSC];
+    uint32_t        head;
+    uint32_t        count;
+} linux_port_t;
+
+static linux_port_t port = { .mutex = PTHREAD_MUTEX_INITIALIZER, .hci_fd = -1, .ioctl_fd = -1, .nl_fd = -1, .wake = { -1, -1 } };
+
+/* Wi-Fi link state, delivered to new event subscribers */
+static bool wifi_connected = false;
+
+static void linux_complete(const uint8_t *event, uint8_t event_len)
+{
+    wiced_bt_dev_vendor_specific_command_complete_params_t params;
+    wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback;
+    uint8_t status_buf[1];
+    uint16_t opcode;
+
+    /* Command Complete: ncmd, opcode, return parameters. Command Status: status, ncmd, opcode */
+    if(event[0] == LINUX_HCI_EV_CMD_COMPLETE && event_len >= 6)
+    {
+        opcode                 = (uint16_t)(event[3] | (event[4] << 8));
+        params.p_param_buf     = (uint8_t *)&event[5];
+        params.param_len       = (uint8_t)(event_len - 5);
+    }
+    else if(event[0] == LINUX_HCI_EV_CMD_STATUS && event_len >= 6 && event[2] != 0)
+    {
+        /* Only a failed Command Status ends the command; otherwise a Command Complete follows */
+        opcode                 = (uint16_t)(event[4] | (event[5] << 8));
+        status_buf[0]          = event[2];
+        params.p_param_buf     = status_buf;
+        params.param_len       = sizeof(status_buf);
+    }
+    else
+    {
+        return;
+    }
+
+    if((opcode >> 10) != LINUX_HCI_OGF_VENDOR)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&port.mutex);
+    if(port.count == 0 || port.pending[port.head].opcode != (opcode & 0x03FFU))
+    {
+        /* A command of another process on the same controller */
+        pthread_mutex_unlock(&port.mutex);
+        return;
+    }
+    p_cback   = port.pending[port.head].p_cback;
+    port.head = (port.head + 1U) % LINUX_MAX_PENDING_VSC;
+    port.count--;
+    pthread_mutex_unlock(&port.mutex);
+
+    params.opcode = (uint16_t)(opcode & 0x03FFU);
+    if(p_cback != NULL)
+    {
+        p_cback(&params);
+    }
+}
+
+static void *linux_hci_thread(void *arg)
+{
+    struct pollfd fds[2];
+    uint8_t buf[LINUX_HCI_MAX_PACKET];
+    ssize_t len;
+
+    (void)arg;
+
+    fds[0].fd     = port.hci_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = port.wake[0];
+    fds[1].events = POLLIN;
+
+    for(;;)
+    {
+        if(poll(fds, 2, -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if(fds[1].revents != 0)
+        {
+            break;
+        }
+        if((fds[0].revents & (POLLERR | POLLHUP)) != 0)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "HCI socket closed\n");
+            break;
+        }
+
+        len = read(port.hci_fd, buf, sizeof(buf));
+        if(len < 3 || buf[0] != LINUX_HCI_EVENT_PKT || len < 3 + (ssize_t)buf[2])
+        {
+            continue;
+        }
+        linux_complete(&buf[1], (uint8_t)(buf[2] + 2));
+    }
+
+    return NULL;
+}
+
+void smartcoex_linux_wifi_link(bool connected)
+{
+    if(connected == wifi_connected)
+    {
+        return;
+    }
+
+    wifi_connected = connected;
+    smartcoex_wifi_events_dispatch(connected);
+}
+
+static bool linux_sta_running(void)
+{
+    struct ifreq ifr;
+
+    memset(&ifr, 0, sizeof(ifr));
+    memcpy(ifr.ifr_name, port.ifname[CY_SMARTCOEX_INTERFACE_TYPE_STA], IFNAMSIZ);
+    if(ioctl(port.ioctl_fd, SIOCGIFFLAGS, &ifr) < 0)
+    {
+        return false;
+    }
+
+    return (ifr.ifr_flags & IFF_RUNNING) != 0;
+}
+
+/* Follows the operational state of the STA interface, which turns running on association */
+static void *linux_link_thread(void *arg)
+{
+    struct pollfd fds[2];
+    struct nlmsghdr *nh;
+    struct ifinfomsg *ifi;
+    uint8_t buf[8192];
+    unsigned int sta_index;
+    ssize_t len;
+
+    (void)arg;
+
+    fds[0].fd     = port.nl_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = port.wake[0];
+    fds[1].events = POLLIN;
+
+    for(;;)
+    {
+        if(poll(fds, 2, -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if(fds[1].revents != 0)
+        {
+            break;
+        }
+
+        len = recv(port.nl_fd, buf, sizeof(buf), 0);
+        if(len <= 0)
+        {
+            continue;
+        }
+
+        /* The interface may have been created or renamed since the last message */
+        sta_index = if_nametoindex(port.ifname[CY_SMARTCOEX_INTERFACE_TYPE_STA]);
+        for(nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, (uint32_t)len); nh = NLMSG_NEXT(nh, len))
+        {
+            if(nh->nlmsg_type != RTM_NEWLINK && nh->nlmsg_type != RTM_DELLINK)
+            {
+                continue;
+            }
+            ifi = (struct ifinfomsg *)NLMSG_DATA(nh);
+            if(sta_index != 0 && (unsigned int)ifi->ifi_index == sta_index)
+            {
+                smartcoex_linux_wifi_link(nh->nlmsg_type == RTM_NEWLINK && (ifi->ifi_flags & IFF_RUNNING) != 0);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static cy_rslt_t linux_open_hci(uint16_t hci_dev)
+{
+    struct linux_sockaddr_hci addr;
+    struct linux_hci_filter filter;
+
+    port.hci_fd = socket(AF_BLUETOOTH, SOCK_RAW | SOCK_CLOEXEC, LINUX_BTPROTO_HCI);
+    if(port.hci_fd < 0)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to open HCI socket:[%d]\n", errno);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.hci_family  = AF_BLUETOOTH;
+    addr.hci_dev     = hci_dev;
+    addr.hci_channel = LINUX_HCI_CHANNEL_RAW;
+    if(bind(port.hci_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to bind hci%u:[%d]\n", (unsigned int)hci_dev, errno);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    /* Only the command completion events */
+    memset(&filter, 0, sizeof(filter));
+    filter.type_mask     = 1UL << LINUX_HCI_EVENT_PKT;
+    filter.event_mask[0] = (1UL << LINUX_HCI_EV_CMD_COMPLETE) | (1UL << LINUX_HCI_EV_CMD_STATUS);
+    if(setsockopt(port.hci_fd, LINUX_SOL_HCI, LINUX_HCI_FILTER, &filter, sizeof(filter)) < 0)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to set HCI filter:[%d]\n", errno);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t linux_open_link_monitor(void)
+{
+    struct sockaddr_nl addr;
+
+    port.nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(port.nl_fd < 0)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if(bind(port.nl_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+static void linux_close(void)
+{
+    /* The stand-ins first, so that they never see their peer go away */
+    if(port.loopback)
+    {
+        smartcoex_loopback_close();
+    }
+    if(port.hci_fd >= 0)
+    {
+        close(port.hci_fd);
+    }
+    if(port.nl_fd >= 0)
+    {
+        close(port.nl_fd);
+    }
+    if(port.ioctl_fd >= 0)
+    {
+        close(port.ioctl_fd);
+    }
+    if(port.wake[0] >= 0)
+    {
+        close(port.wake[0]);
+        close(port.wake[1]);
+    }
+    port.hci_fd   = -1;
+    port.nl_fd    = -1;
+    port.ioctl_fd = -1;
+    port.wake[0]  = -1;
+    port.wake[1]  = -1;
+}
+
+cy_rslt_t cy_smartcoex_linux_init(const cy_smartcoex_linux_config_t *config)
+{
+    cy_rslt_t result;
+
+    if(config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    pthread_mutex_lock(&port.mutex);
+    if(port.initialized)
+    {
+        pthread_mutex_unlock(&port.mutex);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    memset(port.ifname, 0, sizeof(port.ifname));
+    if(config->sta_ifname != NULL)
+    {
+        strncpy(port.ifname[CY_SMARTCOEX_INTERFACE_TYPE_STA], config->sta_ifname, IFNAMSIZ - 1);
+    }
+    if(config->ap_ifname != NULL)
+    {
+        strncpy(port.ifname[CY_SMARTCOEX_INTERFACE_TYPE_AP], config->ap_ifname, IFNAMSIZ - 1);
+    }
+    port.loopback     = config->loopback;
+    port.hci_dev      = config->hci_dev;
+    port.wl_ioctl     = config->wl_ioctl;
+    port.wl_ioctl_arg = config->wl_ioctl_arg;
+    port.head         = 0;
+    port.count        = 0;
+    if(port.loopback && port.wl_ioctl == NULL)
+    {
+        port.wl_ioctl = smartcoex_loopback_wl_ioctl;
+    }
+
+    port.ioctl_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(port.ioctl_fd < 0 || pipe(port.wake) < 0)
+    {
+        linux_close();
+        pthread_mutex_unlock(&port.mutex);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    result = port.loopback ? smartcoex_loopback_open(&port.hci_fd) : linux_open_hci(port.hci_dev);
+    if(result == CY_RSLT_SUCCESS && !port.loopback && port.ifname[CY_SMARTCOEX_INTERFACE_TYPE_STA][0] != '\0')
+    {
+        result = linux_open_link_monitor();
+    }
+    if(result != CY_RSLT_SUCCESS)
+    {
+        linux_close();
+        pthread_mutex_unlock(&port.mutex);
+        return result;
+    }
+
+    if(pthread_create(&port.hci_thread, NULL, linux_hci_thread, NULL) != 0)
+    {
+        linux_close();
+        pthread_mutex_unlock(&port.mutex);
+        return CY_RSLT_MW_ERROR;
+    }
+    if(port.nl_fd >= 0)
+    {
+        wifi_connected = linux_sta_running();
+        if(pthread_create(&port.link_thread, NULL, linux_link_thread, NULL) != 0)
+        {
+            close(port.nl_fd);
+            port.nl_fd = -1;
+        }
+    }
+    port.initialized = true;
+    pthread_mutex_unlock(&port.mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_smartcoex_linux_deinit(void)
+{
+    pthread_mutex_lock(&port.mutex);
+    if(!port.initialized)
+    {
+        pthread_mutex_unlock(&port.mutex);
+        return;
+    }
+    port.initialized = false;
+    pthread_mutex_unlock(&port.mutex);
+
+    (void)write(port.wake[1], "x", 1);
+    pthread_join(port.hci_thread, NULL);
+    if(port.nl_fd >= 0)
+    {
+        pthread_join(port.link_thread, NULL);
+    }
+
+    pthread_mutex_lock(&port.mutex);
+    linux_close();
+    port.count = 0;
+    pthread_mutex_unlock(&port.mutex);
+}
+
+wiced_result_t wiced_bt_dev_vendor_specific_command(uint16_t opcode, uint8_t param_len, uint8_t *p_param_buf,
+                                                    wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback)
+{
+    uint8_t packet[4 + 255];
+    uint16_t hci_opcode = (uint16_t)((LINUX_HCI_OGF_VENDOR << 10) | (opcode & 0x03FFU));
+    uint32_t tail;
+    ssize_t written;
+
+    pthread_mutex_lock(&port.mutex);
+    if(!port.initialized)
+    {
+        pthread_mutex_unlock(&port.mutex);
+        return WICED_BT_ERROR;
+    }
+    if(port.count >= LINUX_MAX_PENDING_VSC)
+    {
+        pthread_mutex_unlock(&port.mutex);
+        return WICED_BT_BUSY;
+    }
+
+    packet[0] = LINUX_HCI_COMMAND_PKT;
+    packet[1] = (uint8_t)hci_opcode;
+    packet[2] = (uint8_t)(hci_opcode >> 8);
+    packet[3] = param_len;
+    if(param_len != 0)
+    {
+        memcpy(&packet[4], p_param_buf, param_len);
+    }
+
+    tail = (port.head + port.count) % LINUX_MAX_PENDING_VSC;
+    port.pending[tail].opcode  = (uint16_t)(opcode & 0x03FFU);
+    port.pending[tail].p_cback = p_cback;
+    port.count++;
+
+    written = write(port.hci_fd, packet, 4U + param_len);
+    if(written != (ssize_t)(4U + param_len))
+    {
+        port.count--;
+        pthread_mutex_unlock(&port.mutex);
+        if(written < 0 && (errno == EAGAIN || errno == ENOBUFS))
+        {
+            return WICED_BT_BUSY;
+        }
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "HCI write failed:[%d]\n", errno);
+        return WICED_BT_ERROR;
+    }
+    pthread_mutex_unlock(&port.mutex);
+
+    return WICED_BT_PENDING;
+}
+
+static int linux_wl_ioctl(void *arg, const char *ifname, uint32_t cmd, bool set, void *buf, uint32_t len)
+{
+    linux_wl_ioctl_req_t req;
+    struct ifreq ifr;
+
+    (void)arg;
+
+    memset(&req, 0, sizeof(req));
+    req.cmd = cmd;
+    req.buf = buf;
+    req.len = len;
+    req.set = set ? 1U : 0U;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    ifr.ifr_data = (void *)&req;
+
+    return (ioctl(port.ioctl_fd, SIOCDEVPRIVATE, &ifr) < 0) ? -errno : 0;
+}
+
+/* Issues a wl iovar command on the interface; value is sent for a set and received for a get */
+static cy_rslt_t linux_iovar(cy_smartcoex_wifi_interface_t interface, bool set, const char *name, void *value, uint32_t value_len)
+{
+    uint8_t buf[64];
+    uint32_t name_len = (uint32_t)strlen(name) + 1U;
+    uint32_t cmd;
+    int res;
+
+    if((uint32_t)interface >= SMARTCOEX_WIFI_INTERFACE_COUNT || port.ifname[interface][0] == '\0')
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "No network interface for interface type [0x%X]\n", (unsigned int)interface);
+        return CY_RSLT_MW_BADARG;
+    }
+    if(!port.initialized || name_len + value_len > sizeof(buf))
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, name, name_len);
+    if(set)
+    {
+        memcpy(&buf[name_len], value, value_len);
+    }
+
+    cmd = set ? CY_SMARTCOEX_LINUX_WLC_SET_VAR : CY_SMARTCOEX_LINUX_WLC_GET_VAR;
+    res = ((port.wl_ioctl != NULL) ? port.wl_ioctl : linux_wl_ioctl)(port.wl_ioctl_arg, port.ifname[interface], cmd, set, buf,
+                                                                    set ? name_len + value_len : (uint32_t)sizeof(buf));
+    if(res != 0)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "wl ioctl [%u] on interface type [0x%X] failed with error:[%d]\n",
+                             (unsigned int)cmd, (unsigned int)interface, res);
+        return CY_RSLT_MW_ERROR;
+    }
+
+    if(!set)
+    {
+        memcpy(value, buf, value_len);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* The iovar carries the LE scan parameters in the host byte order of the little-endian WLAN firmware */
+cy_rslt_t set_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    return linux_iovar(wifi_config->interface, true, SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS, &coex_config->le_scan_params,
+                       sizeof(coex_config->le_scan_params));
+}
+
+cy_rslt_t get_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    memset(coex_config, 0, sizeof(*coex_config));
+
+    return linux_iovar(wifi_config->interface, false, SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS, &coex_config->le_scan_params,
+                       sizeof(coex_config->le_scan_params));
+}
+
+static bool linux_read_sysfs(const char *ifname, const char *attr, char *value, size_t value_len)
+{
+    char path[128];
+    FILE *f;
+    bool ok;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/%s", ifname, attr);
+    f = fopen(path, "r");
+    if(f == NULL)
+    {
+        return false;
+    }
+    ok = (fgets(value, (int)value_len, f) != NULL);
+    fclose(f);
+
+    return ok;
+}
+
+static uint32_t linux_read_stat(const char *ifname, const char *stat)
+{
+    char attr[64];
+    char value[32];
+
+    snprintf(attr, sizeof(attr), "statistics/%s", stat);
+    if(!linux_read_sysfs(ifname, attr, value, sizeof(value)))
+    {
+        return 0;
+    }
+
+    return (uint32_t)strtoull(value, NULL, 10);
+}
+
+/* Transmit retry failures from the wireless extensions statistics, 0 if the interface is not listed */
+static uint32_t linux_read_retries(const char *ifname)
+{
+    char line[256];
+    char name[IFNAMSIZ + 1];
+    unsigned int retries = 0;
+    FILE *f;
+
+    f = fopen("/proc/net/wireless", "r");
+    if(f == NULL)
+    {
+        return 0;
+    }
+    while(fgets(line, sizeof(line), f) != NULL)
+    {
+        if(sscanf(line, " %16[^:]: %*x %*f %*f %*f %*u %*u %*u %u", name, &retries) == 2 && strcmp(name, ifname) == 0)
+        {
+            break;
+        }
+        retries = 0;
+    }
+    fclose(f);
+
+    return retries;
+}
+
+cy_rslt_t get_wifi_counters(cy_smartcoex_wifi_config_t *wifi_config, uint32_t *bytes, uint32_t *frames, uint32_t *retries)
+{
+    const char *ifname;
+    char value[32];
+
+    if((uint32_t)wifi_config->interface >= SMARTCOEX_WIFI_INTERFACE_COUNT || port.ifname[wifi_config->interface][0] == '\0')
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+    ifname = port.ifname[wifi_config->interface];
+    if(!linux_read_sysfs(ifname, "statistics/tx_bytes", value, sizeof(value)))
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    *bytes   = linux_read_stat(ifname, "tx_bytes") + linux_read_stat(ifname, "rx_bytes");
+    *frames  = linux_read_stat(ifname, "tx_packets") + linux_read_stat(ifname, "rx_packets");
+    *retries = linux_read_retries(ifname);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* Interfaces on one wiphy are served by one driver instance */
+bool wifi_interfaces_share_driver(cy_smartcoex_wifi_interface_t a, cy_smartcoex_wifi_interface_t b)
+{
+    char phy_a[32];
+    char phy_b[32];
+
+    if(port.loopback)
+    {
+        return true;
+    }
+    if(linux_read_sysfs(port.ifname[a], "phy80211/name", phy_a, sizeof(phy_a)) &&
+       linux_read_sysfs(port.ifname[b], "phy80211/name", phy_b, sizeof(phy_b)))
+    {
+        return strcmp(phy_a, phy_b) == 0;
+    }
+
+    return strcmp(port.ifname[a], port.ifname[b]) == 0;
+}
+
+/* Interfaces are addressed by name on every call; nothing is cached */
+void reset_wifi_interfaces(void)
+{
+}
+
+/* Checks that the interface is configured; its name is all that is needed to address it */
+cy_rslt_t prepare_wifi_interface(cy_smartcoex_wifi_interface_t interface)
+{
+    if((uint32_t)interface >= SMARTCOEX_WIFI_INTERFACE_COUNT || port.ifname[interface][0] == '\0')
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "No network interface for interface type [0x%X]\n", (unsigned int)interface);
+        return CY_RSLT_MW_BADARG;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t register_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg)
+{
+    return smartcoex_wifi_events_add(handler, arg, wifi_connected, NULL);
+}
+
+void deregister_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg)
+{
+    smartcoex_wifi_events_remove(handler, arg, NULL);
+}
+
+/* Microseconds of the monotonic clock, truncated; differences are exact across wrap */
+uint32_t get_timestamp(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL));
+}
+
+uint32_t timestamp_to_us(uint32_t ticks)
+{
+    return ticks;
+}
+
+static pthread_mutex_t critical_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+uint32_t enter_critical_section(void)
+{
+    (void)pthread_mutex_lock(&critical_mutex);
+    return 0;
+}
+
+void exit_critical_section(uint32_t state)
+{
+    (void)state;
+    (void)pthread_mutex_unlock(&critical_mutex);
+}
+
+/* Logs to stderr unless the application links the connectivity-utilities cy-log */
+__attribute__((weak)) cy_rslt_t cy_log_msg(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...)
+{
+    va_list args;
+
+    (void)facility;
+    (void)level;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+
+    return CY_RSLT_SUCCESS;
+}
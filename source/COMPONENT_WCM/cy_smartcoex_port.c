@@ -40,28 +40,57 @@
 
 #include "whd.h"
 #include "whd_wifi_api.h"
+#include "cyabs_rtos.h"
+#include "cy_device_headers.h"
+
+#include <string.h>
 
 cy_rslt_t cy_wcm_get_whd_interface(cy_wcm_interface_t interface_type, whd_interface_t *whd_iface);
 
-cy_rslt_t set_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+/* Iovar behind whd_wifi_set_coex_config() */
+#define SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS   "btc_lescan_params"
+
+/* WHD interface handles, resolved through WCM on first use */
+static whd_interface_t whd_ifaces[SMARTCOEX_WIFI_INTERFACE_COUNT];
+
+static cy_rslt_t get_whd_interface(cy_smartcoex_wifi_interface_t interface, whd_interface_t *whd_iface)
 {
     cy_rslt_t res;
-    uint32_t result;
-    cy_wcm_interface_t interface;
-    whd_interface_t whd_iface;
+    whd_interface_t iface;
 
-    if(wifi_config->interface != CY_SMARTCOEX_INTERFACE_TYPE_STA)
+    if((uint32_t)interface >= SMARTCOEX_WIFI_INTERFACE_COUNT)
     {
-        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Interface type [0x%X] not supported\n", (unsigned int)wifi_config->interface);
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Interface type [0x%X] not supported\n", (unsigned int)interface);
         return CY_RSLT_MW_BADARG;
     }
 
-    interface = CY_WCM_INTERFACE_TYPE_STA;
+    iface = whd_ifaces[interface];
+    if(iface == NULL)
+    {
+        res = cy_wcm_get_whd_interface((interface == CY_SMARTCOEX_INTERFACE_TYPE_AP) ? CY_WCM_INTERFACE_TYPE_AP : CY_WCM_INTERFACE_TYPE_STA,
+                                       &iface);
+        if(res != CY_RSLT_SUCCESS)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_wcm_get_whd_interface failed with error:[0x%X]\n", (unsigned int)res);
+            return res;
+        }
+        whd_ifaces[interface] = iface;
+    }
+
+    *whd_iface = iface;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t set_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    cy_rslt_t res;
+    uint32_t result;
+    whd_interface_t whd_iface;
 
-    res = cy_wcm_get_whd_interface(interface, &whd_iface);
+    res = get_whd_interface(wifi_config->interface, &whd_iface);
     if(res != CY_RSLT_SUCCESS)
     {
-        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_wcm_get_whd_interface failed with error:[0x%X]\n", (unsigned int)res);
         return res;
     }
 
@@ -69,8 +98,183 @@ cy_rslt_t set_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex
     if(result != WHD_SUCCESS)
     {
         cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_set_coex_config failed with error:[0x%X]\n", (unsigned int)result);
+        /* The interface may have gone down; resolve it again next time */
+        whd_ifaces[wifi_config->interface] = NULL;
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t get_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    cy_rslt_t res;
+    uint32_t result;
+    whd_interface_t whd_iface;
+
+    res = get_whd_interface(wifi_config->interface, &whd_iface);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    /* WHD has no getter for the coex config; read back the iovar whd_wifi_set_coex_config() sets */
+    memset(coex_config, 0, sizeof(*coex_config));
+    result = whd_wifi_get_iovar_buffer(whd_iface, SMARTCOEX_IOVAR_BTC_LESCAN_PARAMS, (uint8_t *)&coex_config->le_scan_params,
+                                       sizeof(coex_config->le_scan_params));
+    if(result != WHD_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_get_iovar_buffer failed with error:[0x%X]\n", (unsigned int)result);
+        whd_ifaces[wifi_config->interface] = NULL;
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t get_wifi_counters(cy_smartcoex_wifi_config_t *wifi_config, uint32_t *bytes, uint32_t *frames, uint32_t *retries)
+{
+    cy_rslt_t res;
+    uint32_t result;
+    whd_interface_t whd_iface;
+    whd_counters_t counters;
+
+    res = get_whd_interface(wifi_config->interface, &whd_iface);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    result = whd_wifi_get_counters(whd_iface, &counters);
+    if(result != WHD_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_get_counters failed with error:[0x%X]\n", (unsigned int)result);
         return result;
     }
 
+    *bytes   = counters.txbyte + counters.rxbyte;
+    *frames  = counters.txframe + counters.rxframe;
+    *retries = counters.txretrans;
+
     return CY_RSLT_SUCCESS;
 }
+
+/* WCM brings up a single WHD driver instance; STA and AP are interfaces of it */
+bool wifi_interfaces_share_driver(cy_smartcoex_wifi_interface_t a, cy_smartcoex_wifi_interface_t b)
+{
+    (void)a;
+    (void)b;
+
+    return true;
+}
+
+void reset_wifi_interfaces(void)
+{
+    memset(whd_ifaces, 0, sizeof(whd_ifaces));
+}
+
+cy_rslt_t prepare_wifi_interface(cy_smartcoex_wifi_interface_t interface)
+{
+    whd_interface_t whd_iface;
+
+    return get_whd_interface(interface, &whd_iface);
+}
+
+static void wcm_event_callback(cy_wcm_event_t event, cy_wcm_event_data_t *event_data)
+{
+    bool connected;
+
+    (void)event_data;
+
+    if(event == CY_WCM_EVENT_CONNECTED || event == CY_WCM_EVENT_RECONNECTED)
+    {
+        connected = true;
+    }
+    else if(event == CY_WCM_EVENT_DISCONNECTED)
+    {
+        connected = false;
+    }
+    else
+    {
+        return;
+    }
+
+    smartcoex_wifi_events_dispatch(connected);
+}
+
+/* The WCM callback is registered while there is at least one subscriber */
+static cy_rslt_t wcm_events_start(void)
+{
+    cy_rslt_t res;
+
+    res = cy_wcm_register_event_callback(wcm_event_callback);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_wcm_register_event_callback failed with error:[0x%X]\n", (unsigned int)res);
+    }
+
+    return res;
+}
+
+static void wcm_events_stop(void)
+{
+    (void)cy_wcm_deregister_event_callback(wcm_event_callback);
+}
+
+cy_rslt_t register_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg)
+{
+    return smartcoex_wifi_events_add(handler, arg, cy_wcm_is_connected_to_ap(), wcm_events_start);
+}
+
+void deregister_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg)
+{
+    smartcoex_wifi_events_remove(handler, arg, wcm_events_stop);
+}
+
+/* Masks interrupts on this core; PRIMASK is restored so that sections nest */
+uint32_t enter_critical_section(void)
+{
+    uint32_t state = __get_PRIMASK();
+
+    __disable_irq();
+    return state;
+}
+
+void exit_critical_section(uint32_t state)
+{
+    __set_PRIMASK(state);
+}
+
+#if defined(DWT) && defined(CoreDebug)
+/* DWT cycle counter; differences are exact across wrap */
+uint32_t get_timestamp(void)
+{
+    if((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    return DWT->CYCCNT;
+}
+
+uint32_t timestamp_to_us(uint32_t ticks)
+{
+    return ticks / (SystemCoreClock / 1000000U);
+}
+#else
+/* No cycle counter on this core; fall back to the RTOS millisecond tick */
+uint32_t get_timestamp(void)
+{
+    cy_time_t now = 0;
+
+    (void)cy_rtos_get_time(&now);
+    return (uint32_t)now;
+}
+
+uint32_t timestamp_to_us(uint32_t ticks)
+{
+    return ticks * 1000U;
+}
+#endif
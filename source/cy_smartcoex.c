@@ -32,6 +32,7 @@
  */
 
 #include "cy_smartcoex.h"
+#include "cy_smartcoex_static.h"
 #include "cy_smartcoex_priv.h"
 #include "cy_smartcoex_log.h"
 #include "cy_result_mw.h"
@@ -39,79 +40,87 @@
 
 #include "whd_types.h"
 
-/* BT coex parameters for Low priority */
-#define SMARTCOEX_DUTY_CYCLE_LOW                25 // in percentage
-#define SMARTCOEX_SMALL_INTERVAL_GRANT_LOW      4
-#define SMARTCOEX_MAX_SCAN_WINDOW_LOW           48 // in slots
+#include <stdlib.h>
+#include <string.h>
 
-/* BT coex parameters for Medium priority */
-#define SMARTCOEX_DUTY_CYCLE_MEDIUM             50 // in percentage
-#define SMARTCOEX_SMALL_INTERVAL_GRANT_MEDIUM   2
-#define SMARTCOEX_MAX_SCAN_WINDOW_MEDIUM        48 // in slots
+/* BT coex parameters of the built-in profiles; public so that static configs are built from the same values */
+#define SMARTCOEX_DUTY_CYCLE_LOW                CY_SMARTCOEX_PROFILE_LOW_DUTY_CYCLE
+#define SMARTCOEX_SMALL_INTERVAL_GRANT_LOW      CY_SMARTCOEX_PROFILE_LOW_SMALL_INTERVAL_GRANT
+#define SMARTCOEX_MAX_SCAN_WINDOW_LOW           CY_SMARTCOEX_PROFILE_LOW_MAX_SCAN_WINDOW
 
-/* BT coex parameters for High priority */
-#define SMARTCOEX_DUTY_CYCLE_HIGH               90 // in percentage
-#define SMARTCOEX_SMALL_INTERVAL_GRANT_HIGH     1
-#define SMARTCOEX_MAX_SCAN_WINDOW_HIGH          48 // in slots
+#define SMARTCOEX_DUTY_CYCLE_MEDIUM             CY_SMARTCOEX_PROFILE_MEDIUM_DUTY_CYCLE
+#define SMARTCOEX_SMALL_INTERVAL_GRANT_MEDIUM   CY_SMARTCOEX_PROFILE_MEDIUM_SMALL_INTERVAL_GRANT
+#define SMARTCOEX_MAX_SCAN_WINDOW_MEDIUM        CY_SMARTCOEX_PROFILE_MEDIUM_MAX_SCAN_WINDOW
+
+#define SMARTCOEX_DUTY_CYCLE_HIGH               CY_SMARTCOEX_PROFILE_HIGH_DUTY_CYCLE
+#define SMARTCOEX_SMALL_INTERVAL_GRANT_HIGH     CY_SMARTCOEX_PROFILE_HIGH_SMALL_INTERVAL_GRANT
+#define SMARTCOEX_MAX_SCAN_WINDOW_HIGH          CY_SMARTCOEX_PROFILE_HIGH_MAX_SCAN_WINDOW
 
 /* BT scan window parameter range */
-#define SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW      4     // in slots
-#define SMARTCOEX_BT_SCAN_WINDOW_RANGE_HIGH     16384 // in slots
+#define SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW      CY_SMARTCOEX_SCAN_SLOTS_MIN
+#define SMARTCOEX_BT_SCAN_WINDOW_RANGE_HIGH     CY_SMARTCOEX_SCAN_SLOTS_MAX
 
 /* BT scan interval parameter range */
-#define SMARTCOEX_BT_SCAN_INTERVAL_RANGE_LOW    4     // in slots
-#define SMARTCOEX_BT_SCAN_INTERVAL_RANGE_HIGH   16384 // in slots
+#define SMARTCOEX_BT_SCAN_INTERVAL_RANGE_LOW    CY_SMARTCOEX_SCAN_SLOTS_MIN
+#define SMARTCOEX_BT_SCAN_INTERVAL_RANGE_HIGH   CY_SMARTCOEX_SCAN_SLOTS_MAX
 
-/**
- * Scan parameters to be passed to BT stack for Coex
- */
-typedef struct
-{
-    /*
-     * Allowed maximum scan window size, above which host specified scanInterval
-     * and scanWindow are re-adjusted.
-     *
-     * Units: slots (1 slot = 0.625 ms)
-     * Range: 4-16384
-     */
-    uint16_t maxScanWindow;
+/* Discovery target ranges */
+#define SMARTCOEX_ADV_INTERVAL_RANGE_LOW        32    // in slots
+#define SMARTCOEX_ADV_INTERVAL_RANGE_HIGH       16384 // in slots
+#define SMARTCOEX_LATENCY_RANGE_HIGH            600000 // in milliseconds
 
-    /**
-     * The upper bound of of the percentage of the scan time that is given high priority.
-     *
-     * Units: percentage
-     * Range: 0 - 100
-     */
-    uint8_t  scanDutyCycle;
-
-    /**
-     * When host specified scan interval is smaller than maxScanWindow,
-     * every <smallIntervalGrant>'th scan window is given high priority.
-     * For e.g., if smallIntervalGrant is 4, every 4th window is given high priority.
-     *
-     * Units: none
-     * Range: 1 - 255
-     */
-    uint8_t  smallIntervalGrant;
-} le_scan_param;
+/* Discovery model */
+#define SMARTCOEX_SLOT_US                       625
+#define SMARTCOEX_ADV_DELAY_MEAN                8     // in slots; advDelay is 0-10 ms
+#define SMARTCOEX_PERMILLE                      1000
+#define SMARTCOEX_Q16_ONE                       (1UL << 16)
 
-static le_scan_param     param;
-static whd_coex_config_t whd_coex_config;
+/* Profile parameter ranges */
+#define SMARTCOEX_DUTY_CYCLE_RANGE_HIGH         100   // in percentage
+#define SMARTCOEX_SMALL_INTERVAL_GRANT_RANGE_LOW 1
 
-static bool is_params_valid(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+/* smartcoex_once states */
+#define SMARTCOEX_ONCE_IDLE                     0
+#define SMARTCOEX_ONCE_RUNNING                  1
+#define SMARTCOEX_ONCE_DONE                     2
+
+static cy_smartcoex_ctx_t default_ctx;
+static smartcoex_once_t   default_ctx_once;
+
+static bool is_interface_valid(cy_smartcoex_wifi_config_t *wifi_config)
 {
-    if(wifi_config->interface != CY_SMARTCOEX_INTERFACE_TYPE_STA)
+    if((uint32_t)wifi_config->interface >= SMARTCOEX_WIFI_INTERFACE_COUNT)
     {
-        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid Wi-Fi interface type Must be CY_SMARTCOEX_INTERFACE_TYPE_STA. \n");
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid Wi-Fi interface type. Must be CY_SMARTCOEX_INTERFACE_TYPE_STA or CY_SMARTCOEX_INTERFACE_TYPE_AP. \n");
         return false;
     }
 
-    if(bt_config->btcoex_cb == NULL)
+    return true;
+}
+
+static bool is_le_event_valid(const cy_smartcoex_le_event_config_t *event)
+{
+    if(event->grant == 0)
     {
-        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BT coex status callback cannot be NULL.\n");
+        if(event->priority != CY_SMARTCOEX_LESCAN_PRIORITY_LOW || event->max_missed != 0)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid LE link event config. Must be all zero when grant is 0. \n");
+            return false;
+        }
+        return true;
+    }
+
+    if((uint32_t)event->priority > CY_SMARTCOEX_LESCAN_PRIORITY_HIGH)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid LE link event priority. Must be 0, 1 or 2. \n");
         return false;
     }
 
+    return true;
+}
+
+static bool is_scan_params_valid(const cy_smartcoex_bt_config_t *bt_config)
+{
     if(bt_config->scan_int < SMARTCOEX_BT_SCAN_INTERVAL_RANGE_LOW || bt_config->scan_int > SMARTCOEX_BT_SCAN_INTERVAL_RANGE_HIGH)
     {
         cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid Scan Interval. Must be in the range of %d to %d slots. \n",
@@ -135,71 +144,1287 @@ static bool is_params_valid(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoe
     return true;
 }
 
-static int set_whd_coex_config(cy_smartcoex_bt_config_t *bt_config)
+static bool is_params_valid(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
 {
-    whd_coex_config.le_scan_params.priority = (uint16_t)bt_config->scan_priority;
+    uint32_t i;
 
-    whd_coex_config.le_scan_params.scan_int = bt_config->scan_int;
-    whd_coex_config.le_scan_params.scan_win = bt_config->scan_win;
+    if(!is_interface_valid(wifi_config))
+    {
+        return false;
+    }
 
-    switch(bt_config->scan_priority)
+    if(bt_config->btcoex_cb == NULL)
     {
-        case CY_SMARTCOEX_LESCAN_PRIORITY_LOW:
-            whd_coex_config.le_scan_params.duty_cycle = SMARTCOEX_DUTY_CYCLE_LOW;
-            whd_coex_config.le_scan_params.max_win    = SMARTCOEX_MAX_SCAN_WINDOW_LOW;
-            whd_coex_config.le_scan_params.int_grant  = SMARTCOEX_SMALL_INTERVAL_GRANT_LOW;
-            break;
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BT coex status callback cannot be NULL.\n");
+        return false;
+    }
 
-        case CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM:
-            whd_coex_config.le_scan_params.duty_cycle = SMARTCOEX_DUTY_CYCLE_MEDIUM;
-            whd_coex_config.le_scan_params.max_win    = SMARTCOEX_MAX_SCAN_WINDOW_MEDIUM;
-            whd_coex_config.le_scan_params.int_grant  = SMARTCOEX_SMALL_INTERVAL_GRANT_MEDIUM;
-            break;
+    if(!is_scan_params_valid(bt_config))
+    {
+        return false;
+    }
+
+    /* Without the LE link command the conn and adv fields are not used */
+    if(CY_SMARTCOEX_VSC_OCF_BTCX_LELINK == 0)
+    {
+        return true;
+    }
+
+    for(i = 0; i < CY_SMARTCOEX_LE_ROLE_MAX; i++)
+    {
+        if(!is_le_event_valid(&bt_config->conn[i]))
+        {
+            return false;
+        }
+    }
+
+    return is_le_event_valid(&bt_config->adv);
+}
+
+/*
+ * Scan schedule as the controller runs it under a profile. A window above the
+ * profile's max scan window is cut to max_scan_window and the interval scaled
+ * by the same ratio. With an effective interval below max_scan_window, every
+ * small_interval_grant'th window is high priority in full; otherwise the
+ * first duty_cycle percent of every window is. The high-priority part is what
+ * BT keeps while Wi-Fi is busy.
+ */
+typedef struct
+{
+    uint32_t scan_int;      /* Effective interval, in slots */
+    uint32_t scan_win;      /* Effective window, in slots */
+    uint32_t high_period;   /* Distance between high-priority runs, in slots */
+    uint32_t high_run;      /* Length of a high-priority run, in slots */
+} smartcoex_scan_schedule_t;
+
+static void scan_schedule(const le_scan_param *profile, uint32_t scan_int, uint32_t scan_win, smartcoex_scan_schedule_t *schedule)
+{
+    uint32_t grant = (profile->smallIntervalGrant != 0) ? profile->smallIntervalGrant : 1;
+
+    schedule->scan_int = scan_int;
+    schedule->scan_win = scan_win;
+    if(scan_win > profile->maxScanWindow)
+    {
+        schedule->scan_int = (scan_int * profile->maxScanWindow) / scan_win;
+        schedule->scan_win = profile->maxScanWindow;
+        if(schedule->scan_int < schedule->scan_win)
+        {
+            schedule->scan_int = schedule->scan_win;
+        }
+    }
+
+    if(schedule->scan_int < profile->maxScanWindow)
+    {
+        schedule->high_period = schedule->scan_int * grant;
+        schedule->high_run    = schedule->scan_win;
+    }
+    else
+    {
+        schedule->high_period = schedule->scan_int;
+        schedule->high_run    = ((schedule->scan_win * profile->scanDutyCycle) + 50) / 100;
+    }
+}
+
+/* (1 - p)^n in Q16, by squaring */
+static uint32_t miss_q16(uint32_t p_q16, uint32_t n)
+{
+    uint32_t base = SMARTCOEX_Q16_ONE - p_q16;
+    uint32_t miss = SMARTCOEX_Q16_ONE;
+
+    while(n != 0 && miss != 0)
+    {
+        if((n & 1) != 0)
+        {
+            miss = (uint32_t)(((uint64_t)miss * base + (SMARTCOEX_Q16_ONE / 2)) >> 16);
+        }
+        base = (uint32_t)(((uint64_t)base * base + (SMARTCOEX_Q16_ONE / 2)) >> 16);
+        n >>= 1;
+    }
+
+    return miss;
+}
+
+/*
+ * Probability in permille that an advertiser appearing at a random time is
+ * received in a high-priority run within latency slots. Advertising events
+ * are spaced adv_int plus the mean advDelay apart. When runs are further apart
+ * than events, each run is a chance to catch an event; otherwise each event is
+ * a chance to land in a run. A chance succeeds with probability cover / span.
+ *
+ * Successive chances are not independent: the phase of the advertiser against
+ * the scan schedule only moves by the difference of the two periods, plus the
+ * advDelay jitter, per chance. The result is the lower of the independent
+ * estimate and the share of phases swept by that drift.
+ */
+static uint32_t discovery_permille(const smartcoex_scan_schedule_t *schedule, uint32_t adv_int, uint32_t latency)
+{
+    uint32_t adv_period = adv_int + SMARTCOEX_ADV_DELAY_MEAN;
+    uint32_t chances;
+    uint32_t cover;
+    uint32_t span;
+    uint32_t drift;
+    uint32_t independent;
+    uint64_t swept;
+
+    if(schedule->high_run == 0)
+    {
+        return 0;
+    }
+
+    if(schedule->high_period > adv_period)
+    {
+        chances = latency / schedule->high_period;
+        span    = adv_period;
+        cover   = (schedule->high_run < adv_period) ? schedule->high_run : adv_period;
+        drift   = schedule->high_period % adv_period;
+    }
+    else
+    {
+        chances = latency / adv_period;
+        span    = schedule->high_period;
+        cover   = schedule->high_run;
+        drift   = adv_period % schedule->high_period;
+    }
+    if(chances == 0)
+    {
+        return 0;
+    }
+
+    independent = SMARTCOEX_PERMILLE - (uint32_t)(((uint64_t)miss_q16((uint32_t)(((uint64_t)cover << 16) / span), chances) *
+                                                   SMARTCOEX_PERMILLE + (SMARTCOEX_Q16_ONE / 2)) >> 16);
+
+    /* Drift either way round the span, at least the jitter, and never more than one run per chance */
+    if(drift > span - drift)
+    {
+        drift = span - drift;
+    }
+    if(drift < SMARTCOEX_ADV_DELAY_MEAN)
+    {
+        drift = SMARTCOEX_ADV_DELAY_MEAN;
+    }
+    if(drift > cover)
+    {
+        drift = cover;
+    }
+    swept = (((uint64_t)cover + ((uint64_t)(chances - 1) * drift)) * SMARTCOEX_PERMILLE) / span;
+
+    return (swept < independent) ? (uint32_t)swept : independent;
+}
 
-        case CY_SMARTCOEX_LESCAN_PRIORITY_HIGH:
-            whd_coex_config.le_scan_params.duty_cycle = SMARTCOEX_DUTY_CYCLE_HIGH;
-            whd_coex_config.le_scan_params.max_win    = SMARTCOEX_MAX_SCAN_WINDOW_HIGH;
-            whd_coex_config.le_scan_params.int_grant  = SMARTCOEX_SMALL_INTERVAL_GRANT_HIGH;
+static void scan_estimate(const smartcoex_scan_schedule_t *schedule, const cy_smartcoex_discovery_target_t *target,
+                          cy_smartcoex_scan_estimate_t *estimate)
+{
+    estimate->eff_scan_int = (uint16_t)schedule->scan_int;
+    estimate->eff_scan_win = (uint16_t)schedule->scan_win;
+    estimate->scan_duty    = (uint16_t)((schedule->scan_win * SMARTCOEX_PERMILLE) / schedule->scan_int);
+    estimate->bt_airtime   = (uint16_t)((schedule->high_run * SMARTCOEX_PERMILLE) / schedule->high_period);
+    estimate->discovery    = 0;
+    if(target != NULL)
+    {
+        estimate->discovery = (uint16_t)discovery_permille(schedule, target->adv_interval,
+                                                           (target->latency_ms * 1000) / SMARTCOEX_SLOT_US);
+    }
+}
+
+static bool is_target_valid(const cy_smartcoex_discovery_target_t *target)
+{
+    if(target->adv_interval < SMARTCOEX_ADV_INTERVAL_RANGE_LOW || target->adv_interval > SMARTCOEX_ADV_INTERVAL_RANGE_HIGH ||
+       target->probability == 0 || target->probability > SMARTCOEX_PERMILLE ||
+       target->latency_ms == 0 || target->latency_ms > SMARTCOEX_LATENCY_RANGE_HIGH)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid discovery target. \n");
+        return false;
+    }
+
+    return true;
+}
+
+/* Whether schedule a takes less airtime from a busy Wi-Fi than b, then less scan time, then scans less often */
+static bool scan_schedule_cheaper(const smartcoex_scan_schedule_t *a, const smartcoex_scan_schedule_t *b)
+{
+    uint64_t cost_a = (uint64_t)a->high_run * b->high_period;
+    uint64_t cost_b = (uint64_t)b->high_run * a->high_period;
+
+    if(cost_a != cost_b)
+    {
+        return cost_a < cost_b;
+    }
+
+    cost_a = (uint64_t)a->scan_win * b->scan_int;
+    cost_b = (uint64_t)b->scan_win * a->scan_int;
+    if(cost_a != cost_b)
+    {
+        return cost_a < cost_b;
+    }
+
+    return a->scan_int > b->scan_int;
+}
+
+/*
+ * Longest interval in [low, high] with window scan_win that still meets the
+ * target, or 0 if none does. Discovery only drops as the interval grows.
+ */
+static uint32_t longest_scan_int(const le_scan_param *profile, uint32_t scan_win, uint32_t low, uint32_t high,
+                                 uint32_t adv_int, uint32_t latency, uint32_t probability)
+{
+    smartcoex_scan_schedule_t schedule;
+    uint32_t mid;
+    uint32_t found = 0;
+
+    while(low <= high)
+    {
+        mid = low + ((high - low) / 2);
+        scan_schedule(profile, mid, scan_win, &schedule);
+        if(discovery_permille(&schedule, adv_int, latency) >= probability)
+        {
+            found = mid;
+            low   = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    return found;
+}
+
+bool smartcoex_build_profile(const cy_smartcoex_profile_t *profile, smartcoex_profile_entry_t *entry)
+{
+    if(profile->priority > CY_SMARTCOEX_LESCAN_PRIORITY_HIGH)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid profile priority. Must be 0, 1 or 2. \n");
+        return false;
+    }
+
+    if(profile->duty_cycle > SMARTCOEX_DUTY_CYCLE_RANGE_HIGH)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid profile duty cycle. Must be at most %d percent. \n",
+                              SMARTCOEX_DUTY_CYCLE_RANGE_HIGH);
+        return false;
+    }
+
+    if(profile->max_scan_window < SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW || profile->max_scan_window > SMARTCOEX_BT_SCAN_WINDOW_RANGE_HIGH)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid profile max scan window. Must be in the range of %d to %d slots. \n",
+                              SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW, SMARTCOEX_BT_SCAN_WINDOW_RANGE_HIGH);
+        return false;
+    }
+
+    if(profile->small_interval_grant < SMARTCOEX_SMALL_INTERVAL_GRANT_RANGE_LOW)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid profile small interval grant. Must be in the range of %d to 255. \n",
+                              SMARTCOEX_SMALL_INTERVAL_GRANT_RANGE_LOW);
+        return false;
+    }
+
+    entry->vsc_param.maxScanWindow      = profile->max_scan_window;
+    entry->vsc_param.scanDutyCycle      = profile->duty_cycle;
+    entry->vsc_param.smallIntervalGrant = profile->small_interval_grant;
+
+    memset(&entry->wifi_params, 0, sizeof(entry->wifi_params));
+    entry->wifi_params.priority   = (uint16_t)profile->priority;
+    entry->wifi_params.duty_cycle = profile->duty_cycle;
+    entry->wifi_params.max_win    = profile->max_scan_window;
+    entry->wifi_params.int_grant  = profile->small_interval_grant;
+
+    return true;
+}
+
+static void build_builtin_profiles(cy_smartcoex_ctx_t *ctx)
+{
+    static const cy_smartcoex_profile_t builtin[] =
+    {
+        { CY_SMARTCOEX_LESCAN_PRIORITY_LOW,    SMARTCOEX_DUTY_CYCLE_LOW,    SMARTCOEX_MAX_SCAN_WINDOW_LOW,    SMARTCOEX_SMALL_INTERVAL_GRANT_LOW    },
+        { CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM, SMARTCOEX_DUTY_CYCLE_MEDIUM, SMARTCOEX_MAX_SCAN_WINDOW_MEDIUM, SMARTCOEX_SMALL_INTERVAL_GRANT_MEDIUM },
+        { CY_SMARTCOEX_LESCAN_PRIORITY_HIGH,   SMARTCOEX_DUTY_CYCLE_HIGH,   SMARTCOEX_MAX_SCAN_WINDOW_HIGH,   SMARTCOEX_SMALL_INTERVAL_GRANT_HIGH   },
+    };
+    uint8_t i;
+
+    for(i = 0; i < (uint8_t)(sizeof(builtin) / sizeof(builtin[0])); i++)
+    {
+        (void)smartcoex_build_profile(&builtin[i], &ctx->profiles[i]);
+    }
+    ctx->profile_count = i;
+}
+
+/* Fills the WHD config and the VSC payload from a prebuilt profile entry */
+static void set_whd_coex_config(const smartcoex_profile_entry_t *entry, cy_smartcoex_bt_config_t *bt_config,
+                                whd_coex_config_t *whd_coex_config, le_scan_param *param)
+{
+    whd_coex_config->le_scan_params          = entry->wifi_params;
+    whd_coex_config->le_scan_params.scan_int = bt_config->scan_int;
+    whd_coex_config->le_scan_params.scan_win = bt_config->scan_win;
+    *param = entry->vsc_param;
+}
+
+/* Fills the LE link VSC payload; all zero when no link event is configured or there is no LE link command */
+static void set_le_link_param(const cy_smartcoex_bt_config_t *bt_config, le_link_param *param)
+{
+    uint32_t i;
+
+    if(CY_SMARTCOEX_VSC_OCF_BTCX_LELINK == 0)
+    {
+        memset(param, 0, sizeof(*param));
+        return;
+    }
+
+    for(i = 0; i < CY_SMARTCOEX_LE_ROLE_MAX; i++)
+    {
+        param->conn[i].priority  = (uint8_t)bt_config->conn[i].priority;
+        param->conn[i].grant     = bt_config->conn[i].grant;
+        param->conn[i].maxMissed = bt_config->conn[i].max_missed;
+    }
+    param->adv.priority  = (uint8_t)bt_config->adv.priority;
+    param->adv.grant     = bt_config->adv.grant;
+    param->adv.maxMissed = bt_config->adv.max_missed;
+}
+
+bool smartcoex_validate(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+{
+    SMARTCOEX_STATS_TIMESTAMP(start);
+
+    if(!is_params_valid(wifi_config, bt_config))
+    {
+        SMARTCOEX_STATS_COUNT(ctx, BADARG);
+        return false;
+    }
+
+    if((uint32_t)bt_config->scan_priority >= ctx->profile_count)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid LE scan priority. Must be 0, 1, 2 or a registered profile. \n");
+        SMARTCOEX_STATS_COUNT(ctx, BADARG);
+        return false;
+    }
+
+    SMARTCOEX_STATS_RECORD(ctx, VALIDATE, start);
+
+    return true;
+}
+
+static wiced_result_t default_send_vsc(void *arg, uint16_t opcode, uint8_t param_len, uint8_t *p_param_buf,
+                                       wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback)
+{
+    (void)arg;
+
+    return wiced_bt_dev_vendor_specific_command(opcode, param_len, p_param_buf, p_cback);
+}
+
+static cy_rslt_t default_set_wifi_coex_config(void *arg, cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config)
+{
+    (void)arg;
+
+    return set_wifi_coex_config(wifi_config, coex_config);
+}
+
+static cy_rslt_t ctx_init(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_radio_ops_t *radio_ops)
+{
+    cy_rslt_t result;
+
+    memset(ctx, 0, sizeof(*ctx));
+    build_builtin_profiles(ctx);
+
+    if(radio_ops != NULL)
+    {
+        if(radio_ops->send_vsc == NULL || radio_ops->set_wifi_coex_config == NULL)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Radio ops must provide both send_vsc and set_wifi_coex_config.\n");
+            return CY_RSLT_MW_BADARG;
+        }
+        ctx->radio_ops = *radio_ops;
+    }
+    else
+    {
+        ctx->radio_ops.send_vsc             = default_send_vsc;
+        ctx->radio_ops.set_wifi_coex_config = default_set_wifi_coex_config;
+        ctx->radio_ops.arg                  = NULL;
+        ctx->port_ops                       = true;
+    }
+
+    result = smartcoex_vsc_init(ctx);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+    if(smartcoex_readback_init(ctx) != CY_RSLT_SUCCESS)
+    {
+        result = CY_RSLT_MW_ERROR;
+        goto fail_readback;
+    }
+
+#ifdef ENABLE_SMARTCOEX_STATS
+    if(smartcoex_stats_init(ctx) != CY_RSLT_SUCCESS)
+    {
+        result = CY_RSLT_MW_ERROR;
+        goto fail_stats;
+    }
+#endif
+#ifdef ENABLE_SMARTCOEX_TRACE
+    smartcoex_trace_init(ctx);
+#endif
+
+    result = cy_rtos_init_mutex(&ctx->mutex);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        goto fail_mutex;
+    }
+
+    return CY_RSLT_SUCCESS;
+
+    /* Unwind the steps that succeeded, in reverse order */
+fail_mutex:
+#ifdef ENABLE_SMARTCOEX_STATS
+    smartcoex_stats_deinit(ctx);
+fail_stats:
+#endif
+    smartcoex_readback_release(ctx);
+fail_readback:
+    smartcoex_vsc_deinit(ctx);
+
+    return result;
+}
+
+cy_rslt_t smartcoex_once(smartcoex_once_t *once, cy_rslt_t (*init)(void *arg), void *arg)
+{
+    cy_rslt_t result;
+    uint32_t cs;
+    uint8_t state;
+
+    /* The winner runs init outside the critical section; others poll until it is done */
+    for(;;)
+    {
+        cs = enter_critical_section();
+        state = once->state;
+        if(state == SMARTCOEX_ONCE_IDLE)
+        {
+            once->state = SMARTCOEX_ONCE_RUNNING;
+        }
+        exit_critical_section(cs);
+
+        if(state == SMARTCOEX_ONCE_DONE)
+        {
+            return CY_RSLT_SUCCESS;
+        }
+        if(state == SMARTCOEX_ONCE_IDLE)
+        {
             break;
+        }
+        cy_rtos_delay_milliseconds(1);
+    }
+
+    result = init(arg);
+
+    cs = enter_critical_section();
+    once->state = (result == CY_RSLT_SUCCESS) ? SMARTCOEX_ONCE_DONE : SMARTCOEX_ONCE_IDLE;
+    exit_critical_section(cs);
+
+    return result;
+}
+
+static cy_rslt_t default_ctx_init(void *arg)
+{
+    (void)arg;
+    return ctx_init(&default_ctx, NULL);
+}
 
-        default:
-            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid LE scan priority. Must be 0, 1 or 2. \n");
-            return -1;
+cy_smartcoex_ctx_t *smartcoex_default_ctx(void)
+{
+    if(smartcoex_once(&default_ctx_once, default_ctx_init, NULL) != CY_RSLT_SUCCESS)
+    {
+        return NULL;
     }
 
-    return 0;
+    return &default_ctx;
 }
 
-cy_rslt_t cy_smartcoex_config(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+cy_rslt_t smartcoex_commit(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config, bool *bt_busy)
+{
+    return smartcoex_commit_entry(ctx, SMARTCOEX_WIFI_MASK(wifi_config->interface), bt_config,
+                                  &ctx->profiles[bt_config->scan_priority], bt_busy);
+}
+
+/* Whether an LE link payload leaves every event to the controller's default policy */
+static bool is_le_link_default(const le_link_param *param)
+{
+    static const le_link_param link_default;
+
+    return memcmp(param, &link_default, sizeof(*param)) == 0;
+}
+
+/* Whether the coex config applied to the interfaces in applied also reached interface through a shared WHD driver */
+static bool wifi_covered(cy_smartcoex_ctx_t *ctx, uint32_t applied, uint32_t interface)
+{
+    uint32_t i;
+
+    if((applied & SMARTCOEX_WIFI_MASK(interface)) != 0)
+    {
+        return true;
+    }
+
+    /* Nothing is known about the drivers behind custom radio ops */
+    if(!ctx->port_ops)
+    {
+        return false;
+    }
+
+    for(i = 0; i < SMARTCOEX_WIFI_INTERFACE_COUNT; i++)
+    {
+        if((applied & SMARTCOEX_WIFI_MASK(i)) != 0 &&
+           wifi_interfaces_share_driver((cy_smartcoex_wifi_interface_t)i, (cy_smartcoex_wifi_interface_t)interface))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Applies coex_config to every interface in the mask not covered by applied. An interface
+ * that fails, e.g. one not up, does not stop the others; the first failure is returned
+ * and written receives the interfaces that took the config.
+ */
+static cy_rslt_t apply_wifi(cy_smartcoex_ctx_t *ctx, uint32_t interfaces, uint32_t applied,
+                            whd_coex_config_t *coex_config, uint32_t *written)
+{
+    cy_smartcoex_wifi_config_t wifi_config;
+    cy_rslt_t first = CY_RSLT_SUCCESS;
+    cy_rslt_t result;
+    uint32_t i;
+
+    *written = 0;
+    for(i = 0; i < SMARTCOEX_WIFI_INTERFACE_COUNT; i++)
+    {
+        if((interfaces & SMARTCOEX_WIFI_MASK(i)) == 0 || wifi_covered(ctx, applied, i))
+        {
+            continue;
+        }
+
+        wifi_config.interface = (cy_smartcoex_wifi_interface_t)i;
+        result = ctx->radio_ops.set_wifi_coex_config(ctx->radio_ops.arg, &wifi_config, coex_config);
+        if(result != CY_RSLT_SUCCESS)
+        {
+            if(first == CY_RSLT_SUCCESS)
+            {
+                first = result;
+            }
+            continue;
+        }
+        applied  |= SMARTCOEX_WIFI_MASK(i);
+        *written |= SMARTCOEX_WIFI_MASK(i);
+    }
+
+    return first;
+}
+
+cy_rslt_t smartcoex_rollback_wifi(cy_smartcoex_ctx_t *ctx, const smartcoex_wifi_state_t *prev)
+{
+    smartcoex_shadow_t *shadow = &ctx->shadow;
+    whd_coex_config_t coex_config;
+    uint32_t written;
+    cy_rslt_t result;
+
+    shadow->wifi_valid = false;
+    if(!prev->valid)
+    {
+        /* Nothing known to restore; the next commit resends the Wi-Fi side */
+        return CY_RSLT_MW_ERROR;
+    }
+
+    coex_config = prev->config;
+    result = apply_wifi(ctx, prev->interfaces, 0, &coex_config, &written);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Wi-Fi coex config rollback failed with error:[0x%X]\n", (unsigned int)result);
+        return result;
+    }
+
+    shadow->wifi_interfaces = prev->interfaces;
+    shadow->wifi_config     = prev->config;
+    shadow->wifi_valid      = true;
+
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t commit_entry(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, cy_smartcoex_bt_config_t *bt_config,
+                              const smartcoex_profile_entry_t *entry, cy_time_t lock_timeout, bool *bt_busy,
+                              smartcoex_commit_outcome_t *outcome)
 {
     wiced_result_t res;
+    cy_rslt_t result;
+    le_scan_param param;
+    le_link_param link_param;
+    whd_coex_config_t whd_coex_config;
+    smartcoex_shadow_t *shadow = &ctx->shadow;
+    smartcoex_wifi_state_t wifi_prev;
+    btcoex_cb_t btcoex_cb = NULL;
+    btcoex_cb_t link_cb = NULL;
+    cy_rslt_t link_result = CY_RSLT_SUCCESS;
+    cy_rslt_t wifi_result = CY_RSLT_SUCCESS;
+    uint32_t commit_start = get_timestamp();
+    uint32_t gen;
+    uint32_t vsc_gen = 0;
+    uint32_t link_gen;
+    uint32_t wifi_applied = 0;
+    uint32_t wifi_written;
+    uint32_t i;
+    uint8_t vsc_slot = 0;
+    uint8_t link_slot = 0;
+    bool bt_needed;
+    bool link_needed;
+    bool wifi_needed = false;
+#ifdef ENABLE_SMARTCOEX_STATS
+    uint32_t start;
+#endif
 
-    if(!is_params_valid(wifi_config, bt_config))
+    *bt_busy = false;
+    outcome->start       = commit_start;
+    outcome->flags       = 0;
+    outcome->wifi_result = CY_RSLT_SUCCESS;
+    outcome->vsc_result  = WICED_BT_SUCCESS;
+    outcome->link_result = WICED_BT_SUCCESS;
+    outcome->vsc_gen     = 0;
+    outcome->link_gen    = 0;
+
+    set_whd_coex_config(entry, bt_config, &whd_coex_config, &param);
+    set_le_link_param(bt_config, &link_param);
+
+    if(cy_rtos_get_mutex(&ctx->mutex, lock_timeout) != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Coex commit in progress. Commit not started.\n");
+        SMARTCOEX_STATS_COUNT(ctx, BUSY);
+        *bt_busy = true;
+        return CY_RSLT_MW_ERROR;
+    }
+
+    smartcoex_vsc_settle(ctx);
+
+    bt_needed   = !shadow->bt_valid || memcmp(&shadow->bt_param, &param, sizeof(param)) != 0;
+    /* The controller starts out with its default link policy, which an all-zero payload asks for */
+    if(shadow->link_valid)
+    {
+        link_needed = memcmp(&shadow->link_param, &link_param, sizeof(link_param)) != 0;
+    }
+    else
+    {
+        link_needed = !is_le_link_default(&link_param);
+    }
+    if(shadow->wifi_valid && memcmp(&shadow->wifi_config, &whd_coex_config, sizeof(whd_coex_config)) == 0)
+    {
+        wifi_applied = shadow->wifi_interfaces;
+    }
+    for(i = 0; i < SMARTCOEX_WIFI_INTERFACE_COUNT; i++)
+    {
+        if((wifi_interfaces & SMARTCOEX_WIFI_MASK(i)) != 0 && !wifi_covered(ctx, wifi_applied, i))
+        {
+            wifi_needed = true;
+        }
+    }
+    if(!bt_needed && !wifi_needed && !link_needed)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Coex config unchanged. Commit skipped.\n");
+        SMARTCOEX_STATS_COUNT(ctx, SUCCESS);
+        cy_rtos_set_mutex(&ctx->mutex);
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* Prepare: reserve the VSC slot before touching either radio, so a full window changes nothing */
+    if(bt_needed)
+    {
+        btcoex_cb = smartcoex_vsc_begin(ctx, bt_config->btcoex_cb, false, &vsc_slot, &vsc_gen);
+        if(btcoex_cb == NULL)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Too many coex VSCs in flight. Command not sent.\n");
+            SMARTCOEX_STATS_COUNT(ctx, BUSY);
+            *bt_busy = true;
+            cy_rtos_set_mutex(&ctx->mutex);
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+    else
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "BT coex config unchanged. VSC skipped.\n");
+    }
+    if(link_needed)
+    {
+        link_cb = smartcoex_vsc_begin(ctx, bt_config->btcoex_cb, true, &link_slot, &link_gen);
+        if(link_cb == NULL)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Too many coex VSCs in flight. Command not sent.\n");
+            if(bt_needed)
+            {
+                smartcoex_vsc_cancel(ctx, vsc_slot);
+            }
+            SMARTCOEX_STATS_COUNT(ctx, BUSY);
+            *bt_busy = true;
+            cy_rtos_set_mutex(&ctx->mutex);
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+
+    gen = smartcoex_vsc_next_gen(ctx);
+
+    /* Wi-Fi first: its result is known synchronously, so a failure leaves BT untouched */
+    if(wifi_needed)
+    {
+        wifi_prev.valid      = shadow->wifi_valid;
+        wifi_prev.interfaces = shadow->wifi_interfaces;
+        wifi_prev.config     = shadow->wifi_config;
+        shadow->wifi_valid   = false;
+#ifdef ENABLE_SMARTCOEX_STATS
+        start = get_timestamp();
+#endif
+        result = apply_wifi(ctx, wifi_interfaces, wifi_applied, &whd_coex_config, &wifi_written);
+        SMARTCOEX_STATS_RECORD(ctx, WIFI_IOCTL, start);
+        outcome->flags      |= CY_SMARTCOEX_TRACE_FLAG_WIFI_SENT;
+        outcome->wifi_result = result;
+        if(result != CY_RSLT_SUCCESS && wifi_written == 0)
+        {
+            /* A rejected ioctl leaves the previous config in place */
+            shadow->wifi_valid = wifi_prev.valid;
+            if(bt_needed)
+            {
+                smartcoex_vsc_cancel(ctx, vsc_slot);
+            }
+            if(link_needed)
+            {
+                smartcoex_vsc_cancel(ctx, link_slot);
+            }
+            SMARTCOEX_STATS_COUNT(ctx, ERROR);
+            cy_rtos_set_mutex(&ctx->mutex);
+            return result;
+        }
+        if(result != CY_RSLT_SUCCESS)
+        {
+            /* Keep the interfaces that took the config, e.g. AP while STA is down; the rest are retried by the next commit */
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Wi-Fi coex config applied to interfaces 0x%X of 0x%X only\n",
+                                 (unsigned int)wifi_written, (unsigned int)wifi_interfaces);
+            wifi_result     = result;
+            wifi_interfaces = wifi_written;
+        }
+        shadow->wifi_interfaces = wifi_applied | wifi_interfaces;
+        shadow->wifi_config     = whd_coex_config;
+        shadow->wifi_valid      = true;
+    }
+    else
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Wi-Fi coex config unchanged. ioctl skipped.\n");
+    }
+
+    if(bt_needed)
+    {
+        smartcoex_vsc_arm(ctx, vsc_slot, gen, wifi_needed ? &wifi_prev : NULL);
+
+        /* Marked valid before the send: a completion reporting a failed HCI status invalidates it, possibly from within the send */
+        shadow->bt_param = param;
+        shadow->bt_valid = true;
+#ifdef ENABLE_SMARTCOEX_STATS
+        start = get_timestamp();
+#endif
+        res = ctx->radio_ops.send_vsc(ctx->radio_ops.arg, BTHCI_CMD_VS_OCF_BTCX_LESCAN,
+                sizeof(le_scan_param), (uint8_t*)&shadow->bt_param, btcoex_cb);
+        SMARTCOEX_STATS_RECORD(ctx, VSC_SEND, start);
+        outcome->flags     |= CY_SMARTCOEX_TRACE_FLAG_VSC_SENT;
+        outcome->vsc_result = res;
+        outcome->vsc_gen    = vsc_gen;
+        if(res != WICED_BT_SUCCESS && res != WICED_BT_PENDING)
+        {
+            if(res == WICED_BT_BUSY)
+            {
+                cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BT stack is busy. Command not sent.\n");
+                SMARTCOEX_STATS_COUNT(ctx, BUSY);
+                *bt_busy = true;
+            }
+            else
+            {
+                cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "wiced_bt_dev_vendor_specific_command failed with error:[0x%X]\n", (unsigned int)res);
+                SMARTCOEX_STATS_COUNT(ctx, ERROR);
+            }
+            smartcoex_vsc_cancel(ctx, vsc_slot);
+            if(link_needed)
+            {
+                smartcoex_vsc_cancel(ctx, link_slot);
+            }
+            shadow->bt_valid = false;
+            if(wifi_needed)
+            {
+                smartcoex_rollback_wifi(ctx, &wifi_prev);
+            }
+            cy_rtos_set_mutex(&ctx->mutex);
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+
+    /* BT-only settings: a failure is reported and resent by the next commit, without undoing the scan side */
+    if(link_needed)
+    {
+        shadow->link_param = link_param;
+        shadow->link_valid = true;
+        res = ctx->radio_ops.send_vsc(ctx->radio_ops.arg, CY_SMARTCOEX_VSC_OCF_BTCX_LELINK,
+                sizeof(le_link_param), (uint8_t*)&shadow->link_param, link_cb);
+        outcome->flags      |= CY_SMARTCOEX_TRACE_FLAG_LINK_SENT;
+        outcome->link_result = res;
+        outcome->link_gen    = link_gen;
+        if(res != WICED_BT_SUCCESS && res != WICED_BT_PENDING)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "LE link coex VSC failed with error:[0x%X]\n", (unsigned int)res);
+            smartcoex_vsc_cancel(ctx, link_slot);
+            shadow->link_valid = false;
+            *bt_busy = (res == WICED_BT_BUSY);
+            link_result = CY_RSLT_MW_ERROR;
+        }
+        else if(!shadow->link_valid)
+        {
+            /* Completed from within the send with a failed HCI status */
+            link_result = CY_RSLT_MW_ERROR;
+        }
+    }
+
+    if(smartcoex_vsc_committed(ctx, gen, vsc_gen, commit_start))
+    {
+        ctx->btcoex_cb     = bt_config->btcoex_cb;
+        ctx->scan_priority = bt_config->scan_priority;
+        smartcoex_snapshot_update(ctx);
+        result = (wifi_result != CY_RSLT_SUCCESS) ? wifi_result : link_result;
+        if(result == CY_RSLT_SUCCESS)
+        {
+            SMARTCOEX_STATS_COUNT(ctx, SUCCESS);
+        }
+        else if(*bt_busy && wifi_result == CY_RSLT_SUCCESS)
+        {
+            SMARTCOEX_STATS_COUNT(ctx, BUSY);
+        }
+        else
+        {
+            SMARTCOEX_STATS_COUNT(ctx, ERROR);
+        }
+    }
+    else
+    {
+        /* The VSC completed from within the send with a failed status; roll Wi-Fi back here rather than later */
+        smartcoex_vsc_settle(ctx);
+        SMARTCOEX_STATS_COUNT(ctx, ERROR);
+        result = CY_RSLT_MW_ERROR;
+    }
+
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return result;
+}
+
+static cy_rslt_t commit_traced(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, cy_smartcoex_bt_config_t *bt_config,
+                               const smartcoex_profile_entry_t *entry, cy_time_t lock_timeout, bool *bt_busy)
+{
+    smartcoex_commit_outcome_t outcome;
+    cy_rslt_t result;
+
+    result = commit_entry(ctx, wifi_interfaces, bt_config, entry, lock_timeout, bt_busy, &outcome);
+#ifdef ENABLE_SMARTCOEX_TRACE
+    smartcoex_trace_commit(ctx, wifi_interfaces, bt_config, entry, &outcome, result, *bt_busy);
+#endif
+
+    return result;
+}
+
+cy_rslt_t smartcoex_commit_entry(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, cy_smartcoex_bt_config_t *bt_config,
+                                 const smartcoex_profile_entry_t *entry, bool *bt_busy)
+{
+    return commit_traced(ctx, wifi_interfaces, bt_config, entry, CY_RTOS_NEVER_TIMEOUT, bt_busy);
+}
+
+cy_rslt_t smartcoex_commit_entry_nowait(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, cy_smartcoex_bt_config_t *bt_config,
+                                        const smartcoex_profile_entry_t *entry, bool *bt_busy)
+{
+    return commit_traced(ctx, wifi_interfaces, bt_config, entry, 0, bt_busy);
+}
+
+cy_rslt_t cy_smartcoex_ctx_create(cy_smartcoex_ctx_t **ctx, const cy_smartcoex_radio_ops_t *radio_ops)
+{
+    cy_smartcoex_ctx_t *new_ctx;
+    cy_rslt_t result;
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    new_ctx = (cy_smartcoex_ctx_t *)malloc(sizeof(cy_smartcoex_ctx_t));
+    if(new_ctx == NULL)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to allocate Smart Coex context.\n");
+        return CY_RSLT_MW_NOMEM;
+    }
+
+    result = ctx_init(new_ctx, radio_ops);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(new_ctx);
+        return result;
+    }
+
+    *ctx = new_ctx;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_destroy(cy_smartcoex_ctx_t *ctx)
+{
+    if(ctx == NULL || ctx == &default_ctx)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    smartcoex_snapshot_release(ctx);
+    smartcoex_async_release(ctx);
+    smartcoex_readback_release(ctx);
+    smartcoex_vsc_deinit(ctx);
+#ifdef ENABLE_SMARTCOEX_STATS
+    smartcoex_stats_deinit(ctx);
+#endif
+    cy_rtos_deinit_mutex(&ctx->mutex);
+    free(ctx);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_config(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+{
+    bool bt_busy;
+    cy_rslt_t result;
+    SMARTCOEX_STATS_TIMESTAMP(start);
+
+    if(ctx == NULL || wifi_config == NULL || bt_config == NULL)
     {
         return CY_RSLT_MW_BADARG;
     }
 
-    if(set_whd_coex_config(bt_config) == -1)
+    if(!smartcoex_validate(ctx, wifi_config, bt_config))
     {
         return CY_RSLT_MW_BADARG;
     }
 
-    param.maxScanWindow = whd_coex_config.le_scan_params.max_win;
-    param.scanDutyCycle = whd_coex_config.le_scan_params.duty_cycle;
-    param.smallIntervalGrant = whd_coex_config.le_scan_params.int_grant;
+    result = smartcoex_commit(ctx, wifi_config, bt_config, &bt_busy);
+    SMARTCOEX_STATS_RECORD(ctx, CONFIG, start);
+
+    return result;
+}
 
-    res = wiced_bt_dev_vendor_specific_command(BTHCI_CMD_VS_OCF_BTCX_LESCAN,
-            sizeof(le_scan_param), (uint8_t*)&param, bt_config->btcoex_cb);
-    if(res == WICED_BT_BUSY)
+cy_rslt_t cy_smartcoex_ctx_config_batch(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_configs, uint8_t count,
+                                        cy_smartcoex_bt_config_t *bt_config)
+{
+    bool bt_busy;
+    cy_rslt_t result;
+    uint32_t wifi_interfaces = 0;
+    uint8_t i;
+    SMARTCOEX_STATS_TIMESTAMP(start);
+
+    if(ctx == NULL || wifi_configs == NULL || count == 0 || bt_config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!smartcoex_validate(ctx, &wifi_configs[0], bt_config))
     {
-        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BT stack is busy. Command not sent.\n");
+        return CY_RSLT_MW_BADARG;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        if(!is_interface_valid(&wifi_configs[i]))
+        {
+            SMARTCOEX_STATS_COUNT(ctx, BADARG);
+            return CY_RSLT_MW_BADARG;
+        }
+        wifi_interfaces |= SMARTCOEX_WIFI_MASK(wifi_configs[i].interface);
+    }
+
+    result = smartcoex_commit_entry(ctx, wifi_interfaces, bt_config, &ctx->profiles[bt_config->scan_priority], &bt_busy);
+    SMARTCOEX_STATS_RECORD(ctx, CONFIG, start);
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_ctx_force_resync(cy_smartcoex_ctx_t *ctx)
+{
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    ctx->shadow.bt_valid   = false;
+    ctx->shadow.wifi_valid = false;
+    ctx->shadow.link_valid = false;
+    if(ctx->port_ops)
+    {
+        /* A restarted driver hands out new interface handles */
+        reset_wifi_interfaces();
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_register_profile(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_profile_t *profile,
+                                            cy_smartcoex_lescan_priority_t *profile_id)
+{
+    smartcoex_profile_entry_t entry;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if(ctx == NULL || profile == NULL || profile_id == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!smartcoex_build_profile(profile, &entry))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(ctx->profile_count >= CY_SMARTCOEX_MAX_PROFILES)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Profile table full. Increase CY_SMARTCOEX_MAX_PROFILES.\n");
+        result = CY_RSLT_MW_NOMEM;
+    }
+    else
+    {
+        /* The slot is filled before the count is published, so lock-free readers never see a partial entry */
+        ctx->profiles[ctx->profile_count] = entry;
+        *profile_id = (cy_smartcoex_lescan_priority_t)ctx->profile_count;
+        ctx->profile_count++;
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_register_profile(const cy_smartcoex_profile_t *profile, cy_smartcoex_lescan_priority_t *profile_id)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_register_profile(ctx, profile, profile_id) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_ctx_get_profile(cy_smartcoex_ctx_t *ctx, cy_smartcoex_lescan_priority_t profile_id, cy_smartcoex_profile_t *profile)
+{
+    const smartcoex_profile_entry_t *entry;
+
+    if(ctx == NULL || profile == NULL || (uint32_t)profile_id >= ctx->profile_count)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    entry = &ctx->profiles[profile_id];
+    profile->priority             = (cy_smartcoex_lescan_priority_t)entry->wifi_params.priority;
+    profile->duty_cycle           = entry->vsc_param.scanDutyCycle;
+    profile->max_scan_window      = entry->vsc_param.maxScanWindow;
+    profile->small_interval_grant = entry->vsc_param.smallIntervalGrant;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_get_profile(cy_smartcoex_lescan_priority_t profile_id, cy_smartcoex_profile_t *profile)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_get_profile(ctx, profile_id, profile) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_ctx_estimate_scan(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_bt_config_t *bt_config,
+                                         const cy_smartcoex_discovery_target_t *target, cy_smartcoex_scan_estimate_t *estimate)
+{
+    smartcoex_scan_schedule_t schedule;
+
+    if(ctx == NULL || bt_config == NULL || estimate == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!is_scan_params_valid(bt_config) || (target != NULL && !is_target_valid(target)) ||
+       (uint32_t)bt_config->scan_priority >= ctx->profile_count)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    scan_schedule(&ctx->profiles[bt_config->scan_priority].vsc_param, bt_config->scan_int, bt_config->scan_win, &schedule);
+    scan_estimate(&schedule, target, estimate);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_recommend_scan(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_discovery_target_t *target,
+                                          cy_smartcoex_bt_config_t *bt_config, cy_smartcoex_scan_estimate_t *estimate)
+{
+    const le_scan_param *profile;
+    smartcoex_scan_schedule_t schedule;
+    smartcoex_scan_schedule_t best;
+    uint32_t latency;
+    uint32_t max_win;
+    uint32_t adv_period;
+    uint32_t small_max;
+    uint32_t scan_win;
+    uint32_t scan_int;
+    uint32_t low;
+    uint32_t run;
+    bool found = false;
+
+    if(ctx == NULL || target == NULL || bt_config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!is_target_valid(target) || (uint32_t)bt_config->scan_priority >= ctx->profile_count)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    profile    = &ctx->profiles[bt_config->scan_priority].vsc_param;
+    latency    = (target->latency_ms * 1000) / SMARTCOEX_SLOT_US;
+    adv_period = (uint32_t)target->adv_interval + SMARTCOEX_ADV_DELAY_MEAN;
+    max_win    = (profile->maxScanWindow < SMARTCOEX_BT_SCAN_WINDOW_RANGE_HIGH) ? profile->maxScanWindow : SMARTCOEX_BT_SCAN_WINDOW_RANGE_HIGH;
+
+    /*
+     * Windows are kept within the max scan window, so the controller runs them
+     * as given. A chance to discover takes a full scan period and a full
+     * advertising period, so no window longer than the latency helps, and no
+     * target beyond an advertising period can be met.
+     */
+    if(max_win > latency)
+    {
+        max_win = latency;
+    }
+    if(adv_period > latency)
+    {
+        max_win = 0;
+    }
+
+    /*
+     * Intervals below the max scan window: every small_interval_grant'th
+     * window is high priority in full. A window that spans an advertising
+     * event catches it; longer ones only cost airtime.
+     */
+    small_max = (profile->maxScanWindow - 1U < max_win) ? profile->maxScanWindow - 1U : max_win;
+    if(small_max > adv_period)
+    {
+        small_max = adv_period;
+    }
+    for(scan_win = SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW; scan_win <= small_max; scan_win++)
+    {
+        scan_int = longest_scan_int(profile, scan_win, scan_win, profile->maxScanWindow - 1U,
+                                    target->adv_interval, latency, target->probability);
+        if(scan_int != 0)
+        {
+            scan_schedule(profile, scan_int, scan_win, &schedule);
+            if(!found || scan_schedule_cheaper(&schedule, &best))
+            {
+                best  = schedule;
+                found = true;
+            }
+        }
+    }
+
+    /*
+     * Longer intervals: the first duty_cycle percent of every window is high
+     * priority. Discovery depends on the length of that run, not the window,
+     * so only the shortest window of each run length is tried, up to a run
+     * that spans an advertising event. Nothing is high priority at a zero
+     * duty cycle.
+     */
+    run = (profile->scanDutyCycle != 0) ? ((SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW * profile->scanDutyCycle) + 50U) / 100U : adv_period + 1U;
+    if(run == 0)
+    {
+        run = 1;
+    }
+    for(; run <= adv_period; run++)
+    {
+        /* Shortest window whose rounded run is this long */
+        scan_win = ((run * 100U) - 50U + profile->scanDutyCycle - 1U) / profile->scanDutyCycle;
+        if(scan_win < SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW)
+        {
+            scan_win = SMARTCOEX_BT_SCAN_WINDOW_RANGE_LOW;
+        }
+        if(scan_win > max_win)
+        {
+            break;
+        }
+
+        low = (scan_win > profile->maxScanWindow) ? scan_win : profile->maxScanWindow;
+        scan_int = longest_scan_int(profile, scan_win, low, SMARTCOEX_BT_SCAN_INTERVAL_RANGE_HIGH,
+                                    target->adv_interval, latency, target->probability);
+        if(scan_int != 0)
+        {
+            scan_schedule(profile, scan_int, scan_win, &schedule);
+            if(!found || scan_schedule_cheaper(&schedule, &best))
+            {
+                best  = schedule;
+                found = true;
+            }
+        }
+    }
+
+    if(!found)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Discovery target cannot be met with this profile. \n");
         return CY_RSLT_MW_ERROR;
     }
-    else if(res != WICED_BT_SUCCESS && res != WICED_BT_PENDING)
+
+    bt_config->scan_int = (uint16_t)best.scan_int;
+    bt_config->scan_win = (uint16_t)best.scan_win;
+    if(estimate != NULL)
+    {
+        scan_estimate(&best, target, estimate);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_estimate_scan(const cy_smartcoex_bt_config_t *bt_config, const cy_smartcoex_discovery_target_t *target,
+                                     cy_smartcoex_scan_estimate_t *estimate)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_estimate_scan(ctx, bt_config, target, estimate) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_recommend_scan(const cy_smartcoex_discovery_target_t *target, cy_smartcoex_bt_config_t *bt_config,
+                                      cy_smartcoex_scan_estimate_t *estimate)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_recommend_scan(ctx, target, bt_config, estimate) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_config(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx == NULL)
     {
-        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "wiced_bt_dev_vendor_specific_command failed with error:[0x%X]\n", (unsigned int)res);
         return CY_RSLT_MW_ERROR;
     }
 
-    return set_wifi_coex_config(wifi_config, &whd_coex_config);
+    return cy_smartcoex_ctx_config(ctx, wifi_config, bt_config);
+}
+
+cy_rslt_t cy_smartcoex_config_batch(cy_smartcoex_wifi_config_t *wifi_configs, uint8_t count, cy_smartcoex_bt_config_t *bt_config)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return cy_smartcoex_ctx_config_batch(ctx, wifi_configs, count, bt_config);
+}
+
+void cy_smartcoex_force_resync(void)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx != NULL)
+    {
+        (void)cy_smartcoex_ctx_force_resync(ctx);
+    }
 }
@@ -0,0 +1,574 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_arbiter.c
+* @brief Arbiter that merges the coex demands of several clients.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_arbiter.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Arbiter thread parameters */
+#ifndef CY_SMARTCOEX_ARBITER_THREAD_STACK_SIZE
+#define CY_SMARTCOEX_ARBITER_THREAD_STACK_SIZE  (2048)
+#endif
+
+#ifndef CY_SMARTCOEX_ARBITER_THREAD_PRIORITY
+#define CY_SMARTCOEX_ARBITER_THREAD_PRIORITY    (CY_RTOS_PRIORITY_NORMAL)
+#endif
+
+/* Retry policy when the commit fails as busy; other failures are not retried */
+#ifndef CY_SMARTCOEX_ARBITER_BUSY_RETRY_MAX
+#define CY_SMARTCOEX_ARBITER_BUSY_RETRY_MAX      (8)
+#endif
+
+#ifndef CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MIN_MS
+#define CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MIN_MS (5)  // in milliseconds
+#endif
+
+#ifndef CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MAX_MS
+#define CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MAX_MS (80) // in milliseconds
+#endif
+
+/* Shortest scan window the BT controller accepts */
+#define SMARTCOEX_ARBITER_SCAN_WINDOW_MIN       (4) // in slots
+
+#if CY_SMARTCOEX_ARBITER_MAX_CLIENTS > 32
+#error "CY_SMARTCOEX_ARBITER_MAX_CLIENTS must not exceed 32"
+#endif
+
+typedef struct
+{
+    bool                  registered;
+    bool                  active;
+    cy_smartcoex_demand_t demand;
+    cy_time_t             submitted;
+} smartcoex_arbiter_client_t;
+
+/**
+ * Arbiter state. The mutex guards the client table and the counters; it is
+ * never held across a commit.
+ */
+struct cy_smartcoex_arbiter
+{
+    cy_smartcoex_ctx_t          *ctx;
+    cy_smartcoex_wifi_config_t  wifi_config;
+    cy_smartcoex_bt_config_t    base;
+    cy_smartcoex_arbiter_cb_t   cb;
+    void                        *cb_arg;
+    volatile bool               exit;
+    cy_thread_t                 thread;
+    cy_mutex_t                  mutex;
+    cy_semaphore_t              wakeup;
+
+    smartcoex_arbiter_client_t  clients[CY_SMARTCOEX_ARBITER_MAX_CLIENTS];
+
+    bool                        applied_valid;
+    cy_smartcoex_bt_config_t    applied;
+    bool                        failed_valid;   /* failed was not committed; not retried until the merge changes */
+    cy_smartcoex_bt_config_t    failed;
+    uint32_t                    busy_retries;   /* Busy retries of the current commit */
+    cy_time_t                   backoff_ms;
+    int8_t                      priority_client;
+    uint32_t                    merges;
+    uint32_t                    commits;
+    uint32_t                    failures;
+};
+
+/* Orders profiles by WLAN priority, then duty cycle, then ID so that ties resolve the same way every time */
+static uint32_t arbiter_rank(cy_smartcoex_ctx_t *ctx, cy_smartcoex_lescan_priority_t profile_id)
+{
+    const smartcoex_profile_entry_t *entry = &ctx->profiles[profile_id];
+
+    return ((uint32_t)entry->wifi_params.priority << 16) | ((uint32_t)entry->vsc_param.scanDutyCycle << 8) | (uint32_t)profile_id;
+}
+
+/*
+ * Merges the demands in force into bt_config in one pass over the clients, and
+ * lapses those past their deadline. Returns the client that set the priority,
+ * or -1; wait_ms receives the time until the next demand lapses. Called with
+ * the mutex held.
+ */
+static int8_t arbiter_merge(cy_smartcoex_arbiter_t *arbiter, cy_time_t now, cy_smartcoex_bt_config_t *bt_config, cy_time_t *wait_ms)
+{
+    smartcoex_arbiter_client_t *client;
+    uint32_t rank;
+    uint32_t best_rank = 0;
+    uint32_t scan_int = 0;
+    uint32_t win;
+    uint32_t max_win = 0;
+    cy_time_t elapsed;
+    int8_t owner = -1;
+    uint8_t i;
+
+    *wait_ms   = CY_RTOS_NEVER_TIMEOUT;
+    *bt_config = arbiter->base;
+
+    /* The merged interval is needed to scale each window, so track the shortest interval first */
+    for(i = 0; i < CY_SMARTCOEX_ARBITER_MAX_CLIENTS; i++)
+    {
+        client = &arbiter->clients[i];
+        if(!client->active)
+        {
+            continue;
+        }
+
+        if(client->demand.deadline_ms != 0)
+        {
+            elapsed = now - client->submitted;
+            if(elapsed >= client->demand.deadline_ms)
+            {
+                client->active = false;
+                continue;
+            }
+            if(client->demand.deadline_ms - elapsed < *wait_ms)
+            {
+                *wait_ms = client->demand.deadline_ms - elapsed;
+            }
+        }
+
+        rank = arbiter_rank(arbiter->ctx, client->demand.scan_priority);
+        if(owner < 0 || rank > best_rank)
+        {
+            best_rank = rank;
+            owner     = (int8_t)i;
+        }
+
+        if(client->demand.scan_int != 0 && (scan_int == 0 || client->demand.scan_int < scan_int))
+        {
+            scan_int = client->demand.scan_int;
+        }
+    }
+
+    if(owner >= 0)
+    {
+        bt_config->scan_priority = arbiter->clients[owner].demand.scan_priority;
+    }
+
+    if(scan_int != 0)
+    {
+        /* Each client keeps at least its share of scan time, win/int, at the shorter interval */
+        for(i = 0; i < CY_SMARTCOEX_ARBITER_MAX_CLIENTS; i++)
+        {
+            client = &arbiter->clients[i];
+            if(client->active && client->demand.scan_int != 0)
+            {
+                win = ((uint32_t)client->demand.scan_win * scan_int + client->demand.scan_int - 1U) / client->demand.scan_int;
+                if(win > max_win)
+                {
+                    max_win = win;
+                }
+            }
+        }
+        if(max_win < SMARTCOEX_ARBITER_SCAN_WINDOW_MIN)
+        {
+            max_win = SMARTCOEX_ARBITER_SCAN_WINDOW_MIN;
+        }
+        if(max_win > scan_int)
+        {
+            max_win = scan_int;
+        }
+        bt_config->scan_int = (uint16_t)scan_int;
+        bt_config->scan_win = (uint16_t)max_win;
+    }
+
+    return owner;
+}
+
+static bool arbiter_changed(const cy_smartcoex_bt_config_t *a, const cy_smartcoex_bt_config_t *b)
+{
+    return a->scan_priority != b->scan_priority || a->scan_int != b->scan_int || a->scan_win != b->scan_win;
+}
+
+/* Merges the demands and commits on change. Returns how long to wait for the next event */
+static cy_time_t arbiter_run(cy_smartcoex_arbiter_t *arbiter)
+{
+    cy_smartcoex_bt_config_t bt_config;
+    cy_rslt_t result = CY_RSLT_MW_BADARG;
+    cy_time_t now = 0;
+    cy_time_t wait_ms;
+    int8_t owner;
+    bool bt_busy = false;
+    bool report  = true;
+
+    (void)cy_rtos_get_time(&now);
+
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    owner = arbiter_merge(arbiter, now, &bt_config, &wait_ms);
+    arbiter->merges++;
+    arbiter->priority_client = owner;
+    if(arbiter->applied_valid && !arbiter_changed(&bt_config, &arbiter->applied))
+    {
+        cy_rtos_set_mutex(&arbiter->mutex);
+        return wait_ms;
+    }
+    if(arbiter->failed_valid && !arbiter_changed(&bt_config, &arbiter->failed))
+    {
+        cy_rtos_set_mutex(&arbiter->mutex);
+        return wait_ms;
+    }
+    arbiter->failed_valid = false;
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Arbiter merged profile %u, scan %u/%u\n", (unsigned int)bt_config.scan_priority,
+                         (unsigned int)bt_config.scan_win, (unsigned int)bt_config.scan_int);
+
+    if(smartcoex_validate(arbiter->ctx, &arbiter->wifi_config, &bt_config))
+    {
+        result = smartcoex_commit(arbiter->ctx, &arbiter->wifi_config, &bt_config, &bt_busy);
+    }
+
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    arbiter->applied_valid = (result == CY_RSLT_SUCCESS);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        arbiter->applied = bt_config;
+        arbiter->commits++;
+    }
+    else if(bt_busy && arbiter->busy_retries < CY_SMARTCOEX_ARBITER_BUSY_RETRY_MAX)
+    {
+        /* Transient; retried with backoff, and only the final result is reported */
+        arbiter->busy_retries++;
+        if(wait_ms > arbiter->backoff_ms)
+        {
+            wait_ms = arbiter->backoff_ms;
+        }
+        arbiter->backoff_ms = (arbiter->backoff_ms * 2U > CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MAX_MS) ?
+                              CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MAX_MS : arbiter->backoff_ms * 2U;
+        report = false;
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Retrying arbiter commit after BT busy, attempt %u\n", (unsigned int)arbiter->busy_retries);
+    }
+    else
+    {
+        arbiter->failed_valid = true;
+        arbiter->failed       = bt_config;
+        arbiter->failures++;
+    }
+    if(report)
+    {
+        arbiter->busy_retries = 0;
+        arbiter->backoff_ms   = CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MIN_MS;
+    }
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    if(report && arbiter->cb != NULL)
+    {
+        arbiter->cb(result, &bt_config, arbiter->cb_arg);
+    }
+
+    return wait_ms;
+}
+
+static void arbiter_worker(cy_thread_arg_t arg)
+{
+    cy_smartcoex_arbiter_t *arbiter = (cy_smartcoex_arbiter_t *)arg;
+    cy_time_t wait_ms = 0;
+
+    while(!arbiter->exit)
+    {
+        if(wait_ms != 0)
+        {
+            cy_rtos_get_semaphore(&arbiter->wakeup, wait_ms, false);
+            if(arbiter->exit)
+            {
+                break;
+            }
+        }
+        wait_ms = arbiter_run(arbiter);
+    }
+
+    cy_rtos_exit_thread();
+}
+
+static bool arbiter_client_valid(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id)
+{
+    return arbiter != NULL && client_id < CY_SMARTCOEX_ARBITER_MAX_CLIENTS && arbiter->clients[client_id].registered;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_create(cy_smartcoex_arbiter_t **arbiter, cy_smartcoex_ctx_t *ctx,
+                                      cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                      cy_smartcoex_arbiter_cb_t cb, void *cb_arg)
+{
+    cy_smartcoex_arbiter_t *new_arbiter;
+    cy_rslt_t result;
+
+    if(arbiter == NULL || wifi_config == NULL || bt_config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(ctx == NULL)
+    {
+        ctx = smartcoex_default_ctx();
+        if(ctx == NULL)
+        {
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+
+    if(!smartcoex_validate(ctx, wifi_config, bt_config))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    new_arbiter = (cy_smartcoex_arbiter_t *)calloc(1, sizeof(cy_smartcoex_arbiter_t));
+    if(new_arbiter == NULL)
+    {
+        return CY_RSLT_MW_NOMEM;
+    }
+    new_arbiter->ctx             = ctx;
+    new_arbiter->wifi_config     = *wifi_config;
+    new_arbiter->base            = *bt_config;
+    new_arbiter->cb              = cb;
+    new_arbiter->cb_arg          = cb_arg;
+    new_arbiter->priority_client = -1;
+    new_arbiter->backoff_ms      = CY_SMARTCOEX_ARBITER_BUSY_BACKOFF_MIN_MS;
+
+    result = cy_rtos_init_mutex(&new_arbiter->mutex);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(new_arbiter);
+        return result;
+    }
+
+    result = cy_rtos_init_semaphore(&new_arbiter->wakeup, 1, 0);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&new_arbiter->mutex);
+        free(new_arbiter);
+        return result;
+    }
+
+    result = cy_rtos_create_thread(&new_arbiter->thread, arbiter_worker, "smartcoex_arbiter", NULL,
+                                   CY_SMARTCOEX_ARBITER_THREAD_STACK_SIZE, CY_SMARTCOEX_ARBITER_THREAD_PRIORITY, new_arbiter);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to create Smart Coex arbiter thread:[0x%X]\n", (unsigned int)result);
+        cy_rtos_deinit_semaphore(&new_arbiter->wakeup);
+        cy_rtos_deinit_mutex(&new_arbiter->mutex);
+        free(new_arbiter);
+        return result;
+    }
+
+    *arbiter = new_arbiter;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_destroy(cy_smartcoex_arbiter_t *arbiter)
+{
+    if(arbiter == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    arbiter->exit = true;
+    cy_rtos_set_semaphore(&arbiter->wakeup, false);
+    cy_rtos_join_thread(&arbiter->thread);
+
+    cy_rtos_deinit_semaphore(&arbiter->wakeup);
+    cy_rtos_deinit_mutex(&arbiter->mutex);
+    free(arbiter);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_add_client(cy_smartcoex_arbiter_t *arbiter, uint8_t *client_id)
+{
+    cy_rslt_t result = CY_RSLT_MW_NOMEM;
+    uint8_t i;
+
+    if(arbiter == NULL || client_id == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    for(i = 0; i < CY_SMARTCOEX_ARBITER_MAX_CLIENTS; i++)
+    {
+        if(!arbiter->clients[i].registered)
+        {
+            memset(&arbiter->clients[i], 0, sizeof(arbiter->clients[i]));
+            arbiter->clients[i].registered = true;
+            *client_id = i;
+            result = CY_RSLT_SUCCESS;
+            break;
+        }
+    }
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Arbiter client table full. Increase CY_SMARTCOEX_ARBITER_MAX_CLIENTS.\n");
+    }
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_remove_client(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id)
+{
+    bool was_active;
+
+    if(arbiter == NULL || client_id >= CY_SMARTCOEX_ARBITER_MAX_CLIENTS)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(!arbiter->clients[client_id].registered)
+    {
+        cy_rtos_set_mutex(&arbiter->mutex);
+        return CY_RSLT_MW_BADARG;
+    }
+    was_active = arbiter->clients[client_id].active;
+    arbiter->clients[client_id].registered = false;
+    arbiter->clients[client_id].active     = false;
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    if(was_active)
+    {
+        cy_rtos_set_semaphore(&arbiter->wakeup, false);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_submit(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id, const cy_smartcoex_demand_t *demand)
+{
+    cy_smartcoex_bt_config_t bt_config;
+    cy_time_t now = 0;
+
+    if(!arbiter_client_valid(arbiter, client_id) || demand == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    bt_config               = arbiter->base;
+    bt_config.scan_priority = demand->scan_priority;
+    if(demand->scan_int != 0)
+    {
+        bt_config.scan_int = demand->scan_int;
+        bt_config.scan_win = demand->scan_win;
+    }
+    if(!smartcoex_validate(arbiter->ctx, &arbiter->wifi_config, &bt_config))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    (void)cy_rtos_get_time(&now);
+
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(!arbiter->clients[client_id].registered)
+    {
+        cy_rtos_set_mutex(&arbiter->mutex);
+        return CY_RSLT_MW_BADARG;
+    }
+    arbiter->clients[client_id].demand    = *demand;
+    arbiter->clients[client_id].submitted = now;
+    arbiter->clients[client_id].active    = true;
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    cy_rtos_set_semaphore(&arbiter->wakeup, false);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_withdraw(cy_smartcoex_arbiter_t *arbiter, uint8_t client_id)
+{
+    bool was_active;
+
+    if(arbiter == NULL || client_id >= CY_SMARTCOEX_ARBITER_MAX_CLIENTS)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(!arbiter->clients[client_id].registered)
+    {
+        cy_rtos_set_mutex(&arbiter->mutex);
+        return CY_RSLT_MW_BADARG;
+    }
+    was_active = arbiter->clients[client_id].active;
+    arbiter->clients[client_id].active = false;
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    if(was_active)
+    {
+        cy_rtos_set_semaphore(&arbiter->wakeup, false);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_arbiter_get_state(cy_smartcoex_arbiter_t *arbiter, cy_smartcoex_arbiter_state_t *state)
+{
+    uint8_t i;
+
+    if(arbiter == NULL || state == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    memset(state, 0, sizeof(*state));
+    cy_rtos_get_mutex(&arbiter->mutex, CY_RTOS_NEVER_TIMEOUT);
+    for(i = 0; i < CY_SMARTCOEX_ARBITER_MAX_CLIENTS; i++)
+    {
+        if(arbiter->clients[i].registered)
+        {
+            state->clients |= 1UL << i;
+        }
+        if(arbiter->clients[i].active)
+        {
+            state->active |= 1UL << i;
+        }
+    }
+    state->priority_client = arbiter->priority_client;
+    state->scan_priority   = arbiter->applied.scan_priority;
+    state->scan_int        = arbiter->applied.scan_int;
+    state->scan_win        = arbiter->applied.scan_win;
+    state->merges          = arbiter->merges;
+    state->commits         = arbiter->commits;
+    state->failures        = arbiter->failures;
+    cy_rtos_set_mutex(&arbiter->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
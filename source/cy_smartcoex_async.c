@@ -0,0 +1,310 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <stdlib.h>
+
+/* Async worker thread parameters */
+#ifndef CY_SMARTCOEX_ASYNC_THREAD_STACK_SIZE
+#define CY_SMARTCOEX_ASYNC_THREAD_STACK_SIZE    (2048)
+#endif
+
+#ifndef CY_SMARTCOEX_ASYNC_THREAD_PRIORITY
+#define CY_SMARTCOEX_ASYNC_THREAD_PRIORITY      (CY_RTOS_PRIORITY_NORMAL)
+#endif
+
+/* Retry policy when the BT stack reports WICED_BT_BUSY */
+#ifndef CY_SMARTCOEX_ASYNC_BUSY_RETRY_MAX
+#define CY_SMARTCOEX_ASYNC_BUSY_RETRY_MAX       (8)
+#endif
+
+#ifndef CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MIN_MS
+#define CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MIN_MS  (5)  // in milliseconds
+#endif
+
+#ifndef CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MAX_MS
+#define CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MAX_MS  (80) // in milliseconds
+#endif
+
+/**
+ * Async update state of a context. The worker owns everything outside the
+ * mutex; the mutex only guards the single latest-wins request slot.
+ */
+struct smartcoex_async
+{
+    cy_smartcoex_ctx_t         *ctx;
+    volatile bool              exit;
+    cy_thread_t                thread;
+    cy_mutex_t                 mutex;
+    cy_semaphore_t             wakeup;
+    cy_smartcoex_async_cb_t    cb;
+    void                       *cb_arg;
+
+    bool                       pending;
+    cy_smartcoex_wifi_config_t pending_wifi;
+    cy_smartcoex_bt_config_t   pending_bt;
+};
+
+static bool async_take_pending(smartcoex_async_t *async, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+{
+    bool taken;
+
+    cy_rtos_get_mutex(&async->mutex, CY_RTOS_NEVER_TIMEOUT);
+    taken = async->pending;
+    if(taken)
+    {
+        *wifi_config   = async->pending_wifi;
+        *bt_config     = async->pending_bt;
+        async->pending = false;
+    }
+    cy_rtos_set_mutex(&async->mutex);
+
+    return taken;
+}
+
+static bool async_has_pending(smartcoex_async_t *async)
+{
+    bool pending;
+
+    cy_rtos_get_mutex(&async->mutex, CY_RTOS_NEVER_TIMEOUT);
+    pending = async->pending;
+    cy_rtos_set_mutex(&async->mutex);
+
+    return pending;
+}
+
+static void async_worker(cy_thread_arg_t arg)
+{
+    smartcoex_async_t *async = (smartcoex_async_t *)arg;
+    cy_smartcoex_wifi_config_t wifi_config;
+    cy_smartcoex_bt_config_t bt_config;
+    cy_rslt_t result;
+    uint32_t retries;
+    uint32_t backoff_ms;
+    bool bt_busy;
+
+    while(!async->exit)
+    {
+        cy_rtos_get_semaphore(&async->wakeup, CY_RTOS_NEVER_TIMEOUT, false);
+
+        while(!async->exit && async_take_pending(async, &wifi_config, &bt_config))
+        {
+            retries    = 0;
+            backoff_ms = CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MIN_MS;
+
+            result = smartcoex_commit(async->ctx, &wifi_config, &bt_config, &bt_busy);
+            while(bt_busy && retries < CY_SMARTCOEX_ASYNC_BUSY_RETRY_MAX && !async->exit)
+            {
+                cy_rtos_delay_milliseconds(backoff_ms);
+                if(async_has_pending(async))
+                {
+                    /* A newer request supersedes this one; commit that instead */
+                    break;
+                }
+                retries++;
+                backoff_ms = (backoff_ms * 2U > CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MAX_MS) ?
+                             CY_SMARTCOEX_ASYNC_BUSY_BACKOFF_MAX_MS : backoff_ms * 2U;
+                cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Retrying coex commit after BT busy, attempt %u\n", (unsigned int)retries);
+                result = smartcoex_commit(async->ctx, &wifi_config, &bt_config, &bt_busy);
+            }
+
+            if(bt_busy && async_has_pending(async))
+            {
+                continue;
+            }
+
+            if(async->cb != NULL)
+            {
+                async->cb(result, &bt_config, async->cb_arg);
+            }
+        }
+
+        /* A VSC failure may have left a Wi-Fi rollback due; the completion callback does not run it */
+        if(!async->exit)
+        {
+            cy_rtos_get_mutex(&async->ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+            smartcoex_vsc_settle(async->ctx);
+            cy_rtos_set_mutex(&async->ctx->mutex);
+        }
+    }
+
+    cy_rtos_exit_thread();
+}
+
+void smartcoex_async_release(cy_smartcoex_ctx_t *ctx)
+{
+    smartcoex_async_t *async = ctx->async;
+
+    if(async == NULL)
+    {
+        return;
+    }
+
+    smartcoex_vsc_set_notify(ctx, NULL);
+    async->exit = true;
+    cy_rtos_set_semaphore(&async->wakeup, false);
+    cy_rtos_join_thread(&async->thread);
+
+    cy_rtos_deinit_semaphore(&async->wakeup);
+    cy_rtos_deinit_mutex(&async->mutex);
+    ctx->async = NULL;
+    free(async);
+}
+
+cy_rslt_t cy_smartcoex_ctx_async_init(cy_smartcoex_ctx_t *ctx, cy_smartcoex_async_cb_t cb, void *arg)
+{
+    smartcoex_async_t *async;
+    cy_rslt_t result;
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(ctx->async != NULL)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Smart Coex async updates already initialized\n");
+        return CY_RSLT_MW_ERROR;
+    }
+
+    async = (smartcoex_async_t *)calloc(1, sizeof(smartcoex_async_t));
+    if(async == NULL)
+    {
+        return CY_RSLT_MW_NOMEM;
+    }
+    async->ctx    = ctx;
+    async->cb     = cb;
+    async->cb_arg = arg;
+
+    result = cy_rtos_init_mutex(&async->mutex);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(async);
+        return result;
+    }
+
+    result = cy_rtos_init_semaphore(&async->wakeup, 1, 0);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&async->mutex);
+        free(async);
+        return result;
+    }
+
+    result = cy_rtos_create_thread(&async->thread, async_worker, "smartcoex_async", NULL,
+                                   CY_SMARTCOEX_ASYNC_THREAD_STACK_SIZE, CY_SMARTCOEX_ASYNC_THREAD_PRIORITY, async);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to create Smart Coex async thread:[0x%X]\n", (unsigned int)result);
+        cy_rtos_deinit_semaphore(&async->wakeup);
+        cy_rtos_deinit_mutex(&async->mutex);
+        free(async);
+        return result;
+    }
+
+    ctx->async = async;
+    smartcoex_vsc_set_notify(ctx, &async->wakeup);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_async_deinit(cy_smartcoex_ctx_t *ctx)
+{
+    if(ctx == NULL || ctx->async == NULL)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    smartcoex_async_release(ctx);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_config_async(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+{
+    smartcoex_async_t *async;
+
+    if(ctx == NULL || wifi_config == NULL || bt_config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    async = ctx->async;
+    if(async == NULL)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Smart Coex async updates not initialized\n");
+        return CY_RSLT_MW_ERROR;
+    }
+
+    if(!smartcoex_validate(ctx, wifi_config, bt_config))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&async->mutex, CY_RTOS_NEVER_TIMEOUT);
+    async->pending_wifi = *wifi_config;
+    async->pending_bt   = *bt_config;
+    async->pending      = true;
+    cy_rtos_set_mutex(&async->mutex);
+
+    cy_rtos_set_semaphore(&async->wakeup, false);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_async_init(cy_smartcoex_async_cb_t cb, void *arg)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_async_init(ctx, cb, arg) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_async_deinit(void)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_async_deinit(ctx) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_config_async(cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_config_async(ctx, wifi_config, bt_config) : CY_RSLT_MW_ERROR;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_binlog.c
+* @brief Deferred binary logging: a lock-free ring of unformatted records.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(ENABLE_SMARTCOEX_BINARY_LOGS)
+
+#if (CY_SMARTCOEX_BINARY_LOG_RECORDS & (CY_SMARTCOEX_BINARY_LOG_RECORDS - 1)) != 0
+#error "CY_SMARTCOEX_BINARY_LOG_RECORDS must be a power of two"
+#endif
+
+#define BINLOG_MASK     (CY_SMARTCOEX_BINARY_LOG_RECORDS - 1U)
+
+/* Bounds of the format string section, provided by the linker */
+extern const char __start_smartcoex_log_fmt[];
+
+/*
+ * Writers claim a slot with an atomic increment of binlog_head, then publish it
+ * by storing its sequence number last. A slot whose seq is 0 is being written.
+ * Readers copy a slot and accept it only if seq was the expected value before
+ * and after the copy.
+ */
+static cy_smartcoex_binlog_record_t binlog_ring[CY_SMARTCOEX_BINARY_LOG_RECORDS];
+static uint32_t binlog_head = 0;
+
+void cy_smartcoex_binlog_write(uint8_t level, const char *fmt, uint8_t nargs, const uint32_t *args)
+{
+    cy_smartcoex_binlog_record_t *record;
+    uint32_t seq;
+    uint8_t i;
+
+    seq    = __atomic_add_fetch(&binlog_head, 1U, __ATOMIC_RELAXED);
+    record = &binlog_ring[(seq - 1U) & BINLOG_MASK];
+
+    __atomic_store_n(&record->seq, 0U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if(nargs > CY_SMARTCOEX_BINARY_LOG_MAX_ARGS)
+    {
+        nargs = CY_SMARTCOEX_BINARY_LOG_MAX_ARGS;
+    }
+    record->timestamp = get_timestamp();
+    record->fmt_id    = (uint16_t)(fmt - __start_smartcoex_log_fmt);
+    record->level     = level;
+    record->nargs     = nargs;
+    for(i = 0; i < nargs; i++)
+    {
+        record->args[i] = args[i];
+    }
+
+    __atomic_store_n(&record->seq, seq, __ATOMIC_RELEASE);
+}
+
+uint32_t cy_smartcoex_binlog_read(uint32_t *cursor, cy_smartcoex_binlog_record_t *records, uint32_t max_records,
+                                  uint32_t *us_per_mtick)
+{
+    const cy_smartcoex_binlog_record_t *record;
+    uint32_t head;
+    uint32_t seq;
+    uint32_t count = 0;
+
+    if(us_per_mtick != NULL)
+    {
+        *us_per_mtick = timestamp_to_us(1000000U);
+    }
+
+    if(cursor == NULL || records == NULL)
+    {
+        return 0;
+    }
+
+    head = __atomic_load_n(&binlog_head, __ATOMIC_ACQUIRE);
+    seq  = *cursor + 1U;
+    if(head - *cursor > CY_SMARTCOEX_BINARY_LOG_RECORDS)
+    {
+        seq = head - CY_SMARTCOEX_BINARY_LOG_RECORDS + 1U;
+    }
+
+    for(; seq != head + 1U && count < max_records; seq++)
+    {
+        record = &binlog_ring[(seq - 1U) & BINLOG_MASK];
+        if(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != seq)
+        {
+            /* Still being written, or already overwritten by a newer record */
+            continue;
+        }
+        records[count] = *record;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&record->seq, __ATOMIC_RELAXED) != seq)
+        {
+            continue;
+        }
+        records[count].seq = seq;
+        count++;
+        *cursor = seq;
+    }
+
+    return count;
+}
+
+const char *cy_smartcoex_binlog_fmt(uint16_t fmt_id)
+{
+    return &__start_smartcoex_log_fmt[fmt_id];
+}
+
+#endif /* ENABLE_SMARTCOEX_BINARY_LOGS */
+
+int cy_smartcoex_binlog_format(const char *fmt, const cy_smartcoex_binlog_record_t *record, char *buf, size_t len)
+{
+    char spec[16];
+    size_t spec_len;
+    size_t out = 0;
+    size_t room;
+    uint8_t arg = 0;
+    uint32_t value;
+    int n;
+
+    if(fmt == NULL || record == NULL || buf == NULL || len == 0)
+    {
+        return 0;
+    }
+
+    while(*fmt != '\0')
+    {
+        if(*fmt != '%' || fmt[1] == '%')
+        {
+            if(out + 1 < len)
+            {
+                buf[out] = *fmt;
+            }
+            out++;
+            fmt += (*fmt == '%') ? 2 : 1;
+            continue;
+        }
+
+        /* Rebuild "%[flags][width][.precision]<conversion>"; arguments are 32 bits wide, so length modifiers are dropped */
+        spec_len = 0;
+        spec[spec_len++] = *fmt++;
+        while(*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL && spec_len < sizeof(spec) - 2)
+        {
+            spec[spec_len++] = *fmt++;
+        }
+        while(*fmt != '\0' && strchr("hlz", *fmt) != NULL)
+        {
+            fmt++;
+        }
+        if(*fmt == '\0')
+        {
+            break;
+        }
+
+        value = (arg < record->nargs) ? record->args[arg] : 0U;
+        arg++;
+        room  = (out < len) ? len - out : 0;
+
+        if(strchr("diuxXoc", *fmt) == NULL)
+        {
+            spec[0]  = '?';
+            spec_len = 1;
+        }
+        else
+        {
+            spec[spec_len++] = *fmt;
+        }
+        spec[spec_len] = '\0';
+
+        if(*fmt == 'd' || *fmt == 'i')
+        {
+            n = snprintf((room != 0) ? buf + out : NULL, room, spec, (int)value);
+        }
+        else
+        {
+            n = snprintf((room != 0) ? buf + out : NULL, room, spec, (unsigned int)value);
+        }
+        out += (n > 0) ? (size_t)n : 0U;
+        fmt++;
+    }
+
+    buf[(out < len) ? out : len - 1] = '\0';
+
+    return (int)out;
+}
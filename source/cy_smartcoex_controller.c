@@ -0,0 +1,412 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_controller.c
+* @brief Closed-loop adaptive coex controller.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_controller.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SMARTCOEX_CONTROLLER_LEVEL_NONE     (0xFF)
+
+/**
+ * Controller state. The mutex guards everything; it is taken before the
+ * context mutex when a level is committed.
+ */
+struct cy_smartcoex_controller
+{
+    cy_smartcoex_ctx_t               *ctx;
+    cy_mutex_t                       mutex;
+    cy_smartcoex_controller_config_t config;
+    cy_smartcoex_wifi_config_t       wifi_config;
+    cy_smartcoex_bt_config_t         bt_config;
+    smartcoex_profile_entry_t        levels[CY_SMARTCOEX_CONTROLLER_MAX_LEVELS];
+
+    uint8_t                          level;
+    uint8_t                          applied_level;
+    int8_t                           direction;
+    uint8_t                          streak;
+    bool                             scan_params_changed;
+
+    uint32_t                         adv_reports;
+    bool                             counters_valid;
+    uint32_t                         wifi_bytes;
+    uint32_t                         wifi_frames;
+    uint32_t                         wifi_retries;
+};
+
+/* Interpolates between the bounds of the configuration; level 0 returns from */
+static uint8_t controller_interpolate(uint8_t from, uint8_t to, uint8_t level, uint8_t levels)
+{
+    int32_t span = (int32_t)to - (int32_t)from;
+
+    return (uint8_t)((int32_t)from + (span * level) / (levels - 1));
+}
+
+static bool controller_build_levels(cy_smartcoex_controller_t *ctrl)
+{
+    const cy_smartcoex_controller_config_t *config = &ctrl->config;
+    cy_smartcoex_profile_t profile;
+    uint8_t i;
+
+    for(i = 0; i < config->levels; i++)
+    {
+        if(i == 0)
+        {
+            profile.priority = CY_SMARTCOEX_LESCAN_PRIORITY_LOW;
+        }
+        else if(i == config->levels - 1)
+        {
+            profile.priority = CY_SMARTCOEX_LESCAN_PRIORITY_HIGH;
+        }
+        else
+        {
+            profile.priority = CY_SMARTCOEX_LESCAN_PRIORITY_MEDIUM;
+        }
+        profile.duty_cycle           = controller_interpolate(config->duty_cycle_min, config->duty_cycle_max, i, config->levels);
+        profile.small_interval_grant = controller_interpolate(config->small_interval_grant_max, config->small_interval_grant_min, i, config->levels);
+        profile.max_scan_window      = config->max_scan_window;
+
+        if(!smartcoex_build_profile(&profile, &ctrl->levels[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool controller_config_valid(const cy_smartcoex_controller_config_t *config)
+{
+    if(config->levels < 2 || config->levels > CY_SMARTCOEX_CONTROLLER_MAX_LEVELS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid number of levels. Must be in the range of 2 to %d. \n",
+                              CY_SMARTCOEX_CONTROLLER_MAX_LEVELS);
+        return false;
+    }
+
+    if(config->duty_cycle_min > config->duty_cycle_max ||
+       config->small_interval_grant_min > config->small_interval_grant_max)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid controller bounds. Minimum must not exceed maximum. \n");
+        return false;
+    }
+
+    if(config->ble_idle_reports_per_sec >= config->ble_active_reports_per_sec)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid BLE thresholds. Idle rate must be below active rate. \n");
+        return false;
+    }
+
+    if(config->wifi_retry_max_percent > 100 || config->hold_samples == 0)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid retry limit or hold samples. \n");
+        return false;
+    }
+
+    return true;
+}
+
+/* Returns +1 to step towards BLE, -1 to step towards Wi-Fi, 0 to hold */
+static int8_t controller_direction(const cy_smartcoex_controller_config_t *config, const cy_smartcoex_controller_sample_t *sample)
+{
+    uint64_t adv_rate;
+    uint64_t wifi_kbps;
+    bool wifi_idle;
+
+    if(sample->interval_ms == 0)
+    {
+        return 0;
+    }
+
+    adv_rate  = ((uint64_t)sample->ble_adv_reports * 1000) / sample->interval_ms;
+    wifi_kbps = ((uint64_t)sample->wifi_bytes * 8) / sample->interval_ms;
+    wifi_idle = (wifi_kbps < config->wifi_idle_kbps);
+
+    if(adv_rate <= config->ble_idle_reports_per_sec)
+    {
+        return -1;
+    }
+
+    if(adv_rate < config->ble_active_reports_per_sec && !wifi_idle)
+    {
+        return 0;
+    }
+
+    /* Do not take more airtime from a Wi-Fi link that is already retrying heavily */
+    if(!wifi_idle && sample->wifi_frames != 0 &&
+       ((uint64_t)sample->wifi_retries * 100) > ((uint64_t)sample->wifi_frames * config->wifi_retry_max_percent))
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+void cy_smartcoex_controller_default_config(cy_smartcoex_controller_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->duty_cycle_min             = 10;
+    config->duty_cycle_max             = 50;
+    config->small_interval_grant_min   = 1;
+    config->small_interval_grant_max   = 8;
+    config->max_scan_window            = 48;
+    config->levels                     = 8;
+    config->ble_active_reports_per_sec = 10;
+    config->ble_idle_reports_per_sec   = 1;
+    config->wifi_idle_kbps             = 64;
+    config->wifi_retry_max_percent     = 20;
+    config->hold_samples               = 3;
+}
+
+cy_rslt_t cy_smartcoex_controller_create(cy_smartcoex_controller_t **ctrl, cy_smartcoex_ctx_t *ctx,
+                                         cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                         const cy_smartcoex_controller_config_t *config)
+{
+    cy_smartcoex_controller_t *new_ctrl;
+    cy_rslt_t result;
+
+    if(ctrl == NULL || wifi_config == NULL || bt_config == NULL || config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(ctx == NULL)
+    {
+        ctx = smartcoex_default_ctx();
+        if(ctx == NULL)
+        {
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+
+    if(!controller_config_valid(config))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    new_ctrl = (cy_smartcoex_controller_t *)malloc(sizeof(cy_smartcoex_controller_t));
+    if(new_ctrl == NULL)
+    {
+        return CY_RSLT_MW_NOMEM;
+    }
+    memset(new_ctrl, 0, sizeof(*new_ctrl));
+
+    new_ctrl->ctx                     = ctx;
+    new_ctrl->config                  = *config;
+    new_ctrl->wifi_config             = *wifi_config;
+    new_ctrl->bt_config               = *bt_config;
+    new_ctrl->bt_config.scan_priority = CY_SMARTCOEX_LESCAN_PRIORITY_LOW;
+    new_ctrl->applied_level           = SMARTCOEX_CONTROLLER_LEVEL_NONE;
+
+    if(!smartcoex_validate(ctx, &new_ctrl->wifi_config, &new_ctrl->bt_config) || !controller_build_levels(new_ctrl))
+    {
+        free(new_ctrl);
+        return CY_RSLT_MW_BADARG;
+    }
+
+    result = cy_rtos_init_mutex(&new_ctrl->mutex);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(new_ctrl);
+        return result;
+    }
+
+    *ctrl = new_ctrl;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_controller_destroy(cy_smartcoex_controller_t *ctrl)
+{
+    if(ctrl == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_deinit_mutex(&ctrl->mutex);
+    free(ctrl);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_smartcoex_controller_report_adv(cy_smartcoex_controller_t *ctrl, uint32_t count)
+{
+    cy_rtos_get_mutex(&ctrl->mutex, CY_RTOS_NEVER_TIMEOUT);
+    ctrl->adv_reports += count;
+    cy_rtos_set_mutex(&ctrl->mutex);
+}
+
+cy_rslt_t cy_smartcoex_controller_sample(cy_smartcoex_controller_t *ctrl, uint32_t interval_ms,
+                                         cy_smartcoex_controller_sample_t *sample)
+{
+    cy_rslt_t result;
+    uint32_t bytes, frames, retries;
+
+    if(ctrl == NULL || sample == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    memset(sample, 0, sizeof(*sample));
+    sample->interval_ms = interval_ms;
+
+    /* Read outside the controller lock; WHD counters are an ioctl */
+    result = get_wifi_counters(&ctrl->wifi_config, &bytes, &frames, &retries);
+
+    cy_rtos_get_mutex(&ctrl->mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    sample->ble_adv_reports = ctrl->adv_reports;
+    ctrl->adv_reports       = 0;
+
+    if(result == CY_RSLT_SUCCESS)
+    {
+        if(ctrl->counters_valid)
+        {
+            /* Unsigned subtraction handles counter wrap */
+            sample->wifi_bytes   = bytes - ctrl->wifi_bytes;
+            sample->wifi_frames  = frames - ctrl->wifi_frames;
+            sample->wifi_retries = retries - ctrl->wifi_retries;
+        }
+        ctrl->wifi_bytes     = bytes;
+        ctrl->wifi_frames    = frames;
+        ctrl->wifi_retries   = retries;
+        ctrl->counters_valid = true;
+    }
+
+    cy_rtos_set_mutex(&ctrl->mutex);
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_controller_step(cy_smartcoex_controller_t *ctrl, const cy_smartcoex_controller_sample_t *sample)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    int8_t direction;
+    bool bt_busy;
+
+    if(ctrl == NULL || sample == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    direction = controller_direction(&ctrl->config, sample);
+
+    cy_rtos_get_mutex(&ctrl->mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if(direction == 0 || direction != ctrl->direction)
+    {
+        ctrl->streak = 0;
+    }
+    ctrl->direction = direction;
+
+    if(direction != 0 && ++ctrl->streak >= ctrl->config.hold_samples)
+    {
+        ctrl->streak = 0;
+        if(direction > 0 && ctrl->level < ctrl->config.levels - 1)
+        {
+            ctrl->level++;
+        }
+        else if(direction < 0 && ctrl->level > 0)
+        {
+            ctrl->level--;
+        }
+    }
+
+    if(ctrl->level != ctrl->applied_level || ctrl->scan_params_changed)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Controller level %u\n", (unsigned int)ctrl->level);
+        result = smartcoex_commit_entry(ctrl->ctx, SMARTCOEX_WIFI_MASK(ctrl->wifi_config.interface), &ctrl->bt_config, &ctrl->levels[ctrl->level], &bt_busy);
+        if(result == CY_RSLT_SUCCESS)
+        {
+            ctrl->applied_level       = ctrl->level;
+            ctrl->scan_params_changed = false;
+        }
+    }
+
+    cy_rtos_set_mutex(&ctrl->mutex);
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_controller_set_scan_params(cy_smartcoex_controller_t *ctrl, uint16_t scan_int, uint16_t scan_win)
+{
+    cy_smartcoex_bt_config_t bt_config;
+
+    if(ctrl == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctrl->mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    bt_config          = ctrl->bt_config;
+    bt_config.scan_int = scan_int;
+    bt_config.scan_win = scan_win;
+    if(!smartcoex_validate(ctrl->ctx, &ctrl->wifi_config, &bt_config))
+    {
+        cy_rtos_set_mutex(&ctrl->mutex);
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(scan_int != ctrl->bt_config.scan_int || scan_win != ctrl->bt_config.scan_win)
+    {
+        ctrl->bt_config           = bt_config;
+        ctrl->scan_params_changed = true;
+    }
+
+    cy_rtos_set_mutex(&ctrl->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+uint8_t cy_smartcoex_controller_get_level(cy_smartcoex_controller_t *ctrl)
+{
+    uint8_t level;
+
+    cy_rtos_get_mutex(&ctrl->mutex, CY_RTOS_NEVER_TIMEOUT);
+    level = ctrl->level;
+    cy_rtos_set_mutex(&ctrl->mutex);
+
+    return level;
+}
@@ -0,0 +1,510 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_policy.c
+* @brief Event-driven policy engine that switches the coex profile.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_policy.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Policy engine thread parameters */
+#ifndef CY_SMARTCOEX_POLICY_THREAD_STACK_SIZE
+#define CY_SMARTCOEX_POLICY_THREAD_STACK_SIZE   (2048)
+#endif
+
+#ifndef CY_SMARTCOEX_POLICY_THREAD_PRIORITY
+#define CY_SMARTCOEX_POLICY_THREAD_PRIORITY     (CY_RTOS_PRIORITY_NORMAL)
+#endif
+
+/* Retry policy when the commit fails as busy; other failures are not retried */
+#ifndef CY_SMARTCOEX_POLICY_BUSY_RETRY_MAX
+#define CY_SMARTCOEX_POLICY_BUSY_RETRY_MAX      (8)
+#endif
+
+#ifndef CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MIN_MS
+#define CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MIN_MS (5)  // in milliseconds
+#endif
+
+#ifndef CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MAX_MS
+#define CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MAX_MS (80) // in milliseconds
+#endif
+
+/* Number of CY_SMARTCOEX_COND_* bits */
+#define SMARTCOEX_POLICY_CONDS                  (CY_SMARTCOEX_EVENT_MAX / 2)
+
+/**
+ * Policy engine state. The mutex guards the conditions and the scan parameters
+ * written by event posters; it is never held across a commit.
+ */
+struct cy_smartcoex_policy
+{
+    cy_smartcoex_ctx_t             *ctx;
+    cy_smartcoex_policy_config_t   config;
+    cy_smartcoex_wifi_config_t     wifi_config;
+    cy_smartcoex_bt_config_t       bt_config;
+    volatile bool                  exit;
+    cy_thread_t                    thread;
+    cy_mutex_t                     mutex;
+    cy_semaphore_t                 wakeup;
+
+    uint32_t                       conditions;
+    cy_time_t                      cond_since[SMARTCOEX_POLICY_CONDS];
+    bool                           dirty;
+    cy_time_t                      last_event;
+    bool                           scan_params_changed;
+
+    bool                           applied_valid;
+    cy_smartcoex_lescan_priority_t applied_priority;
+    int8_t                         active_rule;
+    uint32_t                       commits;
+    uint32_t                       failures;
+
+    uint32_t                       busy_retries;     /* Busy retries of the current commit */
+    cy_time_t                      backoff_ms;
+    bool                           failed_valid;     /* failed_priority failed; not retried until the next event */
+    cy_smartcoex_lescan_priority_t failed_priority;
+};
+
+static bool policy_config_valid(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config,
+                                cy_smartcoex_bt_config_t *bt_config, const cy_smartcoex_policy_config_t *config)
+{
+    cy_smartcoex_bt_config_t rule_bt_config = *bt_config;
+    const cy_smartcoex_policy_rule_t *rule;
+    uint8_t i;
+
+    if(config->rule_count > CY_SMARTCOEX_POLICY_MAX_RULES)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid number of rules. Must not exceed %d. \n", CY_SMARTCOEX_POLICY_MAX_RULES);
+        return false;
+    }
+
+    rule_bt_config.scan_priority = config->default_priority;
+    if(!smartcoex_validate(ctx, wifi_config, &rule_bt_config))
+    {
+        return false;
+    }
+
+    for(i = 0; i < config->rule_count; i++)
+    {
+        rule = &config->rules[i];
+        if((rule->require & rule->exclude) != 0 || (rule->duration_ms != 0 && rule->require == 0))
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid conditions in policy rule %u. \n", (unsigned int)i);
+            return false;
+        }
+
+        rule_bt_config.scan_priority = rule->scan_priority;
+        if(!smartcoex_validate(ctx, wifi_config, &rule_bt_config))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Returns the first matching rule, or -1. wait_ms receives the time until the
+ * earliest duration of a matching rule runs out. Called with the mutex held.
+ */
+static int8_t policy_evaluate(cy_smartcoex_policy_t *policy, cy_time_t now, cy_time_t *wait_ms)
+{
+    const cy_smartcoex_policy_rule_t *rule;
+    int8_t match = -1;
+    cy_time_t elapsed;
+    uint8_t i, c;
+
+    *wait_ms = CY_RTOS_NEVER_TIMEOUT;
+
+    for(i = 0; i < policy->config.rule_count; i++)
+    {
+        rule = &policy->config.rules[i];
+        if((policy->conditions & rule->require) != rule->require || (policy->conditions & rule->exclude) != 0)
+        {
+            continue;
+        }
+
+        if(rule->duration_ms != 0)
+        {
+            /* Timed from the latest of the required conditions to be set */
+            elapsed = CY_RTOS_NEVER_TIMEOUT;
+            for(c = 0; c < SMARTCOEX_POLICY_CONDS; c++)
+            {
+                if((rule->require & (1UL << c)) != 0 && (cy_time_t)(now - policy->cond_since[c]) < elapsed)
+                {
+                    elapsed = now - policy->cond_since[c];
+                }
+            }
+
+            if(elapsed >= rule->duration_ms)
+            {
+                continue;
+            }
+            if(rule->duration_ms - elapsed < *wait_ms)
+            {
+                *wait_ms = rule->duration_ms - elapsed;
+            }
+        }
+
+        if(match < 0)
+        {
+            match = (int8_t)i;
+        }
+    }
+
+    return match;
+}
+
+/* Evaluates the policy and commits on change. Returns how long to wait for the next event */
+static cy_time_t policy_run(cy_smartcoex_policy_t *policy)
+{
+    cy_smartcoex_bt_config_t bt_config;
+    cy_smartcoex_lescan_priority_t priority;
+    cy_rslt_t result = CY_RSLT_MW_BADARG;
+    cy_time_t now = 0;
+    cy_time_t wait_ms;
+    int8_t rule;
+    bool bt_busy = false;
+    bool report  = true;
+
+    (void)cy_rtos_get_time(&now);
+
+    cy_rtos_get_mutex(&policy->mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if(policy->dirty && (cy_time_t)(now - policy->last_event) < policy->config.debounce_ms)
+    {
+        wait_ms = policy->config.debounce_ms - (now - policy->last_event);
+        cy_rtos_set_mutex(&policy->mutex);
+        return wait_ms;
+    }
+    policy->dirty = false;
+
+    rule     = policy_evaluate(policy, now, &wait_ms);
+    priority = (rule >= 0) ? policy->config.rules[rule].scan_priority : policy->config.default_priority;
+    policy->active_rule = rule;
+
+    if(policy->applied_valid && priority == policy->applied_priority && !policy->scan_params_changed)
+    {
+        cy_rtos_set_mutex(&policy->mutex);
+        return wait_ms;
+    }
+    if(policy->failed_valid && priority == policy->failed_priority && !policy->scan_params_changed)
+    {
+        cy_rtos_set_mutex(&policy->mutex);
+        return wait_ms;
+    }
+
+    bt_config                   = policy->bt_config;
+    bt_config.scan_priority     = priority;
+    policy->scan_params_changed = false;
+    cy_rtos_set_mutex(&policy->mutex);
+
+    cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Policy rule %d selects profile %u\n", (int)rule, (unsigned int)priority);
+
+    /* Profiles may have been re-registered since the engine was created */
+    if(smartcoex_validate(policy->ctx, &policy->wifi_config, &bt_config))
+    {
+        result = smartcoex_commit(policy->ctx, &policy->wifi_config, &bt_config, &bt_busy);
+    }
+
+    cy_rtos_get_mutex(&policy->mutex, CY_RTOS_NEVER_TIMEOUT);
+    policy->applied_valid = (result == CY_RSLT_SUCCESS);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        policy->applied_priority = priority;
+        policy->commits++;
+    }
+    else if(bt_busy && policy->busy_retries < CY_SMARTCOEX_POLICY_BUSY_RETRY_MAX)
+    {
+        /* Transient; retried with backoff, and only the final result is reported */
+        policy->busy_retries++;
+        if(wait_ms > policy->backoff_ms)
+        {
+            wait_ms = policy->backoff_ms;
+        }
+        policy->backoff_ms = (policy->backoff_ms * 2U > CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MAX_MS) ?
+                             CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MAX_MS : policy->backoff_ms * 2U;
+        report = false;
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Retrying policy commit after BT busy, attempt %u\n", (unsigned int)policy->busy_retries);
+    }
+    else
+    {
+        policy->failed_valid    = true;
+        policy->failed_priority = priority;
+        policy->failures++;
+    }
+    if(report)
+    {
+        policy->busy_retries = 0;
+        policy->backoff_ms   = CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MIN_MS;
+    }
+    cy_rtos_set_mutex(&policy->mutex);
+
+    if(report && policy->config.cb != NULL)
+    {
+        policy->config.cb(result, priority, policy->config.cb_arg);
+    }
+
+    return wait_ms;
+}
+
+static void policy_worker(cy_thread_arg_t arg)
+{
+    cy_smartcoex_policy_t *policy = (cy_smartcoex_policy_t *)arg;
+    cy_time_t wait_ms = 0;
+
+    while(!policy->exit)
+    {
+        if(wait_ms != 0)
+        {
+            cy_rtos_get_semaphore(&policy->wakeup, wait_ms, false);
+            if(policy->exit)
+            {
+                break;
+            }
+        }
+        wait_ms = policy_run(policy);
+    }
+
+    cy_rtos_exit_thread();
+}
+
+static void policy_wifi_event(bool connected, void *arg)
+{
+    (void)cy_smartcoex_policy_post_event((cy_smartcoex_policy_t *)arg,
+                                         connected ? CY_SMARTCOEX_EVENT_WIFI_CONNECTED : CY_SMARTCOEX_EVENT_WIFI_DISCONNECTED);
+}
+
+cy_rslt_t cy_smartcoex_policy_create(cy_smartcoex_policy_t **policy, cy_smartcoex_ctx_t *ctx,
+                                     cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                     const cy_smartcoex_policy_config_t *config)
+{
+    cy_smartcoex_policy_t *new_policy;
+    cy_rslt_t result;
+
+    if(policy == NULL || wifi_config == NULL || bt_config == NULL || config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(ctx == NULL)
+    {
+        ctx = smartcoex_default_ctx();
+        if(ctx == NULL)
+        {
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+
+    if(!policy_config_valid(ctx, wifi_config, bt_config, config))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    new_policy = (cy_smartcoex_policy_t *)calloc(1, sizeof(cy_smartcoex_policy_t));
+    if(new_policy == NULL)
+    {
+        return CY_RSLT_MW_NOMEM;
+    }
+    new_policy->ctx         = ctx;
+    new_policy->config      = *config;
+    new_policy->wifi_config = *wifi_config;
+    new_policy->bt_config   = *bt_config;
+    new_policy->bt_config.scan_priority = config->default_priority;
+    new_policy->active_rule = -1;
+    new_policy->backoff_ms  = CY_SMARTCOEX_POLICY_BUSY_BACKOFF_MIN_MS;
+
+    result = cy_rtos_init_mutex(&new_policy->mutex);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(new_policy);
+        return result;
+    }
+
+    result = cy_rtos_init_semaphore(&new_policy->wakeup, 1, 0);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&new_policy->mutex);
+        free(new_policy);
+        return result;
+    }
+
+    result = cy_rtos_create_thread(&new_policy->thread, policy_worker, "smartcoex_policy", NULL,
+                                   CY_SMARTCOEX_POLICY_THREAD_STACK_SIZE, CY_SMARTCOEX_POLICY_THREAD_PRIORITY, new_policy);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to create Smart Coex policy thread:[0x%X]\n", (unsigned int)result);
+        cy_rtos_deinit_semaphore(&new_policy->wakeup);
+        cy_rtos_deinit_mutex(&new_policy->mutex);
+        free(new_policy);
+        return result;
+    }
+
+    if(config->wifi_events)
+    {
+        result = register_wifi_events(policy_wifi_event, new_policy);
+        if(result != CY_RSLT_SUCCESS)
+        {
+            new_policy->config.wifi_events = false;
+            cy_smartcoex_policy_destroy(new_policy);
+            return result;
+        }
+    }
+
+    *policy = new_policy;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_policy_destroy(cy_smartcoex_policy_t *policy)
+{
+    if(policy == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(policy->config.wifi_events)
+    {
+        deregister_wifi_events(policy_wifi_event, policy);
+    }
+
+    policy->exit = true;
+    cy_rtos_set_semaphore(&policy->wakeup, false);
+    cy_rtos_join_thread(&policy->thread);
+
+    cy_rtos_deinit_semaphore(&policy->wakeup);
+    cy_rtos_deinit_mutex(&policy->mutex);
+    free(policy);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_policy_post_event(cy_smartcoex_policy_t *policy, cy_smartcoex_event_t event)
+{
+    uint32_t cond;
+    cy_time_t now = 0;
+
+    if(policy == NULL || event >= CY_SMARTCOEX_EVENT_MAX)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    /* Events come in set/clear pairs, one pair per condition bit */
+    cond = 1UL << (event / 2);
+
+    (void)cy_rtos_get_time(&now);
+
+    cy_rtos_get_mutex(&policy->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if((event % 2) == 0)
+    {
+        if((policy->conditions & cond) == 0)
+        {
+            policy->cond_since[event / 2] = now;
+            policy->conditions |= cond;
+        }
+    }
+    else
+    {
+        policy->conditions &= ~cond;
+    }
+    policy->dirty        = true;
+    policy->last_event   = now;
+    policy->failed_valid = false;
+    cy_rtos_set_mutex(&policy->mutex);
+
+    cy_rtos_set_semaphore(&policy->wakeup, false);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_policy_ble_scan(cy_smartcoex_policy_t *policy, bool scanning, uint16_t scan_int, uint16_t scan_win)
+{
+    cy_smartcoex_bt_config_t bt_config;
+
+    if(policy == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(scanning)
+    {
+        cy_rtos_get_mutex(&policy->mutex, CY_RTOS_NEVER_TIMEOUT);
+
+        bt_config          = policy->bt_config;
+        bt_config.scan_int = scan_int;
+        bt_config.scan_win = scan_win;
+        if(!smartcoex_validate(policy->ctx, &policy->wifi_config, &bt_config))
+        {
+            cy_rtos_set_mutex(&policy->mutex);
+            return CY_RSLT_MW_BADARG;
+        }
+
+        if(scan_int != policy->bt_config.scan_int || scan_win != policy->bt_config.scan_win)
+        {
+            policy->bt_config           = bt_config;
+            policy->scan_params_changed = true;
+        }
+
+        cy_rtos_set_mutex(&policy->mutex);
+    }
+
+    return cy_smartcoex_policy_post_event(policy, scanning ? CY_SMARTCOEX_EVENT_BLE_SCAN_START : CY_SMARTCOEX_EVENT_BLE_SCAN_STOP);
+}
+
+cy_rslt_t cy_smartcoex_policy_get_state(cy_smartcoex_policy_t *policy, cy_smartcoex_policy_state_t *state)
+{
+    if(policy == NULL || state == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&policy->mutex, CY_RTOS_NEVER_TIMEOUT);
+    state->conditions    = policy->conditions;
+    state->active_rule   = policy->active_rule;
+    state->scan_priority = policy->applied_priority;
+    state->commits       = policy->commits;
+    state->failures      = policy->failures;
+    cy_rtos_set_mutex(&policy->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
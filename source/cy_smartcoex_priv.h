@@ -39,12 +39,408 @@ extern "C" {
 #endif
 
 #include "cy_smartcoex.h"
+#include "cy_smartcoex_trace.h"
 #include "whd_types.h"
+#include "cyabs_rtos.h"
 
 #define BTHCI_CMD_VS_OCF_BTCX_LESCAN	0x01B1
 
+/* Number of Wi-Fi interface types, and the bit of an interface in an interface mask */
+#define SMARTCOEX_WIFI_INTERFACE_COUNT      (CY_SMARTCOEX_INTERFACE_TYPE_AP + 1)
+#define SMARTCOEX_WIFI_MASK(interface)      (1UL << (uint32_t)(interface))
+
+/**
+ * Scan parameters to be passed to BT stack for Coex
+ */
+typedef struct
+{
+    /*
+     * Allowed maximum scan window size, above which host specified scanInterval
+     * and scanWindow are re-adjusted.
+     *
+     * Units: slots (1 slot = 0.625 ms)
+     * Range: 4-16384
+     */
+    uint16_t maxScanWindow;
+
+    /**
+     * The upper bound of of the percentage of the scan time that is given high priority.
+     *
+     * Units: percentage
+     * Range: 0 - 100
+     */
+    uint8_t  scanDutyCycle;
+
+    /**
+     * When host specified scan interval is smaller than maxScanWindow,
+     * every <smallIntervalGrant>'th scan window is given high priority.
+     * For e.g., if smallIntervalGrant is 4, every 4th window is given high priority.
+     *
+     * Units: none
+     * Range: 1 - 255
+     */
+    uint8_t  smallIntervalGrant;
+} le_scan_param;
+
+/**
+ * Coex arbitration of one kind of LE link event, as sent to the BT controller
+ */
+typedef struct
+{
+    uint8_t priority;       /* cy_smartcoex_lescan_priority_t */
+    uint8_t grant;          /* Every <grant>'th event is given high priority; 0 for the controller's default */
+    uint8_t maxMissed;      /* Events that may lose arbitration in a row; 0 for no limit */
+} le_event_param;
+
+/**
+ * Payload of the LE link coex VSC
+ */
+typedef struct
+{
+    le_event_param conn[CY_SMARTCOEX_LE_ROLE_MAX];
+    le_event_param adv;
+} le_link_param;
+
+/**
+ * Last configuration committed to each radio. A side is only sent again when
+ * its payload differs from the shadow or the shadow has been invalidated.
+ */
+typedef struct
+{
+    bool                          bt_valid;
+    le_scan_param                 bt_param;
+    bool                          wifi_valid;
+    uint32_t                      wifi_interfaces; /* Mask of the interfaces wifi_config was applied to */
+    whd_coex_config_t             wifi_config;
+    bool                          link_valid;
+    le_link_param                 link_param;
+} smartcoex_shadow_t;
+
+/**
+ * Wi-Fi side of the shadow as it stood before a commit, restored if the BT side
+ * of the commit fails.
+ */
+typedef struct
+{
+    bool                          valid;
+    uint32_t                      interfaces;
+    whd_coex_config_t             config;
+    uint32_t                      gen;      /* Generation live on Wi-Fi before the commit */
+} smartcoex_wifi_state_t;
+
+/**
+ * Coex profile with its payloads prebuilt at registration.
+ */
+typedef struct
+{
+    le_scan_param           vsc_param;   /* VSC payload */
+    whd_btc_lescan_params_t wifi_params; /* WHD LE scan params; scan_int and scan_win are filled per commit */
+} smartcoex_profile_entry_t;
+
+/**
+ * What a commit sent to each radio and what each send returned, see cy_smartcoex_trace.c
+ */
+typedef struct
+{
+    uint32_t       start;       /* Timestamp of the start of the commit */
+    uint8_t        flags;       /* CY_SMARTCOEX_TRACE_FLAG_*_SENT bits of the sends attempted */
+    cy_rslt_t      wifi_result;
+    wiced_result_t vsc_result;
+    wiced_result_t link_result;
+    uint32_t       vsc_gen;
+    uint32_t       link_gen;
+} smartcoex_commit_outcome_t;
+
+#ifdef ENABLE_SMARTCOEX_STATS
+#include "cy_smartcoex_stats.h"
+
+/**
+ * Statistics of a context, see cy_smartcoex_stats.c. The mutex only guards data,
+ * so recording never waits for a commit in progress.
+ */
+typedef struct
+{
+    cy_mutex_t           mutex;
+    cy_smartcoex_stats_t data;
+} smartcoex_stats_t;
+
+#define SMARTCOEX_STATS_TIMESTAMP(t)              uint32_t t = get_timestamp()
+#define SMARTCOEX_STATS_RECORD(ctx, stage, t)     smartcoex_stats_record((ctx), CY_SMARTCOEX_STATS_STAGE_##stage, (t))
+#define SMARTCOEX_STATS_RECORD_US(ctx, stage, us) smartcoex_stats_record_us((ctx), CY_SMARTCOEX_STATS_STAGE_##stage, (us))
+#define SMARTCOEX_STATS_COUNT(ctx, result)        smartcoex_stats_count((ctx), CY_SMARTCOEX_STATS_RESULT_##result)
+#else
+#define SMARTCOEX_STATS_TIMESTAMP(t)
+#define SMARTCOEX_STATS_RECORD(ctx, stage, t)
+#define SMARTCOEX_STATS_RECORD_US(ctx, stage, us)
+#define SMARTCOEX_STATS_COUNT(ctx, result)
+#endif
+
+/* Distinct BT controllers the library tells apart, each with its own completion order */
+#define SMARTCOEX_VSC_QUEUE_MAX             (4)
+
+/**
+ * VSC completion tracking of a context, see cy_smartcoex_vsc.c. Guarded by the
+ * tracker's mutex, not the context mutex, so completions never wait for a commit.
+ */
+typedef struct
+{
+    uint8_t  inflight;
+    uint8_t  in_callback;       /* Completions matched to this context and still running */
+    uint32_t gen;               /* Generation of the most recent VSC sent */
+    uint32_t failed_gen;        /* Generation of the most recent completion with a failed HCI status */
+    uint32_t sent;
+    uint32_t completed;
+    uint32_t failed;
+    uint8_t  last_hci_status;
+    uint32_t last_rtt_us;
+    uint32_t last_applied_us;
+    uint32_t requested;         /* Commit generations, see cy_smartcoex_generation_t */
+    uint32_t bt_live;
+    uint32_t bt_pending;        /* Commit relying on the most recent VSC, live once it completes */
+    uint32_t wifi_live;
+    uint32_t link_gen;          /* Sequence number of the most recent LE link VSC sent */
+    uint8_t  queue;             /* Completion queue of the BT controller of the context */
+    uint32_t stale_gen;         /* Failed LE scan VSC not yet settled, or 0 */
+    uint32_t link_stale_gen;    /* Failed LE link VSC not yet settled, or 0 */
+    bool     rollback_valid;    /* The commit of stale_gen changed Wi-Fi; rollback restores it */
+    smartcoex_wifi_state_t rollback;
+    cy_semaphore_t *notify;     /* Given when a rollback is due, e.g. to wake the async worker; may be NULL */
+} smartcoex_vsc_state_t;
+
+/* Cumulative counters as last read from each radio, with the time of the read in ms */
+typedef struct
+{
+    bool     valid;
+    uint32_t time_ms;
+    uint32_t bytes;
+    uint32_t frames;
+    uint32_t retries;
+} smartcoex_wifi_counters_t;
+
+typedef struct
+{
+    bool     valid;
+    uint32_t time_ms;
+    uint32_t reads;     /* Completions counted so far, to tell a new read from the previous one */
+    uint32_t grants;
+    uint32_t denials;
+} smartcoex_bt_counters_t;
+
+/**
+ * Readback cache of a context, see cy_smartcoex_readback.c. Guarded by the
+ * context mutex, except bt_gen and bt_sample, which the BT counter read and
+ * its completion use under the readback mutex.
+ */
+typedef struct
+{
+    bool                    cached;
+    uint32_t                time_ms;    /* Time of the cached read */
+    cy_smartcoex_wifi_interface_t interface;
+    cy_smartcoex_readback_t data;
+    smartcoex_wifi_counters_t wifi_base[SMARTCOEX_WIFI_INTERFACE_COUNT]; /* Counters of the previous read of each interface */
+    smartcoex_bt_counters_t bt_base;    /* BT counters the last BT deltas ended at */
+    smartcoex_bt_counters_t bt_sample;  /* BT counters of the most recent completion */
+    uint32_t                bt_gen;     /* Generation of the most recent BT counter read sent */
+} smartcoex_readback_t;
+
+/* Async update state of a context, see cy_smartcoex_async.c */
+typedef struct smartcoex_async smartcoex_async_t;
+
+/* Link-up restore worker of a context, see cy_smartcoex_snapshot.c */
+typedef struct smartcoex_restore smartcoex_restore_t;
+
+/**
+ * Smart Coex context. All mutable library state lives here.
+ *
+ * The mutex serializes commits on this context, and is held across the radio
+ * I/O so that the radios see commits in the order recorded in the shadow.
+ */
+struct cy_smartcoex_ctx
+{
+    cy_mutex_t               mutex;
+    cy_smartcoex_radio_ops_t radio_ops;
+    bool                     port_ops;  /* radio_ops are the port's; interface-to-driver mapping is known */
+    smartcoex_shadow_t       shadow;
+    smartcoex_profile_entry_t profiles[CY_SMARTCOEX_MAX_PROFILES];
+    volatile uint8_t         profile_count;
+    smartcoex_async_t        *async;
+    smartcoex_vsc_state_t    vsc;
+    cy_smartcoex_snapshot_t  snapshot;  /* Last committed config; magic is zero until the first commit */
+    cy_smartcoex_snapshot_t  *snapshot_storage;
+    btcoex_cb_t              btcoex_cb; /* Status callback of the last commit, reused by restore */
+    cy_smartcoex_lescan_priority_t scan_priority; /* Scan priority or profile ID of the last commit, kept in the snapshot */
+    smartcoex_restore_t      *restore;  /* Non-NULL while auto-restore is enabled; guarded by the mutex */
+    smartcoex_readback_t     readback;
+#ifdef ENABLE_SMARTCOEX_STATS
+    smartcoex_stats_t        stats;
+#endif
+#ifdef ENABLE_SMARTCOEX_TRACE
+    uint8_t                  trace_id;  /* Context number in trace records */
+#endif
+};
+
 cy_rslt_t set_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config);
 
+/* Validates the Wi-Fi and BT config, including the scan priority against the context's profile table */
+bool smartcoex_validate(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config);
+
+/* Commits a validated config to both radios of the context. bt_busy is set when the BT stack rejected the VSC as busy */
+cy_rslt_t smartcoex_commit(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config, bool *bt_busy);
+
+/*
+ * Commits using an explicit prebuilt profile entry instead of bt_config->scan_priority,
+ * applying the Wi-Fi side to every interface in the wifi_interfaces mask
+ */
+cy_rslt_t smartcoex_commit_entry(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, cy_smartcoex_bt_config_t *bt_config,
+                                 const smartcoex_profile_entry_t *entry, bool *bt_busy);
+
+/* As smartcoex_commit_entry, but fails as busy instead of waiting for a commit in progress */
+cy_rslt_t smartcoex_commit_entry_nowait(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, cy_smartcoex_bt_config_t *bt_config,
+                                        const smartcoex_profile_entry_t *entry, bool *bt_busy);
+
+/* Validates a profile and prebuilds its VSC payload and WHD LE scan parameters */
+bool smartcoex_build_profile(const cy_smartcoex_profile_t *profile, smartcoex_profile_entry_t *entry);
+
+/* Reads the cumulative Wi-Fi counters of the interface from the port */
+cy_rslt_t get_wifi_counters(cy_smartcoex_wifi_config_t *wifi_config, uint32_t *bytes, uint32_t *frames, uint32_t *retries);
+
+/* Reads the coex config live in the WLAN firmware of the interface from the port */
+cy_rslt_t get_wifi_coex_config(cy_smartcoex_wifi_config_t *wifi_config, whd_coex_config_t *coex_config);
+
+/* Whether two interfaces are served by one WHD driver instance, and so share its coex config */
+bool wifi_interfaces_share_driver(cy_smartcoex_wifi_interface_t a, cy_smartcoex_wifi_interface_t b);
+
+/* Drops the WHD interface handles the port has cached, e.g. after a Wi-Fi driver restart */
+void reset_wifi_interfaces(void);
+
+/* Resolves and caches the WHD interface handle of the interface ahead of its first commit */
+cy_rslt_t prepare_wifi_interface(cy_smartcoex_wifi_interface_t interface);
+
+/* Wi-Fi connection state change handler; see register_wifi_events */
+typedef void (*smartcoex_wifi_event_handler_t)(bool connected, void *arg);
+
+/* Number of Wi-Fi connection event subscribers the port accepts */
+#define SMARTCOEX_WIFI_EVENT_HANDLERS       (4)
+
+/*
+ * Subscribes to Wi-Fi connection events from the port. The handler is invoked
+ * once at registration if already connected. Once deregistration returns, the
+ * handler is not running and is never invoked again with that arg. A handler
+ * must not register or deregister.
+ */
+cy_rslt_t register_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg);
+void deregister_wifi_events(smartcoex_wifi_event_handler_t handler, void *arg);
+
+/* Free-running timestamp from the port, and conversion of a timestamp difference to microseconds */
+uint32_t get_timestamp(void);
+uint32_t timestamp_to_us(uint32_t ticks);
+
+/*
+ * Short critical section of the port, usable before any RTOS object exists.
+ * Nothing may block or call into the library while it is held.
+ */
+uint32_t enter_critical_section(void);
+void exit_critical_section(uint32_t state);
+
+/* One-time initialization state; zero-initialize, see smartcoex_once */
+typedef struct
+{
+    volatile uint8_t state;
+} smartcoex_once_t;
+
+/*
+ * Runs init exactly once. Callers racing the first caller wait for it to finish
+ * and share its result; a failed init is retried by the next caller.
+ */
+cy_rslt_t smartcoex_once(smartcoex_once_t *once, cy_rslt_t (*init)(void *arg), void *arg);
+
+/*
+ * Wi-Fi connection event subscribers, shared by the ports' register_wifi_events
+ * and deregister_wifi_events; see cy_smartcoex_wifi_events.c. first runs before
+ * the first subscriber is added and last after the last one is removed; either
+ * may be NULL. The new subscriber gets a connect event right away if connected.
+ */
+cy_rslt_t smartcoex_wifi_events_add(smartcoex_wifi_event_handler_t handler, void *arg, bool connected, cy_rslt_t (*first)(void));
+void smartcoex_wifi_events_remove(smartcoex_wifi_event_handler_t handler, void *arg, void (*last)(void));
+
+/* Delivers a connection state change to every subscriber */
+void smartcoex_wifi_events_dispatch(bool connected);
+
+#ifdef ENABLE_SMARTCOEX_STATS
+cy_rslt_t smartcoex_stats_init(cy_smartcoex_ctx_t *ctx);
+void smartcoex_stats_deinit(cy_smartcoex_ctx_t *ctx);
+void smartcoex_stats_record(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_stage_t stage, uint32_t start);
+void smartcoex_stats_record_us(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_stage_t stage, uint32_t us);
+void smartcoex_stats_count(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_result_t result);
+#endif
+
+#ifdef ENABLE_SMARTCOEX_TRACE
+void smartcoex_trace_init(cy_smartcoex_ctx_t *ctx);
+
+/* Records the REQUEST and OUTCOME of a commit. Called after the commit has released the context mutex */
+void smartcoex_trace_commit(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, const cy_smartcoex_bt_config_t *bt_config,
+                            const smartcoex_profile_entry_t *entry, const smartcoex_commit_outcome_t *outcome,
+                            cy_rslt_t result, bool bt_busy);
+
+/* Records the COMPLETION of a coex VSC */
+void smartcoex_trace_completion(cy_smartcoex_ctx_t *ctx, bool link, uint32_t gen, uint8_t hci_status, uint32_t rtt_us);
+#endif
+
+cy_rslt_t smartcoex_vsc_init(cy_smartcoex_ctx_t *ctx);
+void smartcoex_vsc_deinit(cy_smartcoex_ctx_t *ctx);
+
+/*
+ * Reserves an in-flight slot and returns the callback to hand to the BT stack; NULL if the window is full.
+ * link selects the LE link VSC, which is sequenced apart from the LE scan VSC and takes no part in commit generations.
+ */
+btcoex_cb_t smartcoex_vsc_begin(cy_smartcoex_ctx_t *ctx, btcoex_cb_t cb, bool link, uint8_t *slot, uint32_t *gen);
+
+/* Releases the slot of a VSC the BT stack did not accept */
+void smartcoex_vsc_cancel(cy_smartcoex_ctx_t *ctx, uint8_t slot);
+
+/* Sets the semaphore given when a failed VSC leaves a Wi-Fi rollback due; NULL stops it */
+void smartcoex_vsc_set_notify(cy_smartcoex_ctx_t *ctx, cy_semaphore_t *notify);
+
+/*
+ * Applies the VSC failures recorded by the completion callback: invalidates the
+ * shadow so the next commit resends, and rolls back the Wi-Fi side of the failed
+ * commit. Called with the context mutex held, never on the BT stack's thread.
+ */
+void smartcoex_vsc_settle(cy_smartcoex_ctx_t *ctx);
+
+/* Assigns the next commit generation. Called with the context mutex held */
+uint32_t smartcoex_vsc_next_gen(cy_smartcoex_ctx_t *ctx);
+
+/* Attaches the commit generation and the Wi-Fi state to restore if the VSC fails; wifi_prev is NULL if the commit left Wi-Fi unchanged */
+void smartcoex_vsc_arm(cy_smartcoex_ctx_t *ctx, uint8_t slot, uint32_t gen, const smartcoex_wifi_state_t *wifi_prev);
+
+/*
+ * Records that commit gen, started at start, is applied on Wi-Fi and accepted on BT.
+ * vsc_gen is the VSC it sent, or 0. Returns false if that VSC already completed
+ * with a failed HCI status. Called with the context mutex held.
+ */
+bool smartcoex_vsc_committed(cy_smartcoex_ctx_t *ctx, uint32_t gen, uint32_t vsc_gen, uint32_t start);
+
+/* Restores the Wi-Fi side of the shadow and the radio to prev. Called with the context mutex held */
+cy_rslt_t smartcoex_rollback_wifi(cy_smartcoex_ctx_t *ctx, const smartcoex_wifi_state_t *prev);
+
+/* Refreshes the snapshot of the context from its shadow. Called with the context mutex held */
+void smartcoex_snapshot_update(cy_smartcoex_ctx_t *ctx);
+
+/* Stops re-applying the snapshot on link-up, if enabled */
+void smartcoex_snapshot_release(cy_smartcoex_ctx_t *ctx);
+
+cy_rslt_t smartcoex_readback_init(cy_smartcoex_ctx_t *ctx);
+
+/* Detaches the context from an outstanding BT counter read */
+void smartcoex_readback_release(cy_smartcoex_ctx_t *ctx);
+
+/* Returns the context behind the legacy API, initializing it on first use */
+cy_smartcoex_ctx_t *smartcoex_default_ctx(void);
+
+/* Stops the context's async worker, if any */
+void smartcoex_async_release(cy_smartcoex_ctx_t *ctx);
+
 #ifdef __cplusplus
 } /* extern C */
 #endif
@@ -0,0 +1,423 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_readback.c
+* @brief Reads back the live coex config and the coex statistics of both radios.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <string.h>
+
+/* After this long without a completion, a BT counter read is considered lost and may be sent again */
+#ifndef CY_SMARTCOEX_READBACK_BT_TIMEOUT_MS
+#define CY_SMARTCOEX_READBACK_BT_TIMEOUT_MS (1000) // in milliseconds
+#endif
+
+/* Completion of the BT counter read: HCI status, then LE uint32_t grants and denials */
+#define READBACK_BT_RESPONSE_LEN            (9)
+#define READBACK_BT_GRANTS_OFFSET           (1)
+#define READBACK_BT_DENIALS_OFFSET          (5)
+
+#define READBACK_HCI_STATUS_SUCCESS         (0x00)
+
+/* BT counter reads tracked until they complete or are given up as lost */
+#define READBACK_BT_TRACK_MAX               (4)
+
+/**
+ * A BT counter read awaiting completion. The completion callback carries no
+ * user argument, so each BT controller, as told apart by the VSC tracker, gets
+ * its own trampoline and its reads are matched FIFO. A completion is credited
+ * only to the most recent read of its context; one that comes after the
+ * context sent a newer read is dropped. A read outstanding for twice the
+ * timeout is taken as lost, so that it cannot shift the matching for good.
+ */
+typedef struct
+{
+    cy_smartcoex_ctx_t *ctx;        /* NULL once the context is destroyed */
+    uint32_t           gen;
+    uint32_t           sent_ms;
+    uint8_t            queue;
+} smartcoex_readback_read_t;
+
+static cy_mutex_t                readback_mutex;
+static smartcoex_once_t          readback_once;
+static smartcoex_readback_read_t readback_reads[READBACK_BT_TRACK_MAX];
+static uint8_t                   readback_head  = 0;
+static uint8_t                   readback_count = 0;
+
+static uint32_t readback_now_ms(void)
+{
+    cy_time_t now = 0;
+
+    (void)cy_rtos_get_time(&now);
+    return (uint32_t)now;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Removes entry i of the FIFO, keeping the order of the others. Called with readback_mutex held */
+static void readback_remove(uint8_t i)
+{
+    for(; i + 1U < readback_count; i++)
+    {
+        readback_reads[(readback_head + i) % READBACK_BT_TRACK_MAX] = readback_reads[(readback_head + i + 1U) % READBACK_BT_TRACK_MAX];
+    }
+    readback_count--;
+}
+
+/* Gives up on reads outstanding for twice the timeout. Called with readback_mutex held */
+static void readback_expire(uint32_t now)
+{
+    uint8_t i = 0;
+
+    while(i < readback_count)
+    {
+        if((now - readback_reads[(readback_head + i) % READBACK_BT_TRACK_MAX].sent_ms) >= (2U * CY_SMARTCOEX_READBACK_BT_TIMEOUT_MS))
+        {
+            readback_remove(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+/* Completion of the oldest outstanding read sent to controller queue */
+static void readback_bt_complete(uint8_t queue, wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params)
+{
+    cy_smartcoex_ctx_t *ctx = NULL;
+    smartcoex_readback_read_t *read;
+    uint32_t now = readback_now_ms();
+    bool valid;
+    uint8_t i;
+
+    valid = p_command_complete_params != NULL && p_command_complete_params->p_param_buf != NULL &&
+            p_command_complete_params->param_len >= READBACK_BT_RESPONSE_LEN &&
+            p_command_complete_params->p_param_buf[0] == READBACK_HCI_STATUS_SUCCESS;
+
+    cy_rtos_get_mutex(&readback_mutex, CY_RTOS_NEVER_TIMEOUT);
+    readback_expire(now);
+    for(i = 0; i < readback_count; i++)
+    {
+        read = &readback_reads[(readback_head + i) % READBACK_BT_TRACK_MAX];
+        if(read->queue == queue)
+        {
+            if(read->ctx != NULL && read->gen == read->ctx->readback.bt_gen)
+            {
+                ctx = read->ctx;
+            }
+            readback_remove(i);
+            break;
+        }
+    }
+    if(ctx != NULL && valid)
+    {
+        ctx->readback.bt_sample.valid   = true;
+        ctx->readback.bt_sample.time_ms = now;
+        ctx->readback.bt_sample.reads++;
+        ctx->readback.bt_sample.grants  = get_le32(&p_command_complete_params->p_param_buf[READBACK_BT_GRANTS_OFFSET]);
+        ctx->readback.bt_sample.denials = get_le32(&p_command_complete_params->p_param_buf[READBACK_BT_DENIALS_OFFSET]);
+    }
+    cy_rtos_set_mutex(&readback_mutex);
+
+    if(ctx != NULL && !valid)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BT coex counter read failed.\n");
+    }
+}
+
+/* Completion trampolines handed to the BT stack, one per controller */
+static void readback_bt_complete_0(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    readback_bt_complete(0, p);
+}
+
+static void readback_bt_complete_1(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    readback_bt_complete(1, p);
+}
+
+static void readback_bt_complete_2(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    readback_bt_complete(2, p);
+}
+
+static void readback_bt_complete_3(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    readback_bt_complete(3, p);
+}
+
+static const btcoex_cb_t readback_trampoline[SMARTCOEX_VSC_QUEUE_MAX] =
+{
+    readback_bt_complete_0, readback_bt_complete_1, readback_bt_complete_2, readback_bt_complete_3
+};
+
+/* Starts a BT counter read unless one is outstanding on the controller; the result is picked up by a later readback */
+static void readback_bt_request(cy_smartcoex_ctx_t *ctx)
+{
+    smartcoex_readback_read_t *read;
+    wiced_result_t result;
+    uint32_t now = readback_now_ms();
+    uint8_t queue = ctx->vsc.queue;
+    uint8_t none = 0;
+    uint8_t slot;
+    uint8_t i;
+
+    cy_rtos_get_mutex(&readback_mutex, CY_RTOS_NEVER_TIMEOUT);
+    readback_expire(now);
+    for(i = 0; i < readback_count; i++)
+    {
+        read = &readback_reads[(readback_head + i) % READBACK_BT_TRACK_MAX];
+        if(read->queue == queue && (now - read->sent_ms) < CY_SMARTCOEX_READBACK_BT_TIMEOUT_MS)
+        {
+            cy_rtos_set_mutex(&readback_mutex);
+            return;
+        }
+    }
+    if(readback_count == READBACK_BT_TRACK_MAX)
+    {
+        cy_rtos_set_mutex(&readback_mutex);
+        return;
+    }
+    slot = (uint8_t)((readback_head + readback_count) % READBACK_BT_TRACK_MAX);
+    readback_reads[slot].ctx     = ctx;
+    readback_reads[slot].gen     = ++ctx->readback.bt_gen;
+    readback_reads[slot].sent_ms = now;
+    readback_reads[slot].queue   = queue;
+    readback_count++;
+    cy_rtos_set_mutex(&readback_mutex);
+
+    result = ctx->radio_ops.send_vsc(ctx->radio_ops.arg, CY_SMARTCOEX_VSC_OCF_BTCX_STATS, 0, &none, readback_trampoline[queue]);
+    if(result != WICED_BT_PENDING && result != WICED_BT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BT coex counter read not sent:[0x%X]\n", (unsigned int)result);
+
+        /* The newest read of the context on its controller is this one, unless it already completed */
+        cy_rtos_get_mutex(&readback_mutex, CY_RTOS_NEVER_TIMEOUT);
+        for(i = readback_count; i > 0; i--)
+        {
+            read = &readback_reads[(readback_head + i - 1U) % READBACK_BT_TRACK_MAX];
+            if(read->ctx == ctx && read->queue == queue)
+            {
+                if(read->gen == ctx->readback.bt_gen)
+                {
+                    readback_remove((uint8_t)(i - 1U));
+                }
+                break;
+            }
+        }
+        cy_rtos_set_mutex(&readback_mutex);
+    }
+}
+
+/* Reads the live config and counters of the interface. Called with the context mutex held */
+static cy_rslt_t readback_wifi(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, uint32_t now,
+                               cy_smartcoex_readback_t *data)
+{
+    smartcoex_wifi_counters_t *base = &ctx->readback.wifi_base[wifi_config->interface];
+    smartcoex_shadow_t *shadow = &ctx->shadow;
+    uint32_t bytes;
+    uint32_t frames;
+    uint32_t retries;
+    cy_rslt_t result;
+
+    result = get_wifi_coex_config(wifi_config, &data->wifi_config);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+    data->wifi_config_valid = true;
+    data->wifi_config_match = shadow->wifi_valid &&
+                              (shadow->wifi_interfaces & SMARTCOEX_WIFI_MASK(wifi_config->interface)) != 0 &&
+                              memcmp(&shadow->wifi_config, &data->wifi_config, sizeof(data->wifi_config)) == 0;
+
+    result = get_wifi_counters(wifi_config, &bytes, &frames, &retries);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    /* Counters wrap; unsigned differences stay exact across one wrap */
+    if(base->valid)
+    {
+        data->wifi_stats_valid = true;
+        data->wifi_interval_ms = now - base->time_ms;
+        data->wifi_bytes       = bytes - base->bytes;
+        data->wifi_frames      = frames - base->frames;
+        data->wifi_retries     = retries - base->retries;
+    }
+    base->valid   = true;
+    base->time_ms = now;
+    base->bytes   = bytes;
+    base->frames  = frames;
+    base->retries = retries;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* Takes the deltas since the last BT deltas reported, if a read has completed since. Called with the context mutex held */
+static void readback_bt(cy_smartcoex_ctx_t *ctx, cy_smartcoex_readback_t *data)
+{
+    smartcoex_bt_counters_t *base = &ctx->readback.bt_base;
+    smartcoex_bt_counters_t sample;
+
+    cy_rtos_get_mutex(&readback_mutex, CY_RTOS_NEVER_TIMEOUT);
+    sample = ctx->readback.bt_sample;
+    cy_rtos_set_mutex(&readback_mutex);
+
+    if(!sample.valid || (base->valid && sample.reads == base->reads))
+    {
+        return;
+    }
+
+    if(base->valid)
+    {
+        data->bt_stats_valid = true;
+        data->bt_interval_ms = sample.time_ms - base->time_ms;
+        data->bt_grants      = sample.grants - base->grants;
+        data->bt_denials     = sample.denials - base->denials;
+    }
+    *base = sample;
+}
+
+static cy_rslt_t readback_mutex_init(void *arg)
+{
+    (void)arg;
+    return cy_rtos_init_mutex(&readback_mutex);
+}
+
+cy_rslt_t smartcoex_readback_init(cy_smartcoex_ctx_t *ctx)
+{
+    cy_rslt_t result;
+
+    /* Contexts may be created concurrently; the shared readback mutex is created once */
+    result = smartcoex_once(&readback_once, readback_mutex_init, NULL);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    memset(&ctx->readback, 0, sizeof(ctx->readback));
+
+    return CY_RSLT_SUCCESS;
+}
+
+void smartcoex_readback_release(cy_smartcoex_ctx_t *ctx)
+{
+    uint8_t i;
+
+    /* Reads still due keep their place in the order, but credit nobody */
+    cy_rtos_get_mutex(&readback_mutex, CY_RTOS_NEVER_TIMEOUT);
+    for(i = 0; i < readback_count; i++)
+    {
+        if(readback_reads[(readback_head + i) % READBACK_BT_TRACK_MAX].ctx == ctx)
+        {
+            readback_reads[(readback_head + i) % READBACK_BT_TRACK_MAX].ctx = NULL;
+        }
+    }
+    cy_rtos_set_mutex(&readback_mutex);
+}
+
+cy_rslt_t cy_smartcoex_ctx_readback(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config, uint32_t max_age_ms,
+                                    cy_smartcoex_readback_t *readback)
+{
+    smartcoex_readback_t *cache;
+    cy_smartcoex_readback_t data;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t now;
+
+    if(ctx == NULL || wifi_config == NULL || readback == NULL ||
+       (uint32_t)wifi_config->interface >= SMARTCOEX_WIFI_INTERFACE_COUNT)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!ctx->port_ops && CY_SMARTCOEX_VSC_OCF_BTCX_STATS == 0)
+    {
+        return CY_RSLT_MW_UNSUPPORTED;
+    }
+
+    cache = &ctx->readback;
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    now = readback_now_ms();
+    if(cache->cached && cache->interface == wifi_config->interface && (now - cache->time_ms) < max_age_ms)
+    {
+        *readback = cache->data;
+        readback->age_ms = now - cache->time_ms;
+        cy_rtos_set_mutex(&ctx->mutex);
+        return CY_RSLT_SUCCESS;
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.seq = cache->data.seq + 1;
+
+    if(ctx->port_ops)
+    {
+        result = readback_wifi(ctx, wifi_config, now, &data);
+    }
+
+    /* With a synchronous completion the sample below is this read's; otherwise the previous one's */
+    if(CY_SMARTCOEX_VSC_OCF_BTCX_STATS != 0)
+    {
+        readback_bt_request(ctx);
+        readback_bt(ctx, &data);
+    }
+
+    cache->cached    = (result == CY_RSLT_SUCCESS);
+    cache->time_ms   = now;
+    cache->interface = wifi_config->interface;
+    cache->data      = data;
+    *readback        = data;
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_readback(cy_smartcoex_wifi_config_t *wifi_config, uint32_t max_age_ms, cy_smartcoex_readback_t *readback)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_readback(ctx, wifi_config, max_age_ms, readback) : CY_RSLT_MW_ERROR;
+}
@@ -0,0 +1,474 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_snapshot.c
+* @brief Keeps a compact snapshot of the last committed coex config and re-applies it.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Link-up restore thread parameters */
+#ifndef CY_SMARTCOEX_RESTORE_THREAD_STACK_SIZE
+#define CY_SMARTCOEX_RESTORE_THREAD_STACK_SIZE  (2048)
+#endif
+
+#ifndef CY_SMARTCOEX_RESTORE_THREAD_PRIORITY
+#define CY_SMARTCOEX_RESTORE_THREAD_PRIORITY    (CY_RTOS_PRIORITY_NORMAL)
+#endif
+
+/* "SCX" and the layout version */
+#define SMARTCOEX_SNAPSHOT_MAGIC            (0x53435803UL)
+
+/* FNV-1a parameters of the snapshot check value */
+#define SMARTCOEX_SNAPSHOT_FNV_OFFSET       (2166136261UL)
+#define SMARTCOEX_SNAPSHOT_FNV_PRIME        (16777619UL)
+
+/* The VSC payload must fit the snapshot, which is part of the public API */
+typedef char smartcoex_snapshot_vsc_size_check[(sizeof(le_scan_param) == CY_SMARTCOEX_SNAPSHOT_VSC_SIZE) ? 1 : -1];
+typedef char smartcoex_snapshot_link_size_check[(sizeof(le_link_param) == CY_SMARTCOEX_SNAPSHOT_LINK_SIZE) ? 1 : -1];
+
+static uint32_t snapshot_check(const cy_smartcoex_snapshot_t *snapshot)
+{
+    const uint8_t *p   = (const uint8_t *)snapshot + offsetof(cy_smartcoex_snapshot_t, wifi_config);
+    const uint8_t *end = (const uint8_t *)snapshot + sizeof(*snapshot);
+    uint32_t hash = SMARTCOEX_SNAPSHOT_FNV_OFFSET;
+
+    while(p < end)
+    {
+        hash = (hash ^ *p++) * SMARTCOEX_SNAPSHOT_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static bool snapshot_is_valid(const cy_smartcoex_snapshot_t *snapshot)
+{
+    return snapshot->magic == SMARTCOEX_SNAPSHOT_MAGIC &&
+           snapshot->check == snapshot_check(snapshot) &&
+           snapshot->wifi_interfaces != 0 &&
+           (snapshot->wifi_interfaces >> SMARTCOEX_WIFI_INTERFACE_COUNT) == 0;
+}
+
+void smartcoex_snapshot_update(cy_smartcoex_ctx_t *ctx)
+{
+    const smartcoex_shadow_t *shadow = &ctx->shadow;
+    cy_smartcoex_snapshot_t *snapshot = &ctx->snapshot;
+
+    if(!shadow->bt_valid || !shadow->wifi_valid)
+    {
+        return;
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->wifi_config     = shadow->wifi_config;
+    memcpy(snapshot->vsc_param, &shadow->bt_param, sizeof(snapshot->vsc_param));
+    if(shadow->link_valid)
+    {
+        memcpy(snapshot->link_param, &shadow->link_param, sizeof(snapshot->link_param));
+    }
+    snapshot->wifi_interfaces = (uint8_t)shadow->wifi_interfaces;
+    snapshot->scan_priority   = (uint8_t)ctx->scan_priority;
+    snapshot->check           = snapshot_check(snapshot);
+    snapshot->magic           = SMARTCOEX_SNAPSHOT_MAGIC;
+
+    if(ctx->snapshot_storage != NULL)
+    {
+        *ctx->snapshot_storage = *snapshot;
+    }
+}
+
+/* Picks the context's own snapshot, or else the one in its storage, and the callback of the last commit */
+static bool snapshot_select(cy_smartcoex_ctx_t *ctx, cy_smartcoex_snapshot_t *snapshot, btcoex_cb_t *btcoex_cb)
+{
+    bool found = true;
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(ctx->snapshot.magic == SMARTCOEX_SNAPSHOT_MAGIC)
+    {
+        *snapshot = ctx->snapshot;
+    }
+    else if(ctx->snapshot_storage != NULL && snapshot_is_valid(ctx->snapshot_storage))
+    {
+        *snapshot = *ctx->snapshot_storage;
+    }
+    else
+    {
+        found = false;
+    }
+    if(*btcoex_cb == NULL)
+    {
+        *btcoex_cb = ctx->btcoex_cb;
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return found;
+}
+
+/* Commits a valid snapshot after invalidating the Wi-Fi shadow, and the BT shadow if resync_bt */
+static cy_rslt_t snapshot_apply(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_snapshot_t *snapshot, btcoex_cb_t btcoex_cb,
+                                bool resync_bt)
+{
+    smartcoex_profile_entry_t entry;
+    cy_smartcoex_bt_config_t bt_config;
+    le_link_param link_param;
+    uint32_t i;
+    bool bt_busy;
+
+    memcpy(&entry.vsc_param, snapshot->vsc_param, sizeof(entry.vsc_param));
+    entry.wifi_params = snapshot->wifi_config.le_scan_params;
+
+    bt_config.scan_priority = (cy_smartcoex_lescan_priority_t)snapshot->scan_priority;
+    bt_config.scan_int      = entry.wifi_params.scan_int;
+    bt_config.scan_win      = entry.wifi_params.scan_win;
+    bt_config.btcoex_cb     = btcoex_cb;
+
+    memcpy(&link_param, snapshot->link_param, sizeof(link_param));
+    for(i = 0; i < CY_SMARTCOEX_LE_ROLE_MAX; i++)
+    {
+        bt_config.conn[i].priority   = (cy_smartcoex_lescan_priority_t)link_param.conn[i].priority;
+        bt_config.conn[i].grant      = link_param.conn[i].grant;
+        bt_config.conn[i].max_missed = link_param.conn[i].maxMissed;
+    }
+    bt_config.adv.priority   = (cy_smartcoex_lescan_priority_t)link_param.adv.priority;
+    bt_config.adv.grant      = link_param.adv.grant;
+    bt_config.adv.max_missed = link_param.adv.maxMissed;
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(resync_bt)
+    {
+        ctx->shadow.bt_valid   = false;
+        ctx->shadow.link_valid = false;
+    }
+    ctx->shadow.wifi_valid = false;
+    if(ctx->port_ops)
+    {
+        reset_wifi_interfaces();
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return smartcoex_commit_entry(ctx, snapshot->wifi_interfaces, &bt_config, &entry, &bt_busy);
+}
+
+/**
+ * Link-up restore worker. The port delivers link events on the Wi-Fi
+ * middleware's thread, which must not block behind a commit, so the event
+ * only wakes the worker and the restore runs here.
+ */
+struct smartcoex_restore
+{
+    cy_smartcoex_ctx_t *ctx;
+    volatile bool      exit;
+    cy_thread_t        thread;
+    cy_semaphore_t     wakeup;
+};
+
+static void snapshot_wifi_event(bool connected, void *arg)
+{
+    smartcoex_restore_t *restore = (smartcoex_restore_t *)arg;
+
+    if(connected && restore != NULL)
+    {
+        cy_rtos_set_semaphore(&restore->wakeup, false);
+    }
+}
+
+static void restore_worker(cy_thread_arg_t arg)
+{
+    smartcoex_restore_t *restore = (smartcoex_restore_t *)arg;
+    cy_smartcoex_snapshot_t snapshot;
+    btcoex_cb_t btcoex_cb;
+    cy_rslt_t result;
+
+    while(true)
+    {
+        cy_rtos_get_semaphore(&restore->wakeup, CY_RTOS_NEVER_TIMEOUT, false);
+        if(restore->exit)
+        {
+            break;
+        }
+
+        btcoex_cb = NULL;
+        if(!snapshot_select(restore->ctx, &snapshot, &btcoex_cb))
+        {
+            continue;
+        }
+
+        result = snapshot_apply(restore->ctx, &snapshot, btcoex_cb, false);
+        if(result != CY_RSLT_SUCCESS)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Coex restore on link-up failed with error:[0x%X]\n", (unsigned int)result);
+        }
+    }
+
+    cy_rtos_exit_thread();
+}
+
+static cy_rslt_t restore_create(cy_smartcoex_ctx_t *ctx, smartcoex_restore_t **restore)
+{
+    smartcoex_restore_t *new_restore;
+    cy_rslt_t result;
+
+    new_restore = (smartcoex_restore_t *)calloc(1, sizeof(smartcoex_restore_t));
+    if(new_restore == NULL)
+    {
+        return CY_RSLT_MW_NOMEM;
+    }
+    new_restore->ctx = ctx;
+
+    result = cy_rtos_init_semaphore(&new_restore->wakeup, 1, 0);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(new_restore);
+        return result;
+    }
+
+    result = cy_rtos_create_thread(&new_restore->thread, restore_worker, "smartcoex_restore", NULL,
+                                   CY_SMARTCOEX_RESTORE_THREAD_STACK_SIZE, CY_SMARTCOEX_RESTORE_THREAD_PRIORITY, new_restore);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to create Smart Coex restore thread:[0x%X]\n", (unsigned int)result);
+        cy_rtos_deinit_semaphore(&new_restore->wakeup);
+        free(new_restore);
+        return result;
+    }
+
+    *restore = new_restore;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* Stops the worker; the event handler must be deregistered first */
+static void restore_destroy(smartcoex_restore_t *restore)
+{
+    restore->exit = true;
+    cy_rtos_set_semaphore(&restore->wakeup, false);
+    cy_rtos_join_thread(&restore->thread);
+
+    cy_rtos_deinit_semaphore(&restore->wakeup);
+    free(restore);
+}
+
+void smartcoex_snapshot_release(cy_smartcoex_ctx_t *ctx)
+{
+    smartcoex_restore_t *restore;
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    restore = ctx->restore;
+    ctx->restore = NULL;
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    /* Outside the mutex: the worker may be waiting for it in a restore */
+    if(restore != NULL)
+    {
+        deregister_wifi_events(snapshot_wifi_event, restore);
+        restore_destroy(restore);
+    }
+}
+
+cy_rslt_t cy_smartcoex_ctx_set_snapshot_storage(cy_smartcoex_ctx_t *ctx, cy_smartcoex_snapshot_t *storage)
+{
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    ctx->snapshot_storage = storage;
+    if(storage != NULL && ctx->snapshot.magic == SMARTCOEX_SNAPSHOT_MAGIC)
+    {
+        *storage = ctx->snapshot;
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_get_snapshot(cy_smartcoex_ctx_t *ctx, cy_smartcoex_snapshot_t *snapshot)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if(ctx == NULL || snapshot == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(ctx->snapshot.magic == SMARTCOEX_SNAPSHOT_MAGIC)
+    {
+        *snapshot = ctx->snapshot;
+    }
+    else
+    {
+        result = CY_RSLT_MW_ERROR;
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_ctx_restore(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_snapshot_t *snapshot, btcoex_cb_t btcoex_cb)
+{
+    cy_smartcoex_snapshot_t selected;
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!snapshot_select(ctx, &selected, &btcoex_cb) && snapshot == NULL)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "No coex snapshot to restore.\n");
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(snapshot != NULL)
+    {
+        if(!snapshot_is_valid(snapshot))
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid or corrupted coex snapshot.\n");
+            return CY_RSLT_MW_BADARG;
+        }
+        selected = *snapshot;
+    }
+
+    return snapshot_apply(ctx, &selected, btcoex_cb, true);
+}
+
+cy_rslt_t cy_smartcoex_ctx_set_auto_restore(cy_smartcoex_ctx_t *ctx, bool enable)
+{
+    smartcoex_restore_t *restore = NULL;
+    bool installed = false;
+    cy_rslt_t result;
+
+    if(ctx == NULL || !ctx->port_ops)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(!enable)
+    {
+        smartcoex_snapshot_release(ctx);
+        return CY_RSLT_SUCCESS;
+    }
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    installed = (ctx->restore != NULL);
+    cy_rtos_set_mutex(&ctx->mutex);
+    if(installed)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    result = restore_create(ctx, &restore);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(ctx->restore == NULL)
+    {
+        ctx->restore = restore;
+        installed = true;
+    }
+    cy_rtos_set_mutex(&ctx->mutex);
+
+    if(!installed)
+    {
+        /* Already enabled */
+        restore_destroy(restore);
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* Registration delivers the current link state, which wakes the worker */
+    result = register_wifi_events(snapshot_wifi_event, restore);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_get_mutex(&ctx->mutex, CY_RTOS_NEVER_TIMEOUT);
+        if(ctx->restore == restore)
+        {
+            ctx->restore = NULL;
+        }
+        else
+        {
+            /* A concurrent disable took it and will deregister and destroy it */
+            restore = NULL;
+        }
+        cy_rtos_set_mutex(&ctx->mutex);
+
+        if(restore != NULL)
+        {
+            restore_destroy(restore);
+        }
+    }
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_set_snapshot_storage(cy_smartcoex_snapshot_t *storage)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_set_snapshot_storage(ctx, storage) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_get_snapshot(cy_smartcoex_snapshot_t *snapshot)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_get_snapshot(ctx, snapshot) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_restore(const cy_smartcoex_snapshot_t *snapshot, btcoex_cb_t btcoex_cb)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_restore(ctx, snapshot, btcoex_cb) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_set_auto_restore(bool enable)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_set_auto_restore(ctx, enable) : CY_RSLT_MW_ERROR;
+}
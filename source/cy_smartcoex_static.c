@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_static.c
+* @brief Coex configurations fixed at build time.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_static.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* The initializer lays out the VSC payload by hand; it must match le_scan_param */
+typedef char smartcoex_static_vsc_len_check_t[(sizeof(le_scan_param) == CY_SMARTCOEX_STATIC_VSC_PARAM_LEN) ? 1 : -1];
+typedef char smartcoex_static_vsc_layout_check_t[(offsetof(le_scan_param, maxScanWindow) == 0 &&
+                                                  offsetof(le_scan_param, scanDutyCycle) == 2 &&
+                                                  offsetof(le_scan_param, smallIntervalGrant) == 3) ? 1 : -1];
+
+cy_rslt_t cy_smartcoex_ctx_static_prepare(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_wifi_config_t *wifi_config)
+{
+    if(ctx == NULL || wifi_config == NULL || (uint32_t)wifi_config->interface >= SMARTCOEX_WIFI_INTERFACE_COUNT)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    /* Custom radio ops address the interface themselves */
+    if(!ctx->port_ops)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    return prepare_wifi_interface(wifi_config->interface);
+}
+
+cy_rslt_t cy_smartcoex_ctx_static_apply(cy_smartcoex_ctx_t *ctx, const cy_smartcoex_wifi_config_t *wifi_config,
+                                        const cy_smartcoex_static_config_t *config)
+{
+    cy_smartcoex_bt_config_t bt_config;
+    smartcoex_profile_entry_t entry;
+    cy_rslt_t result;
+    bool bt_busy;
+
+    if(ctx == NULL || wifi_config == NULL || config == NULL || (uint32_t)wifi_config->interface >= SMARTCOEX_WIFI_INTERFACE_COUNT)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    /* Copies of the const payloads, compared against the shadow as is; le_scan_param is sent in host order, little-endian */
+    memset(&bt_config, 0, sizeof(bt_config));
+    bt_config.scan_priority = config->scan_priority;
+    bt_config.scan_int      = config->scan_int;
+    bt_config.scan_win      = config->scan_win;
+    bt_config.btcoex_cb     = config->btcoex_cb;
+
+    memcpy(&entry.vsc_param, config->vsc_param, sizeof(entry.vsc_param));
+    entry.wifi_params = config->wifi_config.le_scan_params;
+
+    result = smartcoex_commit_entry_nowait(ctx, SMARTCOEX_WIFI_MASK(wifi_config->interface), &bt_config, &entry, &bt_busy);
+    if(result != CY_RSLT_SUCCESS && bt_busy)
+    {
+        return CY_RSLT_MW_TIMEOUT;
+    }
+
+    return result;
+}
+
+cy_rslt_t cy_smartcoex_static_prepare(const cy_smartcoex_wifi_config_t *wifi_config)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_static_prepare(ctx, wifi_config) : CY_RSLT_MW_ERROR;
+}
+
+cy_rslt_t cy_smartcoex_static_apply(const cy_smartcoex_wifi_config_t *wifi_config, const cy_smartcoex_static_config_t *config)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    return (ctx != NULL) ? cy_smartcoex_ctx_static_apply(ctx, wifi_config, config) : CY_RSLT_MW_ERROR;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_stats.c
+* @brief Per-stage latency histograms and result counters.
+*/
+
+#ifdef ENABLE_SMARTCOEX_STATS
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_stats.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <string.h>
+
+static uint8_t stats_bucket(uint32_t us)
+{
+    uint8_t bucket = 0;
+
+    while(us != 0 && bucket < CY_SMARTCOEX_STATS_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static void stats_add(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_stage_t stage, uint32_t us)
+{
+    cy_smartcoex_stats_histogram_t *hist = &ctx->stats.data.stage[stage];
+
+    cy_rtos_get_mutex(&ctx->stats.mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(hist->count == 0 || us < hist->min_us)
+    {
+        hist->min_us = us;
+    }
+    if(us > hist->max_us)
+    {
+        hist->max_us = us;
+    }
+    hist->count++;
+    hist->sum_us += us;
+    hist->buckets[stats_bucket(us)]++;
+    cy_rtos_set_mutex(&ctx->stats.mutex);
+}
+
+cy_rslt_t smartcoex_stats_init(cy_smartcoex_ctx_t *ctx)
+{
+    memset(&ctx->stats.data, 0, sizeof(ctx->stats.data));
+
+    return cy_rtos_init_mutex(&ctx->stats.mutex);
+}
+
+void smartcoex_stats_deinit(cy_smartcoex_ctx_t *ctx)
+{
+    cy_rtos_deinit_mutex(&ctx->stats.mutex);
+}
+
+void smartcoex_stats_record(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_stage_t stage, uint32_t start)
+{
+    stats_add(ctx, stage, timestamp_to_us(get_timestamp() - start));
+}
+
+void smartcoex_stats_record_us(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_stage_t stage, uint32_t us)
+{
+    stats_add(ctx, stage, us);
+}
+
+void smartcoex_stats_count(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_result_t result)
+{
+    cy_rtos_get_mutex(&ctx->stats.mutex, CY_RTOS_NEVER_TIMEOUT);
+    ctx->stats.data.result[result]++;
+    cy_rtos_set_mutex(&ctx->stats.mutex);
+}
+
+cy_rslt_t cy_smartcoex_ctx_stats_get(cy_smartcoex_ctx_t *ctx, cy_smartcoex_stats_t *stats)
+{
+    if(ctx == NULL || stats == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctx->stats.mutex, CY_RTOS_NEVER_TIMEOUT);
+    *stats = ctx->stats.data;
+    cy_rtos_set_mutex(&ctx->stats.mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_stats_reset(cy_smartcoex_ctx_t *ctx)
+{
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&ctx->stats.mutex, CY_RTOS_NEVER_TIMEOUT);
+    memset(&ctx->stats.data, 0, sizeof(ctx->stats.data));
+    cy_rtos_set_mutex(&ctx->stats.mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_stats_get(cy_smartcoex_stats_t *stats)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return cy_smartcoex_ctx_stats_get(ctx, stats);
+}
+
+cy_rslt_t cy_smartcoex_stats_reset(void)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return cy_smartcoex_ctx_stats_reset(ctx);
+}
+
+uint32_t cy_smartcoex_stats_percentile(const cy_smartcoex_stats_histogram_t *hist, uint8_t percent)
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+    uint32_t bound;
+    uint8_t i;
+
+    if(hist == NULL || hist->count == 0)
+    {
+        return 0;
+    }
+
+    if(percent > 100)
+    {
+        percent = 100;
+    }
+
+    /* Rank of the sample at the percentile, 1-based */
+    rank = ((uint64_t)hist->count * percent + 99) / 100;
+    if(rank == 0)
+    {
+        rank = 1;
+    }
+
+    for(i = 0; i < CY_SMARTCOEX_STATS_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if(seen >= rank)
+        {
+            break;
+        }
+    }
+
+    bound = (i == 0) ? 1 : ((i >= CY_SMARTCOEX_STATS_BUCKETS - 1) ? hist->max_us : (1UL << i));
+
+    return (bound < hist->max_us) ? bound : hist->max_us;
+}
+
+#endif /* ENABLE_SMARTCOEX_STATS */
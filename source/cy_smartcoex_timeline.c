@@ -0,0 +1,490 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_timeline.c
+* @brief Timeline that commits pre-planned coex profile changes at their deadlines.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_timeline.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Timeline thread parameters. Commits should start as soon as their deadline passes, so the thread runs high */
+#ifndef CY_SMARTCOEX_TIMELINE_THREAD_STACK_SIZE
+#define CY_SMARTCOEX_TIMELINE_THREAD_STACK_SIZE (2048)
+#endif
+
+#ifndef CY_SMARTCOEX_TIMELINE_THREAD_PRIORITY
+#define CY_SMARTCOEX_TIMELINE_THREAD_PRIORITY   (CY_RTOS_PRIORITY_HIGH)
+#endif
+
+/* Retry policy when the commit fails as busy; other failures are not retried */
+#ifndef CY_SMARTCOEX_TIMELINE_BUSY_RETRY_MAX
+#define CY_SMARTCOEX_TIMELINE_BUSY_RETRY_MAX      (8)
+#endif
+
+#ifndef CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MIN_MS
+#define CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MIN_MS (5)  // in milliseconds
+#endif
+
+#ifndef CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MAX_MS
+#define CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MAX_MS (80) // in milliseconds
+#endif
+
+/* Deadlines are compared on the wrapping millisecond clock, so they must lie within half its range */
+#define SMARTCOEX_TIMELINE_HORIZON_MS           (0x7FFFFFFFUL)
+
+/**
+ * Timeline entry with its payloads prebuilt at creation.
+ */
+typedef struct
+{
+    smartcoex_profile_entry_t      profile;
+    cy_smartcoex_lescan_priority_t scan_priority;
+    uint16_t                       scan_int;
+    uint16_t                       scan_win;
+    uint8_t                        trigger;
+    uint32_t                       at_ms;
+    bool                           armed;
+    cy_time_t                      due;
+} smartcoex_timeline_entry_t;
+
+/**
+ * Timeline state. The mutex guards the schedule and the counters; it is never
+ * held across a commit.
+ */
+struct cy_smartcoex_timeline
+{
+    cy_smartcoex_ctx_t             *ctx;
+    cy_smartcoex_wifi_config_t     wifi_config;
+    cy_smartcoex_bt_config_t       bt_config;
+    uint32_t                       period_ms;
+    cy_smartcoex_timeline_cb_t     cb;
+    void                           *cb_arg;
+    volatile bool                  exit;
+    cy_thread_t                    thread;
+    cy_mutex_t                     mutex;
+    cy_semaphore_t                 wakeup;
+
+    smartcoex_timeline_entry_t     entries[CY_SMARTCOEX_TIMELINE_MAX_ENTRIES];
+    uint8_t                        entry_count;
+    int8_t                         retry;       /* Entry whose commit failed as busy, or -1 */
+    cy_time_t                      retry_due;
+    uint32_t                       busy_retries; /* Busy retries of the current entry */
+    cy_time_t                      backoff_ms;
+
+    cy_smartcoex_timeline_state_t  state;
+};
+
+static bool timeline_is_due(cy_time_t now, cy_time_t due)
+{
+    return (cy_time_t)(now - due) <= SMARTCOEX_TIMELINE_HORIZON_MS;
+}
+
+static bool timeline_config_valid(cy_smartcoex_ctx_t *ctx, cy_smartcoex_wifi_config_t *wifi_config,
+                                  cy_smartcoex_bt_config_t *bt_config, const cy_smartcoex_timeline_config_t *config)
+{
+    cy_smartcoex_bt_config_t entry_bt_config = *bt_config;
+    const cy_smartcoex_timeline_entry_t *entry;
+    uint8_t i;
+
+    if(config->entry_count == 0 || config->entry_count > CY_SMARTCOEX_TIMELINE_MAX_ENTRIES ||
+       config->period_ms > SMARTCOEX_TIMELINE_HORIZON_MS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid number of timeline entries. Must be 1 to %d. \n", CY_SMARTCOEX_TIMELINE_MAX_ENTRIES);
+        return false;
+    }
+
+    for(i = 0; i < config->entry_count; i++)
+    {
+        entry = &config->entries[i];
+        if(entry->trigger > CY_SMARTCOEX_TIMELINE_MAX_TRIGGERS || entry->at_ms > SMARTCOEX_TIMELINE_HORIZON_MS ||
+           (entry->trigger == CY_SMARTCOEX_TIMELINE_START && config->period_ms != 0 && entry->at_ms >= config->period_ms))
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Invalid trigger or deadline in timeline entry %u. \n", (unsigned int)i);
+            return false;
+        }
+
+        entry_bt_config.scan_priority = entry->scan_priority;
+        entry_bt_config.scan_int      = entry->scan_int;
+        entry_bt_config.scan_win      = entry->scan_win;
+        if(!smartcoex_validate(ctx, wifi_config, &entry_bt_config))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Takes the entry to commit now, if any, and reschedules the entries that fell
+ * due. retry is set if the entry is a failed commit being retried. wait_ms
+ * receives the time until the next deadline. Called with the mutex held.
+ */
+static int8_t timeline_take(cy_smartcoex_timeline_t *timeline, cy_time_t now, cy_time_t *late_ms, bool *retry,
+                            cy_time_t *wait_ms)
+{
+    smartcoex_timeline_entry_t *entry;
+    int8_t pick = -1;
+    uint32_t count = 0;
+    uint8_t i;
+
+    *late_ms = 0;
+    *retry   = false;
+    *wait_ms = CY_RTOS_NEVER_TIMEOUT;
+
+    /* Of the entries due, the one with the latest deadline wins */
+    for(i = 0; i < timeline->entry_count; i++)
+    {
+        entry = &timeline->entries[i];
+        if(!entry->armed || !timeline_is_due(now, entry->due))
+        {
+            continue;
+        }
+
+        if(pick < 0 || (cy_time_t)(now - entry->due) <= *late_ms)
+        {
+            pick     = (int8_t)i;
+            *late_ms = now - entry->due;
+        }
+        count++;
+
+        if(entry->trigger == CY_SMARTCOEX_TIMELINE_START && timeline->period_ms != 0)
+        {
+            entry->due += timeline->period_ms;
+        }
+        else
+        {
+            entry->armed = false;
+        }
+    }
+
+    if(pick >= 0)
+    {
+        timeline->state.skipped += count - 1;
+        timeline->retry = -1;
+    }
+    else if(timeline->retry >= 0 && timeline_is_due(now, timeline->retry_due))
+    {
+        pick = timeline->retry;
+        timeline->retry = -1;
+        *retry = true;
+    }
+
+    /* A periodic entry still due after rescheduling is more than a period late; it runs next */
+    for(i = 0; i < timeline->entry_count; i++)
+    {
+        entry = &timeline->entries[i];
+        if(entry->armed && timeline_is_due(now, entry->due))
+        {
+            *wait_ms = 0;
+        }
+        else if(entry->armed && (cy_time_t)(entry->due - now) < *wait_ms)
+        {
+            *wait_ms = entry->due - now;
+        }
+    }
+    if(timeline->retry >= 0 && (cy_time_t)(timeline->retry_due - now) < *wait_ms)
+    {
+        *wait_ms = timeline->retry_due - now;
+    }
+
+    return pick;
+}
+
+/* Commits the entry falling due, if any. Returns how long to wait for the next deadline */
+static cy_time_t timeline_run(cy_smartcoex_timeline_t *timeline)
+{
+    cy_smartcoex_bt_config_t bt_config;
+    smartcoex_timeline_entry_t *entry;
+    cy_rslt_t result;
+    cy_time_t now = 0;
+    cy_time_t late_ms;
+    cy_time_t wait_ms;
+    int8_t pick;
+    bool retry;
+    bool bt_busy = false;
+    bool report  = true;
+
+    (void)cy_rtos_get_time(&now);
+
+    cy_rtos_get_mutex(&timeline->mutex, CY_RTOS_NEVER_TIMEOUT);
+    pick = timeline_take(timeline, now, &late_ms, &retry, &wait_ms);
+    if(pick >= 0 && !retry)
+    {
+        /* A new entry supersedes any busy retries of the previous one */
+        timeline->busy_retries = 0;
+        timeline->backoff_ms   = CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MIN_MS;
+    }
+    cy_rtos_set_mutex(&timeline->mutex);
+
+    if(pick < 0)
+    {
+        return wait_ms;
+    }
+
+    /* The payloads were validated and prebuilt at creation */
+    entry = &timeline->entries[pick];
+    bt_config               = timeline->bt_config;
+    bt_config.scan_priority = entry->scan_priority;
+    bt_config.scan_int      = entry->scan_int;
+    bt_config.scan_win      = entry->scan_win;
+    result = smartcoex_commit_entry(timeline->ctx, SMARTCOEX_WIFI_MASK(timeline->wifi_config.interface), &bt_config,
+                                    &entry->profile, &bt_busy);
+
+    cy_rtos_get_mutex(&timeline->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        timeline->state.last_entry = pick;
+        timeline->state.commits++;
+    }
+    else if(bt_busy && timeline->busy_retries < CY_SMARTCOEX_TIMELINE_BUSY_RETRY_MAX)
+    {
+        /* Transient; retried with backoff unless the next entry falls due first, and only the final result is reported */
+        (void)cy_rtos_get_time(&now);
+        timeline->busy_retries++;
+        timeline->retry      = pick;
+        timeline->retry_due  = now + timeline->backoff_ms;
+        timeline->backoff_ms = (timeline->backoff_ms * 2U > CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MAX_MS) ?
+                               CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MAX_MS : timeline->backoff_ms * 2U;
+        report = false;
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Retrying timeline entry %d after BT busy, attempt %u\n", (int)pick, (unsigned int)timeline->busy_retries);
+    }
+    else
+    {
+        /* The entry stays failed until the next entry falls due */
+        timeline->state.failures++;
+    }
+    /* Lateness is measured on the first attempt; a retry is late by design */
+    if(!retry)
+    {
+        timeline->state.last_late_ms = late_ms;
+        if(late_ms > timeline->state.max_late_ms)
+        {
+            timeline->state.max_late_ms = late_ms;
+        }
+    }
+    cy_rtos_set_mutex(&timeline->mutex);
+
+    if(report && timeline->cb != NULL)
+    {
+        timeline->cb(result, (uint8_t)pick, timeline->cb_arg);
+    }
+
+    /* Look for the next deadline after the commit, which took time of its own */
+    return 0;
+}
+
+static void timeline_worker(cy_thread_arg_t arg)
+{
+    cy_smartcoex_timeline_t *timeline = (cy_smartcoex_timeline_t *)arg;
+    cy_time_t wait_ms = 0;
+
+    while(!timeline->exit)
+    {
+        if(wait_ms != 0)
+        {
+            cy_rtos_get_semaphore(&timeline->wakeup, wait_ms, false);
+            if(timeline->exit)
+            {
+                break;
+            }
+        }
+        wait_ms = timeline_run(timeline);
+    }
+
+    cy_rtos_exit_thread();
+}
+
+cy_rslt_t cy_smartcoex_timeline_create(cy_smartcoex_timeline_t **timeline, cy_smartcoex_ctx_t *ctx,
+                                       cy_smartcoex_wifi_config_t *wifi_config, cy_smartcoex_bt_config_t *bt_config,
+                                       const cy_smartcoex_timeline_config_t *config)
+{
+    cy_smartcoex_timeline_t *new_timeline;
+    smartcoex_timeline_entry_t *entry;
+    cy_rslt_t result;
+    cy_time_t now = 0;
+    uint8_t i;
+
+    if(timeline == NULL || wifi_config == NULL || bt_config == NULL || config == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    if(ctx == NULL)
+    {
+        ctx = smartcoex_default_ctx();
+        if(ctx == NULL)
+        {
+            return CY_RSLT_MW_ERROR;
+        }
+    }
+
+    if(!timeline_config_valid(ctx, wifi_config, bt_config, config))
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    new_timeline = (cy_smartcoex_timeline_t *)calloc(1, sizeof(cy_smartcoex_timeline_t));
+    if(new_timeline == NULL)
+    {
+        return CY_RSLT_MW_NOMEM;
+    }
+    new_timeline->ctx         = ctx;
+    new_timeline->wifi_config = *wifi_config;
+    new_timeline->bt_config   = *bt_config;
+    new_timeline->period_ms   = config->period_ms;
+    new_timeline->cb          = config->cb;
+    new_timeline->cb_arg      = config->cb_arg;
+    new_timeline->entry_count = config->entry_count;
+    new_timeline->retry       = -1;
+    new_timeline->backoff_ms  = CY_SMARTCOEX_TIMELINE_BUSY_BACKOFF_MIN_MS;
+    new_timeline->state.last_entry = -1;
+
+    (void)cy_rtos_get_time(&now);
+
+    /* Registered profiles are never modified, so the validated entries can be copied out */
+    for(i = 0; i < config->entry_count; i++)
+    {
+        entry = &new_timeline->entries[i];
+        entry->profile       = ctx->profiles[config->entries[i].scan_priority];
+        entry->scan_priority = config->entries[i].scan_priority;
+        entry->scan_int      = config->entries[i].scan_int;
+        entry->scan_win      = config->entries[i].scan_win;
+        entry->trigger       = config->entries[i].trigger;
+        entry->at_ms         = config->entries[i].at_ms;
+        entry->armed         = (entry->trigger == CY_SMARTCOEX_TIMELINE_START);
+        entry->due           = now + entry->at_ms;
+    }
+
+    result = cy_rtos_init_mutex(&new_timeline->mutex);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        free(new_timeline);
+        return result;
+    }
+
+    result = cy_rtos_init_semaphore(&new_timeline->wakeup, 1, 0);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&new_timeline->mutex);
+        free(new_timeline);
+        return result;
+    }
+
+    result = cy_rtos_create_thread(&new_timeline->thread, timeline_worker, "smartcoex_timeline", NULL,
+                                   CY_SMARTCOEX_TIMELINE_THREAD_STACK_SIZE, CY_SMARTCOEX_TIMELINE_THREAD_PRIORITY, new_timeline);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to create Smart Coex timeline thread:[0x%X]\n", (unsigned int)result);
+        cy_rtos_deinit_semaphore(&new_timeline->wakeup);
+        cy_rtos_deinit_mutex(&new_timeline->mutex);
+        free(new_timeline);
+        return result;
+    }
+
+    *timeline = new_timeline;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_timeline_destroy(cy_smartcoex_timeline_t *timeline)
+{
+    if(timeline == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    timeline->exit = true;
+    cy_rtos_set_semaphore(&timeline->wakeup, false);
+    cy_rtos_join_thread(&timeline->thread);
+
+    cy_rtos_deinit_semaphore(&timeline->wakeup);
+    cy_rtos_deinit_mutex(&timeline->mutex);
+    free(timeline);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_timeline_trigger(cy_smartcoex_timeline_t *timeline, uint8_t trigger)
+{
+    smartcoex_timeline_entry_t *entry;
+    cy_time_t now = 0;
+    uint8_t i;
+
+    if(timeline == NULL || trigger == CY_SMARTCOEX_TIMELINE_START || trigger > CY_SMARTCOEX_TIMELINE_MAX_TRIGGERS)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    (void)cy_rtos_get_time(&now);
+
+    cy_rtos_get_mutex(&timeline->mutex, CY_RTOS_NEVER_TIMEOUT);
+    for(i = 0; i < timeline->entry_count; i++)
+    {
+        entry = &timeline->entries[i];
+        if(entry->trigger == trigger)
+        {
+            entry->armed = true;
+            entry->due   = now + entry->at_ms;
+        }
+    }
+    cy_rtos_set_mutex(&timeline->mutex);
+
+    cy_rtos_set_semaphore(&timeline->wakeup, false);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_timeline_get_state(cy_smartcoex_timeline_t *timeline, cy_smartcoex_timeline_state_t *state)
+{
+    if(timeline == NULL || state == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&timeline->mutex, CY_RTOS_NEVER_TIMEOUT);
+    *state = timeline->state;
+    cy_rtos_set_mutex(&timeline->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+/**
+* @file cy_smartcoex_trace.c
+* @brief Binary trace of coex config requests and outcomes, and its encoding.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_trace.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_result_mw.h"
+
+#include <string.h>
+
+/* The trace encoding holds the settings of two LE connection roles */
+typedef char smartcoex_trace_roles_check_t[(CY_SMARTCOEX_LE_ROLE_MAX == 2) ? 1 : -1];
+
+#define TRACE_MAGIC                 "SCXT"
+#define TRACE_RECORD_HEADER_SIZE    (12)
+
+#if defined(ENABLE_SMARTCOEX_TRACE)
+
+#if !defined(__GNUC__)
+#error "ENABLE_SMARTCOEX_TRACE requires GCC or Clang"
+#endif
+
+#if (CY_SMARTCOEX_TRACE_RECORDS & (CY_SMARTCOEX_TRACE_RECORDS - 1)) != 0
+#error "CY_SMARTCOEX_TRACE_RECORDS must be a power of two"
+#endif
+
+#define TRACE_MASK      (CY_SMARTCOEX_TRACE_RECORDS - 1U)
+
+/*
+ * Same scheme as the binary log: writers claim slots with an atomic increment
+ * of trace_head, then publish each by storing its sequence number last. A slot
+ * whose seq is 0 is being written. A commit claims its REQUEST and OUTCOME
+ * together so that they are adjacent.
+ */
+static cy_smartcoex_trace_record_t trace_ring[CY_SMARTCOEX_TRACE_RECORDS];
+static uint32_t trace_head = 0;
+static uint8_t  trace_next_id = 0;
+
+static cy_smartcoex_trace_record_t *trace_claim(uint32_t seq)
+{
+    cy_smartcoex_trace_record_t *record = &trace_ring[(seq - 1U) & TRACE_MASK];
+
+    __atomic_store_n(&record->seq, 0U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memset((uint8_t *)record + sizeof(record->seq), 0, sizeof(*record) - sizeof(record->seq));
+
+    return record;
+}
+
+static void trace_publish(cy_smartcoex_trace_record_t *record, uint32_t seq)
+{
+    __atomic_store_n(&record->seq, seq, __ATOMIC_RELEASE);
+}
+
+void smartcoex_trace_init(cy_smartcoex_ctx_t *ctx)
+{
+    ctx->trace_id = __atomic_fetch_add(&trace_next_id, 1U, __ATOMIC_RELAXED);
+}
+
+void smartcoex_trace_commit(cy_smartcoex_ctx_t *ctx, uint32_t wifi_interfaces, const cy_smartcoex_bt_config_t *bt_config,
+                            const smartcoex_profile_entry_t *entry, const smartcoex_commit_outcome_t *outcome,
+                            cy_rslt_t result, bool bt_busy)
+{
+    cy_smartcoex_trace_record_t *record;
+    uint32_t now = get_timestamp();
+    uint32_t seq;
+
+    seq    = __atomic_add_fetch(&trace_head, 2U, __ATOMIC_RELAXED) - 1U;
+    record = trace_claim(seq);
+    record->timestamp                    = outcome->start;
+    record->type                         = CY_SMARTCOEX_TRACE_REQUEST;
+    record->ctx_id                       = ctx->trace_id;
+    record->interfaces                   = (uint8_t)wifi_interfaces;
+    record->scan_priority                = (uint8_t)bt_config->scan_priority;
+    record->profile.priority             = (cy_smartcoex_lescan_priority_t)entry->wifi_params.priority;
+    record->profile.duty_cycle           = entry->vsc_param.scanDutyCycle;
+    record->profile.max_scan_window      = entry->vsc_param.maxScanWindow;
+    record->profile.small_interval_grant = entry->vsc_param.smallIntervalGrant;
+    record->scan_int                     = bt_config->scan_int;
+    record->scan_win                     = bt_config->scan_win;
+    memcpy(record->conn, bt_config->conn, sizeof(record->conn));
+    record->adv                          = bt_config->adv;
+    trace_publish(record, seq);
+
+    seq++;
+    record = trace_claim(seq);
+    record->timestamp   = now;
+    record->type        = CY_SMARTCOEX_TRACE_OUTCOME;
+    record->ctx_id      = ctx->trace_id;
+    record->flags       = (uint8_t)(outcome->flags | (bt_busy ? CY_SMARTCOEX_TRACE_FLAG_BUSY : 0U));
+    record->result      = result;
+    record->wifi_result = outcome->wifi_result;
+    record->vsc_result  = (uint16_t)outcome->vsc_result;
+    record->link_result = (uint16_t)outcome->link_result;
+    record->vsc_gen     = outcome->vsc_gen;
+    record->link_gen    = outcome->link_gen;
+    trace_publish(record, seq);
+}
+
+void smartcoex_trace_completion(cy_smartcoex_ctx_t *ctx, bool link, uint32_t gen, uint8_t hci_status, uint32_t rtt_us)
+{
+    cy_smartcoex_trace_record_t *record;
+    uint32_t seq;
+
+    seq    = __atomic_add_fetch(&trace_head, 1U, __ATOMIC_RELAXED);
+    record = trace_claim(seq);
+    record->timestamp  = get_timestamp();
+    record->type       = CY_SMARTCOEX_TRACE_COMPLETION;
+    record->ctx_id     = ctx->trace_id;
+    record->flags      = link ? CY_SMARTCOEX_TRACE_FLAG_LINK : 0U;
+    record->hci_status = hci_status;
+    record->gen        = gen;
+    record->rtt_us     = rtt_us;
+    trace_publish(record, seq);
+}
+
+uint32_t cy_smartcoex_trace_read(uint32_t *cursor, cy_smartcoex_trace_record_t *records, uint32_t max_records,
+                                 uint32_t *us_per_mtick)
+{
+    const cy_smartcoex_trace_record_t *record;
+    uint32_t head;
+    uint32_t seq;
+    uint32_t count = 0;
+
+    if(us_per_mtick != NULL)
+    {
+        *us_per_mtick = timestamp_to_us(1000000U);
+    }
+
+    if(cursor == NULL || records == NULL)
+    {
+        return 0;
+    }
+
+    head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    seq  = *cursor + 1U;
+    if(head - *cursor > CY_SMARTCOEX_TRACE_RECORDS)
+    {
+        seq = head - CY_SMARTCOEX_TRACE_RECORDS + 1U;
+    }
+
+    for(; seq != head + 1U && count < max_records; seq++)
+    {
+        record = &trace_ring[(seq - 1U) & TRACE_MASK];
+        if(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != seq)
+        {
+            /* Still being written, or already overwritten by a newer record */
+            continue;
+        }
+        records[count] = *record;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&record->seq, __ATOMIC_RELAXED) != seq)
+        {
+            continue;
+        }
+        records[count].seq = seq;
+        count++;
+        *cursor = seq;
+    }
+
+    return count;
+}
+
+#endif /* ENABLE_SMARTCOEX_TRACE */
+
+static void put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *buf, uint32_t value)
+{
+    put_u16(buf, (uint16_t)value);
+    put_u16(buf + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return (uint32_t)get_u16(buf) | ((uint32_t)get_u16(buf + 2) << 16);
+}
+
+static void put_event(uint8_t *buf, const cy_smartcoex_le_event_config_t *event)
+{
+    buf[0] = (uint8_t)event->priority;
+    buf[1] = event->grant;
+    buf[2] = event->max_missed;
+}
+
+static void get_event(const uint8_t *buf, cy_smartcoex_le_event_config_t *event)
+{
+    event->priority   = (cy_smartcoex_lescan_priority_t)buf[0];
+    event->grant      = buf[1];
+    event->max_missed = buf[2];
+}
+
+void cy_smartcoex_trace_encode_header(uint32_t us_per_mtick, uint8_t *buf)
+{
+    memset(buf, 0, CY_SMARTCOEX_TRACE_HEADER_SIZE);
+    memcpy(buf, TRACE_MAGIC, 4);
+    put_u16(&buf[4], CY_SMARTCOEX_TRACE_VERSION);
+    put_u16(&buf[6], CY_SMARTCOEX_TRACE_RECORD_SIZE);
+    put_u32(&buf[8], us_per_mtick);
+}
+
+cy_rslt_t cy_smartcoex_trace_decode_header(const uint8_t *buf, uint32_t *us_per_mtick)
+{
+    if(buf == NULL || us_per_mtick == NULL || memcmp(buf, TRACE_MAGIC, 4) != 0)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+    if(get_u16(&buf[4]) > CY_SMARTCOEX_TRACE_VERSION || get_u16(&buf[6]) != CY_SMARTCOEX_TRACE_RECORD_SIZE)
+    {
+        return CY_RSLT_MW_UNSUPPORTED;
+    }
+    *us_per_mtick = get_u32(&buf[8]);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_smartcoex_trace_encode(const cy_smartcoex_trace_record_t *record, uint8_t *buf)
+{
+    uint8_t *body = &buf[TRACE_RECORD_HEADER_SIZE];
+
+    memset(buf, 0, CY_SMARTCOEX_TRACE_RECORD_SIZE);
+    put_u32(&buf[0], record->seq);
+    put_u32(&buf[4], record->timestamp);
+    buf[8]  = (uint8_t)record->type;
+    buf[9]  = record->ctx_id;
+    buf[10] = record->flags;
+
+    switch(record->type)
+    {
+        case CY_SMARTCOEX_TRACE_REQUEST:
+            body[0] = record->interfaces;
+            body[1] = record->scan_priority;
+            body[2] = (uint8_t)record->profile.priority;
+            body[3] = record->profile.duty_cycle;
+            put_u16(&body[4], record->profile.max_scan_window);
+            body[6] = record->profile.small_interval_grant;
+            put_u16(&body[7], record->scan_int);
+            put_u16(&body[9], record->scan_win);
+            put_event(&body[11], &record->conn[0]);
+            put_event(&body[14], &record->conn[1]);
+            put_event(&body[17], &record->adv);
+            break;
+
+        case CY_SMARTCOEX_TRACE_OUTCOME:
+            put_u32(&body[0], record->result);
+            put_u32(&body[4], record->wifi_result);
+            put_u16(&body[8], record->vsc_result);
+            put_u16(&body[10], record->link_result);
+            put_u32(&body[12], record->vsc_gen);
+            put_u32(&body[16], record->link_gen);
+            break;
+
+        case CY_SMARTCOEX_TRACE_COMPLETION:
+            buf[11] = record->hci_status;
+            put_u32(&body[0], record->gen);
+            put_u32(&body[4], record->rtt_us);
+            break;
+
+        default:
+            break;
+    }
+}
+
+cy_rslt_t cy_smartcoex_trace_decode(const uint8_t *buf, cy_smartcoex_trace_record_t *record)
+{
+    const uint8_t *body = &buf[TRACE_RECORD_HEADER_SIZE];
+
+    memset(record, 0, sizeof(*record));
+    record->seq       = get_u32(&buf[0]);
+    record->timestamp = get_u32(&buf[4]);
+    record->type      = (cy_smartcoex_trace_type_t)buf[8];
+    record->ctx_id    = buf[9];
+    record->flags     = buf[10];
+
+    switch(record->type)
+    {
+        case CY_SMARTCOEX_TRACE_REQUEST:
+            record->interfaces                   = body[0];
+            record->scan_priority                = body[1];
+            record->profile.priority             = (cy_smartcoex_lescan_priority_t)body[2];
+            record->profile.duty_cycle           = body[3];
+            record->profile.max_scan_window      = get_u16(&body[4]);
+            record->profile.small_interval_grant = body[6];
+            record->scan_int                     = get_u16(&body[7]);
+            record->scan_win                     = get_u16(&body[9]);
+            get_event(&body[11], &record->conn[0]);
+            get_event(&body[14], &record->conn[1]);
+            get_event(&body[17], &record->adv);
+            break;
+
+        case CY_SMARTCOEX_TRACE_OUTCOME:
+            record->result      = get_u32(&body[0]);
+            record->wifi_result = get_u32(&body[4]);
+            record->vsc_result  = get_u16(&body[8]);
+            record->link_result = get_u16(&body[10]);
+            record->vsc_gen     = get_u32(&body[12]);
+            record->link_gen    = get_u32(&body[16]);
+            break;
+
+        case CY_SMARTCOEX_TRACE_COMPLETION:
+            record->hci_status = buf[11];
+            record->gen        = get_u32(&body[0]);
+            record->rtt_us     = get_u32(&body[4]);
+            break;
+
+        default:
+            return CY_RSLT_MW_BADARG;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
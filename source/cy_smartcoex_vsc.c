@@ -0,0 +1,592 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/**
+* @file cy_smartcoex_vsc.c
+* @brief Tracks the completion of the coex VSCs sent by each context.
+*/
+
+#include "cy_smartcoex.h"
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+#include <string.h>
+
+/* Number of VSCs awaiting completion across all contexts */
+#ifndef CY_SMARTCOEX_VSC_TRACK_MAX
+#define CY_SMARTCOEX_VSC_TRACK_MAX          (16)
+#endif
+
+/* How long destroying a context waits for its outstanding completions */
+#ifndef CY_SMARTCOEX_VSC_DRAIN_TIMEOUT_MS
+#define CY_SMARTCOEX_VSC_DRAIN_TIMEOUT_MS   (100) // in milliseconds
+#endif
+
+/* HCI status reported when a completion carries no return parameters */
+#define VSC_HCI_STATUS_SUCCESS              (0x00)
+
+/**
+ * A VSC awaiting completion. The completion callback carries no user argument,
+ * so each BT controller, identified by the send_vsc and arg of the radio ops,
+ * gets its own trampoline. A controller completes vendor-specific commands in
+ * the order they were sent, so completions are matched FIFO per controller.
+ */
+typedef struct
+{
+    cy_smartcoex_ctx_t *ctx;        /* NULL once the context is destroyed */
+    btcoex_cb_t        cb;
+    uint32_t           gen;
+    uint32_t           start;
+    uint8_t            queue;       /* Controller the VSC was sent to */
+    bool               released;    /* Send failed or completion matched; freed once at the head */
+    bool               link;        /* LE link VSC; gen is a link sequence number */
+    bool               wifi_done;   /* The Wi-Fi side of a commit relying on this VSC is applied */
+    uint32_t           commit_start;
+    uint32_t           commit_gen;  /* Commit that sent this VSC */
+    bool               rollback;    /* The commit changed Wi-Fi; restore wifi_prev if this VSC fails */
+    smartcoex_wifi_state_t wifi_prev;
+} smartcoex_vsc_entry_t;
+
+static cy_mutex_t            vsc_mutex;
+static smartcoex_once_t      vsc_once;
+static smartcoex_vsc_entry_t vsc_ring[CY_SMARTCOEX_VSC_TRACK_MAX];
+static uint8_t               vsc_head  = 0;
+static uint8_t               vsc_count = 0;
+
+/* BT controller sharing one completion order */
+typedef struct
+{
+    wiced_result_t (*send_vsc)(void *arg, uint16_t opcode, uint8_t param_len, uint8_t *p_param_buf,
+                               wiced_bt_dev_vendor_specific_command_complete_cback_t *p_cback);
+    void    *arg;
+    uint8_t users;                  /* Contexts sending to this controller */
+} smartcoex_vsc_queue_t;
+
+static smartcoex_vsc_queue_t vsc_queue[SMARTCOEX_VSC_QUEUE_MAX];
+
+/* Frees the released entries at the head. Called with vsc_mutex held */
+static void vsc_reclaim(void)
+{
+    while(vsc_count != 0 && vsc_ring[vsc_head].released)
+    {
+        vsc_head = (uint8_t)((vsc_head + 1) % CY_SMARTCOEX_VSC_TRACK_MAX);
+        vsc_count--;
+    }
+}
+
+/* Completion of the oldest outstanding VSC sent to controller queue */
+static void vsc_complete(uint8_t queue, wiced_bt_dev_vendor_specific_command_complete_params_t *p_command_complete_params)
+{
+    smartcoex_vsc_entry_t *match = NULL;
+    smartcoex_vsc_entry_t entry;
+    smartcoex_vsc_state_t *vsc;
+    uint32_t now = get_timestamp();
+    uint32_t rtt_us;
+    uint32_t applied_us = 0;
+    uint8_t status = VSC_HCI_STATUS_SUCCESS;
+    uint8_t i;
+
+    if(p_command_complete_params != NULL && p_command_complete_params->param_len > 0 &&
+       p_command_complete_params->p_param_buf != NULL)
+    {
+        status = p_command_complete_params->p_param_buf[0];
+    }
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    for(i = 0; i < vsc_count; i++)
+    {
+        match = &vsc_ring[(vsc_head + i) % CY_SMARTCOEX_VSC_TRACK_MAX];
+        if(match->queue == queue && !match->released)
+        {
+            break;
+        }
+    }
+    if(i == vsc_count)
+    {
+        cy_rtos_set_mutex(&vsc_mutex);
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unmatched VSC completion.\n");
+        return;
+    }
+    entry = *match;
+    match->released = true;
+    vsc_reclaim();
+    if(entry.ctx != NULL)
+    {
+        /* Holds off smartcoex_vsc_deinit until the last access below */
+        entry.ctx->vsc.in_callback++;
+    }
+
+    rtt_us = timestamp_to_us(now - entry.start);
+    if(entry.ctx != NULL)
+    {
+        vsc = &entry.ctx->vsc;
+        vsc->completed++;
+        vsc->last_hci_status = status;
+        vsc->last_rtt_us     = rtt_us;
+        if(status != VSC_HCI_STATUS_SUCCESS)
+        {
+            vsc->failed++;
+            if(entry.link)
+            {
+                if(entry.gen == vsc->link_gen)
+                {
+                    vsc->link_stale_gen = entry.gen;
+                }
+            }
+            else
+            {
+                vsc->failed_gen = entry.gen;
+                if(entry.gen == vsc->gen)
+                {
+                    /* Left to smartcoex_vsc_settle; the Wi-Fi ioctl must not run on the BT stack's thread */
+                    vsc->stale_gen      = entry.gen;
+                    vsc->rollback_valid = entry.rollback;
+                    vsc->rollback       = entry.wifi_prev;
+                    if(entry.rollback && vsc->notify != NULL)
+                    {
+                        cy_rtos_set_semaphore(vsc->notify, false);
+                    }
+                }
+            }
+        }
+        else if(!entry.link)
+        {
+            /* Later commits that left BT unchanged relied on the most recent VSC */
+            vsc->bt_live = entry.commit_gen;
+            if(entry.gen == vsc->gen && vsc->bt_pending > entry.commit_gen)
+            {
+                vsc->bt_live = vsc->bt_pending;
+            }
+            if(entry.wifi_done)
+            {
+                /* The Wi-Fi side was applied first; the commit is complete now */
+                applied_us = timestamp_to_us(now - entry.commit_start);
+                vsc->last_applied_us = applied_us;
+            }
+        }
+    }
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    if(entry.ctx != NULL)
+    {
+        SMARTCOEX_STATS_RECORD_US(entry.ctx, VSC_COMPLETE, rtt_us);
+        if(applied_us != 0)
+        {
+            SMARTCOEX_STATS_RECORD_US(entry.ctx, APPLIED, applied_us);
+        }
+#ifdef ENABLE_SMARTCOEX_TRACE
+        smartcoex_trace_completion(entry.ctx, entry.link, entry.gen, status, rtt_us);
+#endif
+
+        if(status != VSC_HCI_STATUS_SUCCESS)
+        {
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Coex VSC failed with HCI status:[0x%X]\n", (unsigned int)status);
+        }
+
+        /* Last access to the context; destroy waits for this */
+        cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+        entry.ctx->vsc.inflight--;
+        entry.ctx->vsc.in_callback--;
+        cy_rtos_set_mutex(&vsc_mutex);
+    }
+
+    if(entry.cb != NULL)
+    {
+        entry.cb(p_command_complete_params);
+    }
+}
+
+/* Completion trampolines handed to the BT stack in place of btcoex_cb, one per controller */
+static void vsc_complete_0(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    vsc_complete(0, p);
+}
+
+static void vsc_complete_1(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    vsc_complete(1, p);
+}
+
+static void vsc_complete_2(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    vsc_complete(2, p);
+}
+
+static void vsc_complete_3(wiced_bt_dev_vendor_specific_command_complete_params_t *p)
+{
+    vsc_complete(3, p);
+}
+
+static const btcoex_cb_t vsc_trampoline[SMARTCOEX_VSC_QUEUE_MAX] =
+{
+    vsc_complete_0, vsc_complete_1, vsc_complete_2, vsc_complete_3
+};
+
+static cy_rslt_t vsc_mutex_init(void *arg)
+{
+    (void)arg;
+    return cy_rtos_init_mutex(&vsc_mutex);
+}
+
+cy_rslt_t smartcoex_vsc_init(cy_smartcoex_ctx_t *ctx)
+{
+    cy_rslt_t result;
+    uint8_t free_queue;
+    uint8_t queue;
+    uint8_t i;
+
+    /* Contexts may be created concurrently; the shared tracker mutex is created once */
+    result = smartcoex_once(&vsc_once, vsc_mutex_init, NULL);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    memset(&ctx->vsc, 0, sizeof(ctx->vsc));
+
+    /* Join the queue of the controller, or claim an unused one without completions still due */
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    free_queue = SMARTCOEX_VSC_QUEUE_MAX;
+    for(queue = 0; queue < SMARTCOEX_VSC_QUEUE_MAX; queue++)
+    {
+        if(vsc_queue[queue].send_vsc == ctx->radio_ops.send_vsc && vsc_queue[queue].arg == ctx->radio_ops.arg)
+        {
+            break;
+        }
+        if(free_queue == SMARTCOEX_VSC_QUEUE_MAX && vsc_queue[queue].users == 0)
+        {
+            for(i = 0; i < vsc_count; i++)
+            {
+                if(vsc_ring[(vsc_head + i) % CY_SMARTCOEX_VSC_TRACK_MAX].queue == queue)
+                {
+                    break;
+                }
+            }
+            if(i == vsc_count)
+            {
+                free_queue = queue;
+            }
+        }
+    }
+    if(queue == SMARTCOEX_VSC_QUEUE_MAX)
+    {
+        if(free_queue == SMARTCOEX_VSC_QUEUE_MAX)
+        {
+            cy_rtos_set_mutex(&vsc_mutex);
+            cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Too many distinct BT controllers.\n");
+            return CY_RSLT_MW_NOMEM;
+        }
+        queue = free_queue;
+        vsc_queue[queue].send_vsc = ctx->radio_ops.send_vsc;
+        vsc_queue[queue].arg      = ctx->radio_ops.arg;
+    }
+    vsc_queue[queue].users++;
+    ctx->vsc.queue = queue;
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void smartcoex_vsc_deinit(cy_smartcoex_ctx_t *ctx)
+{
+    uint32_t waited_ms = 0;
+    uint8_t inflight;
+    uint8_t i;
+
+    for(;;)
+    {
+        cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+        inflight = ctx->vsc.inflight;
+        if(inflight == 0 || waited_ms >= CY_SMARTCOEX_VSC_DRAIN_TIMEOUT_MS)
+        {
+            break;
+        }
+        cy_rtos_set_mutex(&vsc_mutex);
+        cy_rtos_delay_milliseconds(1);
+        waited_ms++;
+    }
+
+    /* Completions that never came are still forwarded if they arrive, but no longer recorded */
+    for(i = 0; i < CY_SMARTCOEX_VSC_TRACK_MAX; i++)
+    {
+        if(vsc_ring[i].ctx == ctx)
+        {
+            vsc_ring[i].ctx = NULL;
+        }
+    }
+
+    /* A completion matched before the timeout may still be using the context; it is never left running */
+    while(ctx->vsc.in_callback != 0)
+    {
+        cy_rtos_set_mutex(&vsc_mutex);
+        cy_rtos_delay_milliseconds(1);
+        cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+    /* The queue stays bound to the controller while its completions are due; see smartcoex_vsc_init */
+    vsc_queue[ctx->vsc.queue].users--;
+    cy_rtos_set_mutex(&vsc_mutex);
+}
+
+btcoex_cb_t smartcoex_vsc_begin(cy_smartcoex_ctx_t *ctx, btcoex_cb_t cb, bool link, uint8_t *slot, uint32_t *gen)
+{
+    smartcoex_vsc_entry_t *entry;
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(ctx->vsc.inflight >= CY_SMARTCOEX_VSC_WINDOW || vsc_count == CY_SMARTCOEX_VSC_TRACK_MAX)
+    {
+        cy_rtos_set_mutex(&vsc_mutex);
+        return NULL;
+    }
+
+    *slot  = (uint8_t)((vsc_head + vsc_count) % CY_SMARTCOEX_VSC_TRACK_MAX);
+    entry  = &vsc_ring[*slot];
+    *gen   = link ? ++ctx->vsc.link_gen : ++ctx->vsc.gen;
+    entry->ctx       = ctx;
+    entry->cb        = cb;
+    entry->gen       = *gen;
+    entry->queue     = ctx->vsc.queue;
+    entry->released  = false;
+    entry->link      = link;
+    entry->wifi_done = false;
+    entry->rollback  = false;
+    entry->start     = get_timestamp();
+    vsc_count++;
+    ctx->vsc.inflight++;
+    ctx->vsc.sent++;
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    return vsc_trampoline[ctx->vsc.queue];
+}
+
+void smartcoex_vsc_cancel(cy_smartcoex_ctx_t *ctx, uint8_t slot)
+{
+    uint8_t tail;
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    vsc_ring[slot].released = true;
+    ctx->vsc.inflight--;
+    ctx->vsc.sent--;
+    while(vsc_count != 0)
+    {
+        tail = (uint8_t)((vsc_head + vsc_count - 1) % CY_SMARTCOEX_VSC_TRACK_MAX);
+        if(!vsc_ring[tail].released)
+        {
+            break;
+        }
+        vsc_count--;
+    }
+    cy_rtos_set_mutex(&vsc_mutex);
+}
+
+void smartcoex_vsc_set_notify(cy_smartcoex_ctx_t *ctx, cy_semaphore_t *notify)
+{
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    ctx->vsc.notify = notify;
+    cy_rtos_set_mutex(&vsc_mutex);
+}
+
+void smartcoex_vsc_settle(cy_smartcoex_ctx_t *ctx)
+{
+    smartcoex_vsc_state_t *vsc = &ctx->vsc;
+    smartcoex_wifi_state_t wifi_prev;
+    bool restore = false;
+
+    /* Resend on the next commit and undo the Wi-Fi side, unless a newer VSC has been sent since the failure */
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    if(vsc->link_stale_gen != 0)
+    {
+        if(vsc->link_stale_gen == vsc->link_gen)
+        {
+            ctx->shadow.link_valid = false;
+        }
+        vsc->link_stale_gen = 0;
+    }
+    if(vsc->stale_gen != 0)
+    {
+        if(vsc->stale_gen == vsc->gen)
+        {
+            ctx->shadow.bt_valid = false;
+            restore   = vsc->rollback_valid;
+            wifi_prev = vsc->rollback;
+        }
+        vsc->stale_gen      = 0;
+        vsc->rollback_valid = false;
+    }
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    if(restore && smartcoex_rollback_wifi(ctx, &wifi_prev) == CY_RSLT_SUCCESS)
+    {
+        cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+        vsc->wifi_live = wifi_prev.gen;
+        cy_rtos_set_mutex(&vsc_mutex);
+    }
+}
+
+uint32_t smartcoex_vsc_next_gen(cy_smartcoex_ctx_t *ctx)
+{
+    uint32_t gen;
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    gen = ++ctx->vsc.requested;
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    return gen;
+}
+
+void smartcoex_vsc_arm(cy_smartcoex_ctx_t *ctx, uint8_t slot, uint32_t gen, const smartcoex_wifi_state_t *wifi_prev)
+{
+    smartcoex_vsc_entry_t *entry = &vsc_ring[slot];
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    entry->commit_gen = gen;
+    entry->rollback   = (wifi_prev != NULL);
+    if(wifi_prev != NULL)
+    {
+        entry->wifi_prev     = *wifi_prev;
+        entry->wifi_prev.gen = ctx->vsc.wifi_live;
+    }
+    cy_rtos_set_mutex(&vsc_mutex);
+}
+
+bool smartcoex_vsc_committed(cy_smartcoex_ctx_t *ctx, uint32_t gen, uint32_t vsc_gen, uint32_t start)
+{
+    smartcoex_vsc_state_t *vsc = &ctx->vsc;
+    smartcoex_vsc_entry_t *entry;
+    uint32_t applied_us = 0;
+    uint8_t i;
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if(vsc_gen != 0 && vsc->failed_gen == vsc_gen)
+    {
+        cy_rtos_set_mutex(&vsc_mutex);
+        return false;
+    }
+    vsc->wifi_live = gen;
+
+    /* The BT side of the commit is the most recent VSC, whether or not this commit sent it */
+    for(i = 0; i < vsc_count; i++)
+    {
+        entry = &vsc_ring[(vsc_head + i) % CY_SMARTCOEX_VSC_TRACK_MAX];
+        if(entry->ctx == ctx && !entry->link && entry->gen == vsc->gen && !entry->released)
+        {
+            if(!entry->wifi_done)
+            {
+                entry->wifi_done    = true;
+                entry->commit_start = start;
+            }
+            vsc->bt_pending = gen;
+            cy_rtos_set_mutex(&vsc_mutex);
+            return true;
+        }
+    }
+
+    /* No VSC outstanding; BT already runs this commit's payload unless the controller rejected the last one */
+    if(vsc->gen == 0 || vsc->failed_gen != vsc->gen)
+    {
+        vsc->bt_live = gen;
+        applied_us = timestamp_to_us(get_timestamp() - start);
+        vsc->last_applied_us = applied_us;
+    }
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    if(applied_us != 0)
+    {
+        SMARTCOEX_STATS_RECORD_US(ctx, APPLIED, applied_us);
+    }
+
+    return true;
+}
+
+cy_rslt_t cy_smartcoex_ctx_get_vsc_status(cy_smartcoex_ctx_t *ctx, cy_smartcoex_vsc_status_t *status)
+{
+    if(ctx == NULL || status == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    status->sent            = ctx->vsc.sent;
+    status->completed       = ctx->vsc.completed;
+    status->failed          = ctx->vsc.failed;
+    status->inflight        = ctx->vsc.inflight;
+    status->last_hci_status = ctx->vsc.last_hci_status;
+    status->last_rtt_us     = ctx->vsc.last_rtt_us;
+    status->last_applied_us = ctx->vsc.last_applied_us;
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_ctx_get_generation(cy_smartcoex_ctx_t *ctx, cy_smartcoex_generation_t *gen)
+{
+    if(ctx == NULL || gen == NULL)
+    {
+        return CY_RSLT_MW_BADARG;
+    }
+
+    cy_rtos_get_mutex(&vsc_mutex, CY_RTOS_NEVER_TIMEOUT);
+    gen->requested = ctx->vsc.requested;
+    gen->bt        = ctx->vsc.bt_live;
+    gen->wifi      = ctx->vsc.wifi_live;
+    cy_rtos_set_mutex(&vsc_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_smartcoex_get_vsc_status(cy_smartcoex_vsc_status_t *status)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return cy_smartcoex_ctx_get_vsc_status(ctx, status);
+}
+
+cy_rslt_t cy_smartcoex_get_generation(cy_smartcoex_generation_t *gen)
+{
+    cy_smartcoex_ctx_t *ctx = smartcoex_default_ctx();
+
+    if(ctx == NULL)
+    {
+        return CY_RSLT_MW_ERROR;
+    }
+
+    return cy_smartcoex_ctx_get_generation(ctx, gen);
+}
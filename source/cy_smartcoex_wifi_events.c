@@ -0,0 +1,202 @@
+/*
+ * Copyright 2021, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+
+/**
+* @file cy_smartcoex_wifi_events.c
+* @brief Wi-Fi connection event subscribers, shared by the ports.
+*/
+
+#include "cy_smartcoex_priv.h"
+#include "cy_smartcoex_log.h"
+#include "cy_result_mw.h"
+#include "cy_log.h"
+#include "cyabs_rtos.h"
+
+/**
+ * A subscriber slot. Slots are read and written in the port's critical section.
+ * Delivery copies the slot and calls the handler outside it, counting the call
+ * in busy, so that removal can wait for calls already in progress.
+ */
+typedef struct
+{
+    smartcoex_wifi_event_handler_t handler;
+    void                           *arg;
+    uint8_t                        busy;
+} smartcoex_wifi_subscriber_t;
+
+static smartcoex_wifi_subscriber_t wifi_subscriber[SMARTCOEX_WIFI_EVENT_HANDLERS];
+static uint8_t                     wifi_subscriber_count = 0;
+
+/* Serializes adding and removing, so the port's first and last hooks run in order */
+static cy_mutex_t                  wifi_subscriber_mutex;
+static smartcoex_once_t            wifi_subscriber_once;
+
+static cy_rslt_t wifi_subscriber_mutex_init(void *arg)
+{
+    (void)arg;
+    return cy_rtos_init_mutex(&wifi_subscriber_mutex);
+}
+
+/* Invokes the handler of slot i, if any, while holding off its removal */
+static void wifi_subscriber_deliver(uint8_t i, bool connected)
+{
+    smartcoex_wifi_event_handler_t handler;
+    void *arg;
+    uint32_t state;
+
+    state   = enter_critical_section();
+    handler = wifi_subscriber[i].handler;
+    arg     = wifi_subscriber[i].arg;
+    if(handler != NULL)
+    {
+        wifi_subscriber[i].busy++;
+    }
+    exit_critical_section(state);
+
+    if(handler == NULL)
+    {
+        return;
+    }
+
+    handler(connected, arg);
+
+    state = enter_critical_section();
+    wifi_subscriber[i].busy--;
+    exit_critical_section(state);
+}
+
+cy_rslt_t smartcoex_wifi_events_add(smartcoex_wifi_event_handler_t handler, void *arg, bool connected, cy_rslt_t (*first)(void))
+{
+    cy_rslt_t result;
+    uint32_t state;
+    uint8_t i;
+
+    result = smartcoex_once(&wifi_subscriber_once, wifi_subscriber_mutex_init, NULL);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    cy_rtos_get_mutex(&wifi_subscriber_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    /* Slots only change under the mutex, and an emptied slot is no longer busy */
+    for(i = 0; i < SMARTCOEX_WIFI_EVENT_HANDLERS && wifi_subscriber[i].handler != NULL; i++)
+    {
+    }
+    if(i == SMARTCOEX_WIFI_EVENT_HANDLERS)
+    {
+        cy_rtos_set_mutex(&wifi_subscriber_mutex);
+        cy_smartcoex_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Too many Wi-Fi event subscribers\n");
+        return CY_RSLT_MW_NOMEM;
+    }
+
+    if(wifi_subscriber_count == 0 && first != NULL)
+    {
+        result = first();
+        if(result != CY_RSLT_SUCCESS)
+        {
+            cy_rtos_set_mutex(&wifi_subscriber_mutex);
+            return result;
+        }
+    }
+
+    state = enter_critical_section();
+    wifi_subscriber[i].arg     = arg;
+    wifi_subscriber[i].handler = handler;
+    exit_critical_section(state);
+    wifi_subscriber_count++;
+
+    if(connected)
+    {
+        wifi_subscriber_deliver(i, true);
+    }
+
+    cy_rtos_set_mutex(&wifi_subscriber_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+void smartcoex_wifi_events_remove(smartcoex_wifi_event_handler_t handler, void *arg, void (*last)(void))
+{
+    uint32_t state;
+    uint8_t busy;
+    uint8_t i;
+
+    if(smartcoex_once(&wifi_subscriber_once, wifi_subscriber_mutex_init, NULL) != CY_RSLT_SUCCESS)
+    {
+        return;
+    }
+
+    cy_rtos_get_mutex(&wifi_subscriber_mutex, CY_RTOS_NEVER_TIMEOUT);
+    for(i = 0; i < SMARTCOEX_WIFI_EVENT_HANDLERS; i++)
+    {
+        if(wifi_subscriber[i].handler != handler || wifi_subscriber[i].arg != arg)
+        {
+            continue;
+        }
+
+        state = enter_critical_section();
+        wifi_subscriber[i].handler = NULL;
+        wifi_subscriber[i].arg     = NULL;
+        busy = wifi_subscriber[i].busy;
+        exit_critical_section(state);
+
+        /* A delivery that copied the slot before it was emptied may still be running */
+        while(busy != 0)
+        {
+            cy_rtos_delay_milliseconds(1);
+            state = enter_critical_section();
+            busy  = wifi_subscriber[i].busy;
+            exit_critical_section(state);
+        }
+
+        wifi_subscriber_count--;
+        if(wifi_subscriber_count == 0 && last != NULL)
+        {
+            last();
+        }
+        break;
+    }
+    cy_rtos_set_mutex(&wifi_subscriber_mutex);
+}
+
+void smartcoex_wifi_events_dispatch(bool connected)
+{
+    uint8_t i;
+
+    for(i = 0; i < SMARTCOEX_WIFI_EVENT_HANDLERS; i++)
+    {
+        wifi_subscriber_deliver(i, connected);
+    }
+}